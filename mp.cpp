@@ -1,1220 +1,1879 @@
-#include "mp.hpp"
-
-// MathParser static member initialization
-// Expected[Lexeme1][Lexeme2]=
-//    = true if Lexeme2 may follow Lexeme1,
-//    = false otherwise
-
-constexpr bool MathParser::Expected[8][8]=
-{
-    {false,
-#ifdef MATH_PARSER_EMPTY_STRING_ALLOWED            
-             true,
-#else //MATH_PARSER_EMPTY_STRING_ALLOWED
-            false,
-#endif //MATH_PARSER_EMPTY_STRING_ALLOWED
-                    true,  true,  true, false,  true, false},
-    {false, false, false, false, false, false, false, false},
-    {false,  true, false, false, false,  true, false,  true},
-    {false, false, false, false, false, false,  true, false},
-    {false, false,  true,  true, false, false,  true, false},
-    {false, false,  true,  true, false, false,  true, false},
-    {false, false,  true,  true,  true, false,  true, false},
-    {false,  true, false, false, false,  true, false,  true}
-};
-
-MathParser::MathParser(bool case_sensitive) :
-    input_strings{}, user_vars{}, Stack{}, lexer_buffer{},
-    case_sensitive{ case_sensitive }, compiled_code{}, runtime_mem{},
-    iCommandCounter{ 0 }, iMemoryCounter{ 0 }, pCompiledCode{ nullptr }
-{
-}
-
-MathParser::ErrorCodes MathParser::Parse(size_t& iErrorPosition, size_t iIndex)
-{
-    size_t iFirstSymbol{ 0 };
-
-    try
-    {
-        if (iIndex >= input_strings.size()) throw WrongIndex;
-
-        const auto (*const pString) { input_strings[iIndex].data() };
-        auto (*const pBuffer) { lexer_buffer.data() };
-        size_t iCurrentPosition{ 0 }, iBufferPosition{};
-        MathLexeme CurrentLexeme{ MathLexeme::Begin }, PreviousLexeme{};
-        long long int iParBalance{ 0 };
-
-        do
-            GetLexCheckSyntax(
-                ParseMode,
-                iFirstSymbol,
-                pString,
-                pBuffer,
-                iCurrentPosition,
-                iBufferPosition,
-                CurrentLexeme,
-                PreviousLexeme,
-                iParBalance,
-                nullptr);
-
-        while (CurrentLexeme.iType != MathLexeme::End);
-
-        // Check if there've been enough right parentheses
-
-        if (iParBalance > 0) throw ExpectedRightPar;
-
-        // syntax OK!
-
-        iErrorPosition = iCurrentPosition;
-        return OK;
-
-    }//try
-
-    catch (const MathParser::ErrorCodes& iCaught)
-    {
-        iErrorPosition = iFirstSymbol;
-        return iCaught;
-    }
-}
-
-MathParser::ErrorCodes MathParser::Evaluate(
-    size_t& iErrorPosition, const vector<double>& args,
-	double& dValue, size_t iIndex)
-{
-    size_t iFirstSymbol{ 0 };
-
-    try
-    {
-        if (iIndex >= input_strings.size()) throw WrongIndex;
-    
-        const auto (*const pString) { input_strings[iIndex].data() };
-        auto (*const pBuffer) { lexer_buffer.data() };
-        size_t iCurrentPosition{ 0 }, iBufferPosition{};
-        MathLexeme CurrentLexeme{ MathLexeme::Begin }, PreviousLexeme{};
-        long long int iParBalance{ 0 };
-        const double* rgdArguments{ args.data() };
-
-        Stack.Push (CurrentLexeme);
-
-        do
-        {
-            GetLexCheckSyntax(
-                EvaluateMode,
-                iFirstSymbol,
-                pString,
-                pBuffer,
-                iCurrentPosition,
-                iBufferPosition,
-                CurrentLexeme,
-                PreviousLexeme,
-                iParBalance,
-                rgdArguments);
-
-	        // Check if there've been enough right parentheses
-
-			if (CurrentLexeme.iType == MathLexeme::End)
-				if (iParBalance > 0) throw ExpectedRightPar;
-
-            // Now evaluate
-
-            switch (CurrentLexeme.iType)
-            {
-            case MathLexeme::Number:
-            case MathLexeme::LeftPar:
-            case MathLexeme::Function:
-                Stack.Push(CurrentLexeme);
-                break;
-
-            case MathLexeme::Binary:
-            {
-                bool fMore{ true };
-
-                do
-                {
-                    const auto SecondFromTop = Stack.SecondFromTop();
-
-                    switch (SecondFromTop.iType)
-                    {
-                    case MathLexeme::Begin:
-                    case MathLexeme::LeftPar:
-                        fMore = false;
-                        break;
-
-                    default:
-                    // case MathLexeme::Binary:
-                        if (MathLexeme::IsPriorityHigher
-                            [SecondFromTop.iItem]
-                            [CurrentLexeme.iItem]) 
-                            {
-                                iFirstSymbol = Stack.SecondFromTop().iPosition;
-                                EvaluateBinaryOp();
-                            }
-                        else fMore = false;
-
-                    } // switch
-
-                } while (fMore);
-
-                Stack.Push(CurrentLexeme);
-
-            } // case
-
-            break;
-
-            case MathLexeme::RightPar:
-            {
-                while (Stack.SecondFromTop().iType == MathLexeme::Binary)
-                {
-                    iFirstSymbol = Stack.SecondFromTop().iPosition;
-                    EvaluateBinaryOp();
-                }
-
-                MathLexeme Tmp;
-                Stack.Pop(Tmp);
-                Stack.Pop(); // remove '('
-
-                if (Stack.Top().iType == MathLexeme::Function)
-                {
-                    Tmp.dValue = Stack.Top().pFunction(Tmp.dValue);
-                    
-                    iFirstSymbol = Stack.Top().iPosition;
-
-                    CheckForFloatingPointError(Tmp.dValue);
-
-                    Stack.Pop(); // remove function
-                }
-                Stack.Push(Tmp);
-            }
-            break;
-
-            case MathLexeme::End:
-                while (Stack.SecondFromTop().iType == MathLexeme::Binary)
-                {
-                    iFirstSymbol = Stack.SecondFromTop().iPosition;
-                    EvaluateBinaryOp();
-                }
-            break;
-
-            default:
-            // case MathLexeme::Unary:
-                if (CurrentLexeme.iItem == MathLexeme::Minus)
-                {
-                    Stack.Push(MathLexeme(MathLexeme::Number, MathLexeme::Constant, 0.0));
-                    Stack.Push(MathLexeme(MathLexeme::Binary, MathLexeme::Minus));
-                }
-
-            } // switch
-
-        } // do
-        while (CurrentLexeme.iType != MathLexeme::End);
-
-	    // syntax OK!
-        iErrorPosition = iCurrentPosition;
-        dValue = Stack.Top().dValue;
-        Stack.Reset();
-        return OK;
-
-    }//try
-
-    catch (const MathParser::ErrorCodes& iCaught)
-    {
-        iErrorPosition = iFirstSymbol;
-        Stack.Reset();
-        return iCaught;
-    }
-}
-
-MathParser::ErrorCodes MathParser::Compile(size_t& iErrorPosition, size_t iIndex)
-{
-    size_t iFirstSymbol{ 0 };
-
-    try
-    {
-        if (iIndex >= input_strings.size()) throw WrongIndex;
-
-        const auto (*const pString) { input_strings[iIndex].data() };
-        auto (*const pBuffer) { lexer_buffer.data() };
-        size_t iCurrentPosition{ 0 }, iBufferPosition{};
-        MathLexeme CurrentLexeme{ MathLexeme::Begin }, PreviousLexeme{};
-        long long int iParBalance{ 0 };
-
-        pCompiledCode = compiled_code[iIndex].data();
-		iCommandCounter = 0; // will count commands produced by compiler
-
-		// Will count runtime memory used for storage of intermediate values.
-		// Values of user variables passed as arguments will be stored in the beginning.
-		// Memory won't be reused.
-		iMemoryCounter = NumberOfVars();
-
-        Stack.Push(CurrentLexeme);
-
-        do
-        {
-            GetLexCheckSyntax(
-                CompileMode,
-                iFirstSymbol,
-                pString,
-                pBuffer,
-                iCurrentPosition,
-                iBufferPosition,
-                CurrentLexeme,
-                PreviousLexeme,
-                iParBalance,
-                nullptr);
-
-			// Check if there've been enough right parentheses
-			
-            if (CurrentLexeme.iType == MathLexeme::End)
-				if (iParBalance > 0) throw ExpectedRightPar;
-
-            // Now compile
-
-            switch (CurrentLexeme.iType)
-            {
-            case MathLexeme::Number:
-            case MathLexeme::LeftPar:
-            case MathLexeme::Function:
-                Stack.Push(CurrentLexeme);
-            break;
-
-            case MathLexeme::Binary:
-            {
-                bool fMore{ true };
-
-                do // unwind stack
-                {
-                    const auto SecondFromTop = Stack.SecondFromTop();
-
-                    switch (SecondFromTop.iType)
-                    {
-                    case MathLexeme::Begin:
-                    case MathLexeme::LeftPar:
-                        fMore = false;
-                    break;
-
-                    default:
-                    // case MathLexeme::Binary:
-                        if (MathLexeme::IsPriorityHigher
-                            [SecondFromTop.iItem]
-                            [CurrentLexeme.iItem])
-                            {
-                                iFirstSymbol = Stack.SecondFromTop().iPosition;
-                                CompileBinaryOp();
-                            }
-                        else fMore = false;
-
-                    } // switch
-
-                } while (fMore);
-
-                Stack.Push(CurrentLexeme);
-
-            } // case MathLexeme::Binary
-
-            break;
-
-            case MathLexeme::RightPar:
-            {
-                while (Stack.SecondFromTop().iType == MathLexeme::Binary)
-                {
-                    iFirstSymbol = Stack.SecondFromTop().iPosition;
-                    CompileBinaryOp();
-                }
-
-                MathLexeme Tmp;
-                Stack.Pop(Tmp);
-                Stack.Pop(); // remove '('
-                
-                if (Stack.Top().iType == MathLexeme::Function)
-                {
-                    if (Tmp.iItem == MathLexeme::Constant)
-                    {
-                        // argument of the function is known, no need to compile
-
-                        Tmp.dValue = Stack.Top().pFunction(Tmp.dValue);
-
-                        iFirstSymbol = Stack.Top().iPosition;
-
-                        CheckForFloatingPointError(Tmp.dValue);
-                    }
-                    else
-                    {
-                        // argument of the function not known
-
-                        pCompiledCode[iCommandCounter++].
-                            CompiledCommand::CompiledCommand(Tmp.iRunTimeIndex, iMemoryCounter,
-                                Stack.Top().pFunction, Stack.Top().iPosition);
-
-                        Tmp.iRunTimeIndex = iMemoryCounter++;
-                    }
-					Stack.Pop(); // remove function
-                }
-                Stack.Push(Tmp);
-            } //case MathLexeme::RightPar:
-
-            break;
-
-            case MathLexeme::End:
-                while (Stack.SecondFromTop().iType == MathLexeme::Binary)
-                {
-                    iFirstSymbol = Stack.SecondFromTop().iPosition;
-                    CompileBinaryOp();
-                }
-            break;
-
-            default:
-            // case MathLexeme::Unary:
-                if (CurrentLexeme.iItem == MathLexeme::Minus)
-                {
-                    Stack.Push(MathLexeme(MathLexeme::Number, MathLexeme::Constant, 0.0));
-                    Stack.Push(MathLexeme(MathLexeme::Binary, MathLexeme::Minus));
-                }
-
-            } // switch
-        
-        } // do
-        while (CurrentLexeme.iType != MathLexeme::End);
-
-        // syntax OK!
-        iErrorPosition = iCurrentPosition;
-
-        if (Stack.Top().iItem == MathLexeme::Constant)
-            pCompiledCode[iCommandCounter++].
-                CompiledCommand::CompiledCommand(Stack.Top().dValue);
-        else
-            pCompiledCode[iCommandCounter++].
-                CompiledCommand::CompiledCommand(Stack.Top().iRunTimeIndex);
-
-        Stack.Reset();
-        return OK;
-
-    }//try
-
-    catch (const MathParser::ErrorCodes& iCaught)
-    {
-        iErrorPosition = iFirstSymbol;
-        Stack.Reset();
-        InvalidateCompiledCode(iIndex);
-        return iCaught;
-    }
-}
-
-MathParser::ErrorCodes MathParser::Execute(
-    size_t& iErrorPosition, const vector<double>& args, double& dValue, size_t iIndex)
-{
-    auto (*pCmdPtr) { compiled_code[iIndex].data() };
-    auto (*const pMemPtr) { runtime_mem.data() };
-    memcpy(pMemPtr, args.data(), sizeof(double) * NumberOfVars());
-
-loop:
-
-    if (pCmdPtr->fFlag1)
-    {
-        // mem+const or const+mem
-
-        auto iBinaryOp{ pCmdPtr->iBinaryOp };
-
-        if (pCmdPtr->fFlag2)
-        {
-            // mem+const
-
-            switch (iBinaryOp)
-            {
-            case MathLexeme::Plus:
-                pMemPtr[pCmdPtr->iResult] = pMemPtr[pCmdPtr->iFirstOperand] + pCmdPtr->dValue;
-                break;
-            case MathLexeme::Minus:
-                pMemPtr[pCmdPtr->iResult] = pMemPtr[pCmdPtr->iFirstOperand] - pCmdPtr->dValue;
-                break;
-            case MathLexeme::Multiply:
-                pMemPtr[pCmdPtr->iResult] = pMemPtr[pCmdPtr->iFirstOperand] * pCmdPtr->dValue;
-                break;
-            case MathLexeme::Divide:
-                pMemPtr[pCmdPtr->iResult] = pMemPtr[pCmdPtr->iFirstOperand] / pCmdPtr->dValue;
-                break;
-            default:
-                //case MathLexeme::Power:
-                pMemPtr[pCmdPtr->iResult] =
-                    pow(pMemPtr[pCmdPtr->iFirstOperand], pCmdPtr->dValue);
-            }
-        }
-        else // fFlag2
-        {
-            // const+mem
-
-            switch (iBinaryOp)
-            {
-            case MathLexeme::Plus:
-                pMemPtr[pCmdPtr->iResult] = pCmdPtr->dValue + pMemPtr[pCmdPtr->iSecondOperand];
-                break;
-            case MathLexeme::Minus:
-                pMemPtr[pCmdPtr->iResult] = pCmdPtr->dValue - pMemPtr[pCmdPtr->iSecondOperand];
-                break;
-            case MathLexeme::Multiply:
-                pMemPtr[pCmdPtr->iResult] = pCmdPtr->dValue * pMemPtr[pCmdPtr->iSecondOperand];
-                break;
-            case MathLexeme::Divide:
-                pMemPtr[pCmdPtr->iResult] = pCmdPtr->dValue / pMemPtr[pCmdPtr->iSecondOperand];
-                break;
-            default:
-                //case MathLexeme::Power:
-                pMemPtr[pCmdPtr->iResult] =
-                    pow(pCmdPtr->dValue, pMemPtr[pCmdPtr->iSecondOperand]);
-            }
-        }
-    }
-    else // fFlag1
-    {
-        if (pCmdPtr->fFlag2)
-        {
-            // mem+mem
-
-            auto iBinaryOp{ pCmdPtr->iBinaryOp };
-            switch (iBinaryOp)
-            {
-            case MathLexeme::Plus:
-                pMemPtr[pCmdPtr->iResult] =
-                    pMemPtr[pCmdPtr->iFirstOperand] + pMemPtr[pCmdPtr->iSecondOperand];
-                break;
-            case MathLexeme::Minus:
-                pMemPtr[pCmdPtr->iResult] =
-                    pMemPtr[pCmdPtr->iFirstOperand] - pMemPtr[pCmdPtr->iSecondOperand];
-                break;
-            case MathLexeme::Multiply:
-                pMemPtr[pCmdPtr->iResult] =
-                    pMemPtr[pCmdPtr->iFirstOperand] * pMemPtr[pCmdPtr->iSecondOperand];
-                break;
-            case MathLexeme::Divide:
-                pMemPtr[pCmdPtr->iResult] =
-                    pMemPtr[pCmdPtr->iFirstOperand] / pMemPtr[pCmdPtr->iSecondOperand];
-                break;
-            default:
-                //case MathLexeme::Power:
-                pMemPtr[pCmdPtr->iResult] =
-                    pow(pMemPtr[pCmdPtr->iFirstOperand], pMemPtr[pCmdPtr->iSecondOperand]);
-            }
-        }
-        else // fFlag2
-        {
-            if (pCmdPtr->fFlag3)
-            {
-                // function call
-                pMemPtr[pCmdPtr->iResult] =
-                    pCmdPtr->pFunction(pMemPtr[pCmdPtr->iFirstOperand]);
-            }
-            else // fFlag3
-            {
-                // termination
-
-                if (pCmdPtr->fResultInMemory)
-                {
-                    dValue = pMemPtr[pCmdPtr->iFirstOperand];
-                    return OK;
-                }
-                else
-                {
-                    dValue = pCmdPtr->dValue;
-                    return OK;
-                }
-            }
-        }
-    }
-
-#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
-
-    if (!isfinite(pMemPtr[pCmdPtr->iResult]))
-    {
-        iErrorPosition = pCmdPtr->iErrorPosition;
-
-        if (isnan(pMemPtr[pCmdPtr->iResult]))
-            return FloatingPointErrorNaN;
-        else
-            if (pMemPtr[pCmdPtr->iResult] > 0)
-                return FloatingPointErrorPosInf;
-            else
-                return FloatingPointErrorNegInf;
-    }
-
-#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
-
-    ++pCmdPtr;
-    goto loop;
-}
-
-void MathParser::InsertString(
-    wstring&& wstr, size_t requested_index, size_t& assigned_index)
-{
-    if (requested_index >= input_strings.size()) requested_index = input_strings.size();
-    assigned_index = requested_index;
-
-    const auto str_len = wstr.size();
-
-    input_strings.insert(input_strings.begin() + requested_index, move(wstr));
-
-    // allocate memory for lexer
-    // the buffer is created, and allocates initial memory, when InsertString is called
-    // for the first time.
-
-    constexpr size_t min_buf_len = 128; // 1 == test value, to be increased
-    size_t required_buf_len{ str_len + 1 };
-
-    if (required_buf_len < min_buf_len) required_buf_len = min_buf_len;
-
-    if (lexer_buffer.size() < required_buf_len)
-    {
-        constexpr size_t buf_len_extra{ 128 }; // 0 == test value, to be increased
-        const auto current_buf_len = required_buf_len + buf_len_extra;
-
-        lexer_buffer.resize(current_buf_len);
-    }
-
-    // the stack is created when InsertString is called for the first time
-    // + adjust stack size when necessary
-
-    auto required_stack_size = str_len + 2; // was 2*iNewStringLength + 2
-
-    if (Stack.iCurrentStackSize < required_stack_size)
-    {
-        constexpr size_t stack_size_extra{ 128 }; // 0 == test value, to be increased
-        required_stack_size += stack_size_extra;
-
-        Stack.Resize(required_stack_size);
-    }
-
-    // allocate memory for compiled code
-
-    compiled_code.insert(
-        compiled_code.begin() + requested_index,
-        vector<CompiledCommand>(str_len + 2)
-    );
-
-    InvalidateCompiledCode(assigned_index);
-
-    // allocate/adjust memory for run-time data (arguments and intermediate storage)
-
-    AdjustRunTimeMem();
-}
-
-void MathParser::RemoveString(size_t iIndex)
-{
-    input_strings.erase(input_strings.begin() + iIndex);
-    compiled_code.erase(compiled_code.begin() + iIndex);
-}
-
-size_t MathParser::TrimVarName(wstring& wstr)
-{
-    auto str_len{ wstr.size() };
-    size_t it{ 0 };
-
-    for (; it < str_len; ++it)
-        if (wstr[it] != ' ' && wstr[it] != '\t')
-            break;
-
-    if (it > 0)
-    {
-        wstr.erase(0, it);
-        str_len = wstr.size();
-    }
-
-    if (str_len > 0)
-    {
-        it = str_len - 1;
-
-        while (wstr[it] == ' ' || wstr[it] == '\t') --it;
-
-        if (it < str_len - 1)
-        {
-            wstr.erase(it + 1);
-            str_len = wstr.size();
-        }
-    }
-    return str_len;
-}
-
-MathParser::ErrorCodes MathParser::CheckVar(const wstring& wstr) const
-{
-    // check if wstr is a valid ID
-    if (!IsVarNameValid(wstr)) return InvalidIdentifier;
-
-    // check if in use
-    if (VarNameInUse(wstr.data())) return IdentifierInUse;
-
-    return OK;
-}
-
-MathParser::ErrorCodes MathParser::CheckAndInsertVar(
-    wstring&& wstr, size_t requested_index, size_t& assigned_index)
-{
-    const auto err_code{ CheckVar(wstr) };
-
-    if (err_code != OK) return err_code;
-
-    if (requested_index >= user_vars.size())
-        requested_index = user_vars.size();
-
-    assigned_index = requested_index;
-
-    user_vars.insert(user_vars.begin() + requested_index, move(wstr));
-
-    AdjustRunTimeMem();
-
-    return OK;
-}
-
-void MathParser::RemoveVar(size_t iIndex)
-{
-    user_vars.erase(user_vars.begin() + iIndex);
-}
-
-void MathParser::RemoveAllVars()
-{
-    user_vars.clear();
-}
-
-bool MathParser::OKtoExecute(size_t iIndex) const
-{
-    if (iIndex >= compiled_code.size()) return false;
-
-    const auto code = compiled_code[iIndex].data();
-
-    if (code == nullptr) return false; // never happens?
-
-    // check for error token
-    return !code->fFlag1 || !code->fFlag3;
-}
-
-bool MathParser::IsCaseSensitive() const { return case_sensitive; }
-
-void MathParser::SetCaseSensitive(bool case_sensitive)
-{
-    this->case_sensitive = case_sensitive;
-}
-
-bool MathParser::FunctionExists(const wchar_t* name, size_t* index) const
-{
-    for (size_t it = 0; it < MathLexeme::MathLexNumberOfFunctions; ++it)
-        if (MathLexeme::IsFunctionAllowed[it])
-            if (mp_str_cmp(name, MathLexeme::FunctionID[it]) == 0)
-            {
-                if (index != nullptr) *index = it;
-                return true;
-            }
-
-    return false;
-}
-
-bool MathParser::ConstantExists(const wchar_t* name, size_t* index) const
-{
-    for (size_t it = 0; it < MathLexeme::MathLexNumberOfConstants; ++it)
-        if (MathLexeme::IsConstantAllowed[it])
-            if (mp_str_cmp(name, MathLexeme::ConstantID[it]) == 0)
-            {
-                if (index != nullptr) *index = it;
-                return true;
-            }
-
-    return false;
-}
-
-bool MathParser::VariableExists(const wchar_t* name, size_t* index) const
-{
-    for (size_t it = 0; it < user_vars.size(); ++it)
-        if (mp_str_cmp(name, user_vars[it].data()) == 0)
-        {
-            if (index != nullptr) *index = it;
-            return true;
-        }
-
-    return false;
-}
-
-bool MathParser::VarNameInUse(const wchar_t* name) const
-{
-    return FunctionExists(name) || ConstantExists(name) || VariableExists(name);
-}
-
-bool MathParser::IsVarNameValid(const wstring& wstr)
-{
-    const auto str_len{ wstr.size() };
-
-    if (str_len == 0) return false;
-
-    if (!IsFirstChar(wstr[0]))
-        return false;
-    else
-        for (size_t it = 1; it < str_len; ++it)
-            if (!IsNextChar(wstr[it]))
-                return false;
-
-    return true;
-}
-
-void MathParser::EvaluateBinaryOp()
-{
-    MathLexeme Op1{}, Op2{}, Sign{};
-    Stack.Pop(Op2);
-    Stack.Pop(Sign);
-    Stack.Pop(Op1);
-
-    switch (Sign.iItem)
-    {
-    case MathLexeme::Plus:
-        Op1.dValue += Op2.dValue;
-        break;
-
-    case MathLexeme::Minus:
-        Op1.dValue -= Op2.dValue;
-        break;
-
-    case MathLexeme::Multiply:
-        Op1.dValue *= Op2.dValue;
-        break;
-
-    case MathLexeme::Divide:
-        Op1.dValue /= Op2.dValue;
-        break;
-
-    default:
-        // case MathLexeme :: Power
-        Op1.dValue = pow(Op1.dValue, Op2.dValue);
-        break;
-    }
-
-    CheckForFloatingPointError(Op1.dValue);
-
-    Stack.Push(Op1);
-}
-
-void MathParser::CheckForFloatingPointError(double value)
-{
-#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
-
-    if (!isfinite(value))
-        if (isnan(value))
-            throw FloatingPointErrorNaN;
-        else
-            if (value > 0)
-                throw FloatingPointErrorPosInf;
-            else
-                throw FloatingPointErrorNegInf;
-
-#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
-}
-
-void MathParser::GetLexCheckSyntax(
-    MathParser::LexerMode LexerMode,
-    size_t& iFirstSymbol,
-    const wchar_t* pString,
-    wchar_t* pBuffer,
-    size_t& iCurrentPosition,
-    size_t& iBufferPosition,
-    MathLexeme& CurrentLexeme,
-    MathLexeme& PreviousLexeme,
-    long long int& iParBalance,
-    const double* rgdArguments
-)
-{
-    PreviousLexeme = CurrentLexeme;
-
-    // skip blanks
-
-    size_t iFirstSpace = iCurrentPosition;
-    while (pString[iCurrentPosition] == ' ' ||
-        pString[iCurrentPosition] == '\t') ++iCurrentPosition;
-
-    iFirstSymbol = iCurrentPosition;
-    wchar_t cCurrentChar(pString[iCurrentPosition]);
-
-    switch (cCurrentChar)
-    {
-
-    // end of line
-
-    case '\0':
-        CurrentLexeme.iType = MathLexeme::End;
-        iFirstSymbol = iFirstSpace;
-        //--iCurrentPosition;
-
-        if (LexerMode != ParseMode)
-            if (PreviousLexeme.iType == MathLexeme::Begin)
-                Stack.Push(MathLexeme(MathLexeme::Number, MathLexeme::Constant, 0.0));
-        break;
-
-    // signs (assume now they are all binary; check for unary later)
-
-    case '+':
-        CurrentLexeme.iType = MathLexeme::Binary;
-        CurrentLexeme.iItem = MathLexeme::Plus;
-        CurrentLexeme.iPosition = iFirstSymbol;
-        break;
-
-    case '-':
-        CurrentLexeme.iType = MathLexeme::Binary;
-        CurrentLexeme.iItem = MathLexeme::Minus;
-        CurrentLexeme.iPosition = iFirstSymbol;
-        break;
-
-    case '*':
-        CurrentLexeme.iType = MathLexeme::Binary;
-        CurrentLexeme.iItem = MathLexeme::Multiply;
-        CurrentLexeme.iPosition = iFirstSymbol;
-
-#ifdef MATH_PARSER_DOUBLE_ASTERISK_ALLOWED
-
-        if (pString[++iCurrentPosition] == '*')
-            CurrentLexeme.iItem = MathLexeme::Power;
-        else --iCurrentPosition;
-
-#endif //MATH_PARSER_DOUBLE_ASTERISK_ALLOWED
-
-        break;
-
-    case '/':
-
-#ifdef MATH_PARSER_COLON_ALLOWED
-
-    case ':':
-
-#endif //MATH_PARSER_COLON_ALLOWED
-
-        CurrentLexeme.iType = MathLexeme::Binary;
-        CurrentLexeme.iItem = MathLexeme::Divide;
-        CurrentLexeme.iPosition = iFirstSymbol;
-        break;
-
-    case '^':
-        CurrentLexeme.iType = MathLexeme::Binary;
-        CurrentLexeme.iItem = MathLexeme::Power;
-        CurrentLexeme.iPosition = iFirstSymbol;
-        break;
-
-    // parentheses
-
-    case '(':
-        CurrentLexeme.iType = MathLexeme::LeftPar;
-        ++iParBalance;
-        break;
-
-    case ')':
-        // check balance
-        if (iParBalance <= 0) throw ExtraRightPar;
-
-        CurrentLexeme.iType = MathLexeme::RightPar;
-        --iParBalance;
-        break;
-
-    // possibly number, variable or function
-
-    default:
-        if (cCurrentChar == '0' ||
-            (cCurrentChar >= '1' && cCurrentChar <= '9') ||
-            cCurrentChar == '.')
-        {
-            // possibly number
-            iBufferPosition = 0;
-
-            auto fExpFound{ false }, fPointFound{ false }, fSignFound{ false };
-            for ( ; ; )
-            {
-                cCurrentChar = pString[iCurrentPosition];
-
-                if ((cCurrentChar >= '1' && cCurrentChar <= '9') || cCurrentChar == '0')
-                    pBuffer[iBufferPosition++] = pString[iCurrentPosition++];
-                else
-                    if (cCurrentChar == 'e' || cCurrentChar == 'E')
-                    {
-                        if (fExpFound)
-                        {
-                            --iCurrentPosition;
-                            break;
-                        }
-                        else
-                        {
-                            pBuffer[iBufferPosition++] = pString[iCurrentPosition++];
-                            fExpFound = true;
-                        }
-                    }
-                    else
-                        if (cCurrentChar == '.')
-                        {
-                            if (fPointFound)
-                            {
-                                --iCurrentPosition;
-                                break;
-                            }
-                            else
-                            {
-                                pBuffer[iBufferPosition++] = pString[iCurrentPosition++];
-                                fPointFound = true;
-                            }
-                        }
-                        else
-                            if (cCurrentChar == '+' || cCurrentChar == '-')
-                            {
-
-                                // check whether +/- belongs to the exponent or next lexeme
-
-                                if (pString[iCurrentPosition - 1] == 'e' ||
-                                    pString[iCurrentPosition - 1] == 'E')
-                                {
-                                    if (fSignFound)
-                                    {
-                                        --iCurrentPosition;
-                                        break;
-                                    }
-                                    else
-                                    {
-                                        pBuffer[iBufferPosition++] = pString[iCurrentPosition++];
-                                        fSignFound = true;
-                                    }
-                                }
-                                else
-                                {
-                                    --iCurrentPosition;
-                                    break;
-                                }
-                            }
-                            else
-                            {
-                                --iCurrentPosition;
-                                break;
-                            }
-
-            } // for
-
-            // possibly got a number in pBuffer, check it
-
-            pBuffer[iBufferPosition] = '\0';
-            if (swscanf_s(pBuffer, L"%lf", &CurrentLexeme.dValue) == 1)
-            {
-                CurrentLexeme.iType = MathLexeme::Number;
-                CurrentLexeme.iItem = MathLexeme::Constant;
-                CurrentLexeme.iPosition = iFirstSymbol;//is this needed? - can be inf/NaN
-                // check here for inf/nan and throw floating point error
-
-                if (LexerMode != ParseMode)
-                    CheckForFloatingPointError(CurrentLexeme.dValue);
-            }
-            else throw MathParser::InvalidNumber;
-
-        } // if
-
-        else // not a number, possibly function, constant or variable
-
-            if (IsFirstChar(cCurrentChar))
-            {
-                iBufferPosition = 0;
-
-                for (; ; )
-                {
-                    cCurrentChar = pString[iCurrentPosition];
-
-                    if (IsNextChar(cCurrentChar))
-                        pBuffer[iBufferPosition++] = pString[iCurrentPosition++];
-                    else
-                    {
-                        --iCurrentPosition;
-                        break;
-                    }
-
-                } // for
-
-                // check for matching names (functions, constants, variables)
-
-                pBuffer[iBufferPosition] = '\0';
-                size_t iIndex{ 0 };
-
-                if (FunctionExists(pBuffer, &iIndex)) // check for matching functions
-                {
-                    CurrentLexeme.iType = MathLexeme::Function;
-                    CurrentLexeme.pFunction = MathLexeme::FunctionAddress[iIndex];
-                    CurrentLexeme.iPosition = iFirstSymbol; // is this needed?
-                }
-                else // no function matches, check for built-in constants
-                    if (ConstantExists(pBuffer, &iIndex))
-                    {
-                        CurrentLexeme.iType = MathLexeme::Number;
-                        CurrentLexeme.iItem = MathLexeme::Constant;
-                        CurrentLexeme.dValue = MathLexeme::ConstantValue[iIndex];
-                    }
-                    else // no constant matches, check for user-defined variables (no check for Parse)
-                        if (LexerMode == ParseMode || VariableExists(pBuffer, &iIndex))
-                        {
-                            CurrentLexeme.iType = MathLexeme::Number;
-                            CurrentLexeme.iItem = MathLexeme::Variable;
-                            CurrentLexeme.iRunTimeIndex = iIndex;
-
-                            if (LexerMode == EvaluateMode)
-                                CurrentLexeme.dValue = rgdArguments[iIndex];
-                        }
-                        else throw UnknownIdentifier; // no matches
-
-            } // if IsFirstChar
-
-            else // invalid character
-                throw InvalidCharacter;
-
-    } // switch (cCurrentChar)
-
-    ++iCurrentPosition;
-
-    // got a lexeme, now check syntax
-
-    // Check if a binary sign is actually unary
-
-    if (CurrentLexeme.iType == MathLexeme::Binary)
-        if (CurrentLexeme.iItem == MathLexeme::Plus ||
-            CurrentLexeme.iItem == MathLexeme::Minus)
-            if (Expected[PreviousLexeme.iType][MathLexeme::Unary])
-                CurrentLexeme.iType = MathLexeme::Unary;
-
-    // Check syntax
-
-    if (!Expected[PreviousLexeme.iType][CurrentLexeme.iType])
-        switch (PreviousLexeme.iType)
-        {
-        case MathLexeme::Begin:
-
-#ifndef MATH_PARSER_EMPTY_STRING_ALLOWED
-
-            if (CurrentLexeme.iType == MathLexeme::End)
-                throw EmptyString;
-            else
-
-#endif //MATH_PARSER_EMPTY_STRING_ALLOWED
-
-                throw ExpectedRealFunUnSignLeftPar;
-
-        case MathLexeme::LeftPar:
-            throw ExpectedRealFunUnSignLeftPar;
-
-        case MathLexeme::Unary:
-        case MathLexeme::Binary:
-            throw ExpectedRealFunLeftPar;
-
-        case MathLexeme::Number:
-        case MathLexeme::RightPar:
-            if (CurrentLexeme.iType == MathLexeme::LeftPar)
-                throw iParBalance > 1 ? ExpectedBiSignRightPar : ExpectedBiSign;
-            else
-                throw iParBalance > 0 ? ExpectedBiSignRightPar : ExpectedBiSign;
-
-        default:
-            // case MathLexeme::Function:
-            throw ExpectedLeftPar;
-        }
-}
-
-// Check and increase if necessary the runtime memory used by Execute
-// based off the longest string and the number of user variables
-//
-void MathParser::AdjustRunTimeMem()
-{
-    constexpr size_t min_runtime_mem{ 128 }; // 1 == test value, to be increased
-    auto required_runtime_mem{ min_runtime_mem };
-
-    for (size_t ind = 0; ind < NumberOfStrings(); ++ind)
-    {
-        const auto str_len = input_strings[ind].size() + 1;
-        if (required_runtime_mem < str_len) required_runtime_mem = str_len;
-    }
-
-    required_runtime_mem += NumberOfVars();
-
-    if (runtime_mem.size() < required_runtime_mem)
-    {
-        constexpr size_t runtime_mem_extra{ 128 }; // 0 == test value, to be increased
-        const auto current_runtime_mem = required_runtime_mem + runtime_mem_extra;
-
-        runtime_mem.resize(current_runtime_mem);
-    }
-}
-
-void MathParser::CompileBinaryOp()
-{
-    MathLexeme Op1{}, Op2{}, Sign{};
-    Stack.Pop(Op2);
-    Stack.Pop(Sign);
-    Stack.Pop(Op1);
-
-    if (Op1.iItem == MathLexeme::Constant)
-    {
-        if (Op2.iItem == MathLexeme::Constant)
-        {
-            // both operands' values are known at the time of compilation,
-            // therefore just evaluate the operation, nothing to compile
-
-            switch (Sign.iItem)
-            {
-            case MathLexeme::Plus:
-                Op1.dValue += Op2.dValue;
-                break;
-
-            case MathLexeme::Minus:
-                Op1.dValue -= Op2.dValue;
-                break;
-
-            case MathLexeme::Multiply:
-                Op1.dValue *= Op2.dValue;
-                break;
-
-            case MathLexeme::Divide:
-                Op1.dValue /= Op2.dValue;
-                break;
-
-            default:
-                // case MathLexeme::Power
-                Op1.dValue = pow(Op1.dValue, Op2.dValue);
-            }
-
-            CheckForFloatingPointError(Op1.dValue);
-
-            Stack.Push(Op1);
-
-        } // if both are constants
-        else
-        {
-            // Op2's value is not known now
-            // produce const+mem operation
-
-            pCompiledCode[iCommandCounter++].
-                CompiledCommand::CompiledCommand(Op1.dValue, Op2.iRunTimeIndex,
-                    iMemoryCounter, Sign.iItem, Sign.iPosition);
-
-            Op2.iRunTimeIndex = iMemoryCounter++;
-            Stack.Push(Op2);
-        }
-    }
-    else
-    {
-        if (Op2.iItem == MathLexeme::Constant)
-        {
-            // Op1's value is not known now
-            // produce mem+const operation
-
-            pCompiledCode[iCommandCounter++].
-                CompiledCommand::CompiledCommand(Op1.iRunTimeIndex, Op2.dValue,
-                    iMemoryCounter, Sign.iItem, Sign.iPosition);
-
-            Op1.iRunTimeIndex = iMemoryCounter++;
-            Stack.Push(Op1);
-        }
-        else
-        {
-            // neither value is known
-            // produce mem+mem operation
-
-            pCompiledCode[iCommandCounter++].
-                CompiledCommand::CompiledCommand(Op1.iRunTimeIndex, Op2.iRunTimeIndex,
-                    iMemoryCounter, Sign.iItem, Sign.iPosition);
-
-            Op1.iRunTimeIndex = iMemoryCounter++;
-            Stack.Push(Op1);
-        }
-    }
-}
-
-void MathParser::InvalidateCompiledCode(size_t ind)
-{
-    compiled_code[ind].data()->CompiledCommand::CompiledCommand(bool{});
+#include <cstring>
+#include "mp.hpp"
+#include "mp_number.hpp"
+#include "mp_simd.hpp"
+
+namespace {
+
+    // what an unbound variable reads (see BindVar)
+    constexpr double unbound_value{ 0.0 };
+}
+
+MathParser::MathParser(bool case_sensitive) :
+    input_strings{}, user_vars{}, var_index{}, var_ranges{}, var_bindings{}, iMaxStringLength{ 0 }, default_context{},
+    case_sensitive{ case_sensitive }, fast_math{ false }, compiled_code{}, fused_code{},
+    iMemoryCounter{ 0 }, pCompiledProgram{ nullptr }
+{
+}
+
+MathParser::ErrorCodes MathParser::Parse(
+    ExecutionContext& Context, size_t& iErrorPosition, size_t iIndex) const
+{
+    size_t iFirstSymbol{ 0 };
+
+    try
+    {
+        if (iIndex >= input_strings.size()) throw WrongIndex;
+
+        AdjustContext(Context);
+
+        const auto (*const pString) { input_strings[iIndex].data() };
+        size_t iCurrentPosition{ 0 };
+        MathLexeme CurrentLexeme{ MathLexeme::Begin }, PreviousLexeme{};
+        long long int iParBalance{ 0 };
+
+        do
+            GetLexCheckSyntax(
+                ParseMode,
+                iFirstSymbol,
+                pString,
+                iCurrentPosition,
+                CurrentLexeme,
+                PreviousLexeme,
+                iParBalance,
+                nullptr,
+                Context.Stack);
+
+        while (CurrentLexeme.iType != MathLexeme::End);
+
+        // Check if there've been enough right parentheses
+
+        if (iParBalance > 0) throw ExpectedRightPar;
+
+        // syntax OK!
+
+        iErrorPosition = iCurrentPosition;
+        return OK;
+
+    }//try
+
+    catch (const MathParser::ErrorCodes& iCaught)
+    {
+        iErrorPosition = iFirstSymbol;
+        return iCaught;
+    }
+}
+
+MathParser::ErrorCodes MathParser::Evaluate(
+    ExecutionContext& Context, size_t& iErrorPosition, const vector<double>& args,
+	double& dValue, size_t iIndex) const
+{
+    size_t iFirstSymbol{ 0 };
+    auto& Stack{ Context.Stack };
+
+    try
+    {
+        if (iIndex >= input_strings.size()) throw WrongIndex;
+
+        AdjustContext(Context);
+
+        const auto (*const pString) { input_strings[iIndex].data() };
+        size_t iCurrentPosition{ 0 };
+        MathLexeme CurrentLexeme{ MathLexeme::Begin }, PreviousLexeme{};
+        long long int iParBalance{ 0 };
+        const double* rgdArguments{ args.data() };
+
+        Stack.Push (CurrentLexeme);
+
+        do
+        {
+            GetLexCheckSyntax(
+                EvaluateMode,
+                iFirstSymbol,
+                pString,
+                iCurrentPosition,
+                CurrentLexeme,
+                PreviousLexeme,
+                iParBalance,
+                rgdArguments,
+                Stack);
+
+	        // Check if there've been enough right parentheses
+
+			if (CurrentLexeme.iType == MathLexeme::End)
+				if (iParBalance > 0) throw ExpectedRightPar;
+
+            // Now evaluate
+
+            switch (CurrentLexeme.iType)
+            {
+            case MathLexeme::Number:
+            case MathLexeme::LeftPar:
+            case MathLexeme::Function:
+                Stack.Push(CurrentLexeme);
+                break;
+
+            case MathLexeme::Binary:
+            {
+                bool fMore{ true };
+
+                do
+                {
+                    const auto SecondFromTop = Stack.SecondFromTop();
+
+                    switch (SecondFromTop.iType)
+                    {
+                    case MathLexeme::Begin:
+                    case MathLexeme::LeftPar:
+                        fMore = false;
+                        break;
+
+                    default:
+                    // case MathLexeme::Binary:
+                        if (MathLexeme::IsPriorityHigher
+                            [SecondFromTop.iItem]
+                            [CurrentLexeme.iItem]) 
+                            {
+                                iFirstSymbol = Stack.SecondFromTop().iPosition;
+                                EvaluateBinaryOp(Stack);
+                            }
+                        else fMore = false;
+
+                    } // switch
+
+                } while (fMore);
+
+                Stack.Push(CurrentLexeme);
+
+            } // case
+
+            break;
+
+            case MathLexeme::RightPar:
+            {
+                while (Stack.SecondFromTop().iType == MathLexeme::Binary)
+                {
+                    iFirstSymbol = Stack.SecondFromTop().iPosition;
+                    EvaluateBinaryOp(Stack);
+                }
+
+                MathLexeme Tmp;
+                Stack.Pop(Tmp);
+                Stack.Pop(); // remove '('
+
+                if (Stack.Top().iType == MathLexeme::Function)
+                {
+                    Tmp.dValue = Stack.Top().pFunction(Tmp.dValue);
+                    
+                    iFirstSymbol = Stack.Top().iPosition;
+
+                    CheckForFloatingPointError(Tmp.dValue);
+
+                    Stack.Pop(); // remove function
+                }
+                Stack.Push(Tmp);
+            }
+            break;
+
+            case MathLexeme::End:
+                while (Stack.SecondFromTop().iType == MathLexeme::Binary)
+                {
+                    iFirstSymbol = Stack.SecondFromTop().iPosition;
+                    EvaluateBinaryOp(Stack);
+                }
+            break;
+
+            default:
+            // case MathLexeme::Unary:
+                if (CurrentLexeme.iItem == MathLexeme::Minus)
+                {
+                    Stack.Push(MathLexeme(MathLexeme::Number, MathLexeme::Constant, 0.0));
+                    Stack.Push(MathLexeme(MathLexeme::Binary, MathLexeme::Minus));
+                }
+
+            } // switch
+
+        } // do
+        while (CurrentLexeme.iType != MathLexeme::End);
+
+	    // syntax OK!
+        iErrorPosition = iCurrentPosition;
+        dValue = Stack.Top().dValue;
+        Stack.Reset();
+        return OK;
+
+    }//try
+
+    catch (const MathParser::ErrorCodes& iCaught)
+    {
+        iErrorPosition = iFirstSymbol;
+        Stack.Reset();
+        return iCaught;
+    }
+}
+
+MathParser::ErrorCodes MathParser::Compile(size_t& iErrorPosition, size_t iIndex)
+{
+    size_t iFirstSymbol{ 0 };
+    auto& Stack{ default_context.Stack };
+
+    try
+    {
+        if (iIndex >= input_strings.size()) throw WrongIndex;
+
+        AdjustContext(default_context);
+
+        const auto (*const pString) { input_strings[iIndex].data() };
+        size_t iCurrentPosition{ 0 };
+        MathLexeme CurrentLexeme{ MathLexeme::Begin }, PreviousLexeme{};
+        long long int iParBalance{ 0 };
+
+        pCompiledProgram = &compiled_code[iIndex];
+        pCompiledProgram->code.clear();
+        pCompiledProgram->constants.clear();
+        pCompiledProgram->error_positions.clear();
+        pCompiledProgram->variables.clear();
+        pCompiledProgram->native = NativeCode{};
+        pCompiledProgram->fFastMath = fast_math;
+
+		// Will count runtime memory used for storage of intermediate values.
+		// User variables are referred to by their indices in user_vars until
+		// SelectVariables gives the ones read the first memory indices.
+		// Each intermediate value gets its own index here; AllocateMemory will
+		// reuse the memory once the code is complete.
+		iMemoryCounter = NumberOfVars();
+
+        Stack.Push(CurrentLexeme);
+
+        do
+        {
+            GetLexCheckSyntax(
+                CompileMode,
+                iFirstSymbol,
+                pString,
+                iCurrentPosition,
+                CurrentLexeme,
+                PreviousLexeme,
+                iParBalance,
+                nullptr,
+                Stack);
+
+			// Check if there've been enough right parentheses
+			
+            if (CurrentLexeme.iType == MathLexeme::End)
+				if (iParBalance > 0) throw ExpectedRightPar;
+
+            // Now compile
+
+            switch (CurrentLexeme.iType)
+            {
+            case MathLexeme::Number:
+            case MathLexeme::LeftPar:
+            case MathLexeme::Function:
+                Stack.Push(CurrentLexeme);
+            break;
+
+            case MathLexeme::Binary:
+            {
+                bool fMore{ true };
+
+                do // unwind stack
+                {
+                    const auto SecondFromTop = Stack.SecondFromTop();
+
+                    switch (SecondFromTop.iType)
+                    {
+                    case MathLexeme::Begin:
+                    case MathLexeme::LeftPar:
+                        fMore = false;
+                    break;
+
+                    default:
+                    // case MathLexeme::Binary:
+                        if (MathLexeme::IsPriorityHigher
+                            [SecondFromTop.iItem]
+                            [CurrentLexeme.iItem])
+                            {
+                                iFirstSymbol = Stack.SecondFromTop().iPosition;
+                                CompileBinaryOp(Stack);
+                            }
+                        else fMore = false;
+
+                    } // switch
+
+                } while (fMore);
+
+                Stack.Push(CurrentLexeme);
+
+            } // case MathLexeme::Binary
+
+            break;
+
+            case MathLexeme::RightPar:
+            {
+                while (Stack.SecondFromTop().iType == MathLexeme::Binary)
+                {
+                    iFirstSymbol = Stack.SecondFromTop().iPosition;
+                    CompileBinaryOp(Stack);
+                }
+
+                MathLexeme Tmp;
+                Stack.Pop(Tmp);
+                Stack.Pop(); // remove '('
+                
+                if (Stack.Top().iType == MathLexeme::Function)
+                {
+                    if (Tmp.iItem == MathLexeme::Constant)
+                    {
+                        // argument of the function is known, no need to compile
+
+                        Tmp.dValue = Stack.Top().pFunction(Tmp.dValue);
+
+                        iFirstSymbol = Stack.Top().iPosition;
+
+                        CheckForFloatingPointError(Tmp.dValue);
+                    }
+                    else
+                    {
+                        // argument of the function not known
+
+                        Tmp.iRunTimeIndex = EmitFunction(Stack.Top().iItem,
+                            Tmp.iRunTimeIndex, Stack.Top().iPosition);
+                    }
+					Stack.Pop(); // remove function
+                }
+                Stack.Push(Tmp);
+            } //case MathLexeme::RightPar:
+
+            break;
+
+            case MathLexeme::End:
+                while (Stack.SecondFromTop().iType == MathLexeme::Binary)
+                {
+                    iFirstSymbol = Stack.SecondFromTop().iPosition;
+                    CompileBinaryOp(Stack);
+                }
+            break;
+
+            default:
+            // case MathLexeme::Unary:
+                if (CurrentLexeme.iItem == MathLexeme::Minus)
+                {
+                    Stack.Push(MathLexeme(MathLexeme::Number, MathLexeme::Constant, 0.0));
+                    Stack.Push(MathLexeme(MathLexeme::Binary, MathLexeme::Minus));
+                }
+
+            } // switch
+        
+        } // do
+        while (CurrentLexeme.iType != MathLexeme::End);
+
+        // syntax OK!
+        iErrorPosition = iCurrentPosition;
+
+        if (Stack.Top().iItem == MathLexeme::Constant)
+            EmitCommand(CompiledCommand::EndConst, 0,
+                EmitConstant(Stack.Top().dValue), 0, iCurrentPosition);
+        else
+            EmitCommand(CompiledCommand::EndMem, 0,
+                Stack.Top().iRunTimeIndex, 0, iCurrentPosition);
+
+        SelectVariables();
+        Simplify();
+        EliminateCommonSubexpressions();
+        ExpandTangents();
+        SelectPolynomials();
+        SelectFunctionPairs();
+        SelectSuperinstructions();
+        AnalyzeRanges();
+        DeferFloatingPointChecks();
+        AllocateMemory();
+
+        Stack.Reset();
+        return OK;
+
+    }//try
+
+    catch (const MathParser::ErrorCodes& iCaught)
+    {
+        iErrorPosition = iFirstSymbol;
+        Stack.Reset();
+        InvalidateCompiledCode(iIndex);
+        return iCaught;
+    }
+}
+
+// Runs the native code if CompileNative has made it. Otherwise, each opcode has
+// its own handler. With MATH_PARSER_THREADED_CODE a handler jumps straight to
+// the handler of the next command through rgpHandlers, so the indirect jump is
+// replicated in every handler and predicted separately; otherwise the handlers
+// are the cases of a switch.
+//
+MathParser::ErrorCodes MathParser::Execute(
+    ExecutionContext& Context, size_t& iErrorPosition, const vector<double>& args,
+    double& dValue, size_t iIndex) const
+{
+    AdjustContext(Context);
+
+    const auto& Program{ compiled_code[iIndex] };
+    size_t iErrorCommand{};
+
+    GatherVars(Context, Program, [&args](size_t iVar) { return args[iVar]; });
+
+    const auto err_code{ RunProgram(Context, Program, dValue, iErrorCommand) };
+
+    if (err_code != OK) iErrorPosition = Program.error_positions[iErrorCommand];
+
+    return err_code;
+}
+
+MathParser::ErrorCodes MathParser::ExecuteBound(
+    ExecutionContext& Context, size_t& iErrorPosition, double& dValue,
+    size_t iIndex, size_t iRecord) const
+{
+    AdjustContext(Context);
+
+    const auto& Program{ compiled_code[iIndex] };
+    size_t iErrorCommand{};
+
+    GatherVars(Context, Program,
+        [this, iRecord](size_t iVar) { return var_bindings[iVar].Value(iRecord); });
+
+    const auto err_code{ RunProgram(Context, Program, dValue, iErrorCommand) };
+
+    if (err_code != OK) iErrorPosition = Program.error_positions[iErrorCommand];
+
+    return err_code;
+}
+
+// Store the values of the variables Program reads in the first indices of
+// Context.runtime_mem, Value(n) being the value of nth user variable.
+// Only these few values are copied, whatever the number of user variables.
+//
+template<typename VarValue>
+void MathParser::GatherVars(
+    ExecutionContext& Context, const CompiledProgram& Program, const VarValue& Value) const
+{
+    if (Context.runtime_mem.size() < Program.iMemorySize)
+        Context.runtime_mem.resize(Program.iMemorySize);
+
+    auto (*const pMemPtr) { Context.runtime_mem.data() };
+    const auto& variables{ Program.variables };
+
+    for (size_t it = 0; it < variables.size(); ++it)
+        pMemPtr[it] = Value(variables[it]);
+}
+
+// Execute Program on the variables gathered by GatherVars: the common part of
+// Execute, ExecuteBound and ExecuteFused. In case of error, iErrorCommand is
+// the index of the failed command. The intermediate values stay in
+// Context.runtime_mem.
+//
+MathParser::ErrorCodes MathParser::RunProgram(
+    ExecutionContext& Context, const CompiledProgram& Program,
+    double& dValue, size_t& iErrorCommand) const
+{
+    if (Program.native)
+    {
+        const auto pMem{ Context.runtime_mem.data() };
+        const auto iFailed{ Program.native.Run(pMem,
+            pMem + Program.variables.size(), Program.constants.data(), dValue) };
+
+        if (iFailed == 0) return OK;
+
+#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+#ifdef MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+        return Interpret<true>(Context, Program, dValue, iErrorCommand);
+#else //MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+        iErrorCommand = iFailed - 1;
+        return FloatingPointError(Context.runtime_mem[Program.code[iErrorCommand].iResult]);
+#endif //MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+    }
+
+#ifdef MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+    return Interpret<false>(Context, Program, dValue, iErrorCommand);
+#else //MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+    return Interpret<true>(Context, Program, dValue, iErrorCommand);
+#endif //MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+}
+
+// The interpreter of RunProgram. With fCheckEach, the result of every command
+// is checked for floating point errors; otherwise only the values of CheckMem
+// commands are, and if one is not finite, the program is run again with
+// fCheckEach to find out which command has failed first.
+//
+template<bool fCheckEach>
+MathParser::ErrorCodes MathParser::Interpret(
+    ExecutionContext& Context, const CompiledProgram& Program,
+    double& dValue, size_t& iErrorCommand) const
+{
+    auto (*pCmdPtr) { Program.code.data() };
+    const auto (*const pConstPtr) { Program.constants.data() };
+    auto (*const pMemPtr) { Context.runtime_mem.data() };
+
+#define MEM1 pMemPtr[pCmdPtr->iFirstOperand]
+#define MEM2 pMemPtr[pCmdPtr->iSecondOperand]
+#define CONST1 pConstPtr[pCmdPtr->iFirstOperand]
+#define CONST2 pConstPtr[pCmdPtr->iSecondOperand]
+#define RESULT pMemPtr[pCmdPtr->iResult]
+#define NEXTMEM2 pMemPtr[pCmdPtr[1].iSecondOperand]
+#define NEXTCONST2 pConstPtr[pCmdPtr[1].iSecondOperand]
+
+#ifdef MATH_PARSER_THREADED_CODE
+
+    // in the order of CompiledCommand::OpCodes
+
+    static const void* const rgpHandlers[]{
+        &&PlusMemMem, &&MinusMemMem, &&MultiplyMemMem, &&DivideMemMem, &&PowerMemMem,
+        &&PlusMemConst, &&MinusMemConst, &&MultiplyMemConst, &&DivideMemConst, &&PowerMemConst,
+        &&PlusConstMem, &&MinusConstMem, &&MultiplyConstMem, &&DivideConstMem, &&PowerConstMem,
+        &&CallFunction, &&SqrtMem, &&AbsMem, &&FloorMem, &&SinCosMem, &&SinhCoshMem,
+        &&PowerMemInt, &&PolynomialMem,
+        &&MultiplyAddMemMemMem, &&MultiplyAddMemMemConst,
+        &&MultiplyAddMemConstMem, &&MultiplyAddMemConstConst,
+        &&FusedMultiplyAddMemMemMem, &&FusedMultiplyAddMemMemConst,
+        &&FusedMultiplyAddMemConstMem, &&FusedMultiplyAddMemConstConst,
+        &&PlusMultiplyMemMemConst, &&PlusMultiplyMemConstConst,
+        &&CheckMem, &&EndMem, &&EndConst, &&EndConst };
+
+    static_assert(sizeof(rgpHandlers) / sizeof(rgpHandlers[0]) == CompiledCommand::Error + 1,
+        "rgpHandlers must have a handler for each opcode");
+
+#define HANDLER(OpCode) OpCode:
+#define DISPATCH goto *rgpHandlers[pCmdPtr->iOpCode]
+
+    DISPATCH;
+
+#else //MATH_PARSER_THREADED_CODE
+
+#define HANDLER(OpCode) case CompiledCommand::OpCode:
+#define DISPATCH continue
+
+    for (;;) switch (pCmdPtr->iOpCode) {
+
+#endif //MATH_PARSER_THREADED_CODE
+
+// A superinstruction stores only the result of its second operation. If that
+// is not finite, neither is the first one's when the first one has failed:
+// the error is then reported at the first command, as without fusion.
+
+// Without deferred checks, a result that AnalyzeRanges has proved finite is
+// not checked, as in ExecuteBlock and the native code (for a superinstruction,
+// the result of its second command). The run looking for the command that
+// has failed a deferred check still checks every result.
+
+#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+#ifdef MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+#define PROVED_FINITE(Cmd) false
+#else //MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+#define PROVED_FINITE(Cmd) ((Cmd).iFlags & CompiledCommand::Finite)
+#endif //MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+#define NEXT if (fCheckEach && !PROVED_FINITE(pCmdPtr[0]) && !isfinite(RESULT)) goto error; ++pCmdPtr; DISPATCH
+#define FUSED(First, Second) \
+    { const auto dFirst{ First }; const auto dSecond{ Second }; \
+    if (fCheckEach && !PROVED_FINITE(pCmdPtr[1]) && !isfinite(dSecond) && !isfinite(dFirst)) \
+    { RESULT = dFirst; goto error; } \
+    ++pCmdPtr; RESULT = dSecond; NEXT; }
+#define PAIR if (fCheckEach && !PROVED_FINITE(pCmdPtr[0]) && !isfinite(RESULT)) goto error; ++pCmdPtr; NEXT
+#else //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+#define NEXT ++pCmdPtr; DISPATCH
+#define FUSED(First, Second) \
+    { const auto dFirst{ First }; const auto dSecond{ Second }; (void)dFirst; \
+    ++pCmdPtr; RESULT = dSecond; NEXT; }
+#define PAIR ++pCmdPtr; NEXT
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+    // mem+mem
+
+    HANDLER(PlusMemMem)         RESULT = MEM1 + MEM2;                       NEXT;
+    HANDLER(MinusMemMem)        RESULT = MEM1 - MEM2;                       NEXT;
+    HANDLER(MultiplyMemMem)     RESULT = MEM1 * MEM2;                       NEXT;
+    HANDLER(DivideMemMem)       RESULT = MEM1 / MEM2;                       NEXT;
+    HANDLER(PowerMemMem)        RESULT = MathLexeme::mypow(MEM1, MEM2);     NEXT;
+
+    // mem+const
+
+    HANDLER(PlusMemConst)       RESULT = MEM1 + CONST2;                     NEXT;
+    HANDLER(MinusMemConst)      RESULT = MEM1 - CONST2;                     NEXT;
+    HANDLER(MultiplyMemConst)   RESULT = MEM1 * CONST2;                     NEXT;
+    HANDLER(DivideMemConst)     RESULT = MEM1 / CONST2;                     NEXT;
+    HANDLER(PowerMemConst)      RESULT = MathLexeme::mypow(MEM1, CONST2);   NEXT;
+
+    // const+mem
+
+    HANDLER(PlusConstMem)       RESULT = CONST1 + MEM2;                     NEXT;
+    HANDLER(MinusConstMem)      RESULT = CONST1 - MEM2;                     NEXT;
+    HANDLER(MultiplyConstMem)   RESULT = CONST1 * MEM2;                     NEXT;
+    HANDLER(DivideConstMem)     RESULT = CONST1 / MEM2;                     NEXT;
+    HANDLER(PowerConstMem)      RESULT = MathLexeme::mypow(CONST1, MEM2);   NEXT;
+
+    // function call, inline functions, integer power
+
+    HANDLER(CallFunction)
+        RESULT = MathLexeme::FunctionAddress[pCmdPtr->iSecondOperand](MEM1);
+        NEXT;
+
+    HANDLER(SqrtMem)            RESULT = sqrt(MEM1);                        NEXT;
+    HANDLER(AbsMem)             RESULT = fabs(MEM1);                        NEXT;
+    HANDLER(FloorMem)           RESULT = floor(MEM1);                       NEXT;
+
+    // function pairs: the next command stores the cosine
+
+    HANDLER(SinCosMem)
+        MathLexeme::mysincos(MEM1, &RESULT, &pMemPtr[pCmdPtr[1].iResult]);
+        PAIR;
+
+    HANDLER(SinhCoshMem)
+        MathLexeme::mysinhcosh(MEM1, &RESULT, &pMemPtr[pCmdPtr[1].iResult]);
+        PAIR;
+
+    HANDLER(PowerMemInt)
+        RESULT = MathLexeme::myintpow(MEM1, pCmdPtr->iSecondOperand);
+        NEXT;
+
+    HANDLER(PolynomialMem)
+        RESULT = MathLexeme::mypolynomial(MEM1, &CONST2);
+        NEXT;
+
+    // superinstructions
+
+    HANDLER(MultiplyAddMemMemMem)           FUSED(MEM1 * MEM2, dFirst + NEXTMEM2);
+    HANDLER(MultiplyAddMemMemConst)         FUSED(MEM1 * MEM2, dFirst + NEXTCONST2);
+    HANDLER(MultiplyAddMemConstMem)         FUSED(MEM1 * CONST2, dFirst + NEXTMEM2);
+    HANDLER(MultiplyAddMemConstConst)       FUSED(MEM1 * CONST2, dFirst + NEXTCONST2);
+    HANDLER(FusedMultiplyAddMemMemMem)      FUSED(MEM1 * MEM2, fma(MEM1, MEM2, NEXTMEM2));
+    HANDLER(FusedMultiplyAddMemMemConst)    FUSED(MEM1 * MEM2, fma(MEM1, MEM2, NEXTCONST2));
+    HANDLER(FusedMultiplyAddMemConstMem)    FUSED(MEM1 * CONST2, fma(MEM1, CONST2, NEXTMEM2));
+    HANDLER(FusedMultiplyAddMemConstConst)  FUSED(MEM1 * CONST2, fma(MEM1, CONST2, NEXTCONST2));
+    HANDLER(PlusMultiplyMemMemConst)        FUSED(MEM1 + MEM2, dFirst * NEXTCONST2);
+    HANDLER(PlusMultiplyMemConstConst)      FUSED(MEM1 + CONST2, dFirst * NEXTCONST2);
+
+    // deferred check (when every command is checked, the value already has been)
+
+    HANDLER(CheckMem)
+#ifdef MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+        if (!fCheckEach && !isfinite(MEM1))
+            return Interpret<true>(Context, Program, dValue, iErrorCommand);
+#endif //MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+        ++pCmdPtr;
+        DISPATCH;
+
+    // termination
+
+    HANDLER(EndMem)
+        dValue = MEM1;
+        return OK;
+
+#ifdef MATH_PARSER_THREADED_CODE
+    HANDLER(EndConst)
+#else //MATH_PARSER_THREADED_CODE
+    default:
+    // case CompiledCommand::EndConst:
+#endif //MATH_PARSER_THREADED_CODE
+        dValue = CONST1;
+        return OK;
+
+#ifndef MATH_PARSER_THREADED_CODE
+    } // switch
+#endif //MATH_PARSER_THREADED_CODE
+
+#undef MEM1
+#undef MEM2
+#undef CONST1
+#undef CONST2
+#undef RESULT
+#undef NEXTMEM2
+#undef NEXTCONST2
+#undef HANDLER
+#undef DISPATCH
+#undef NEXT
+#undef FUSED
+#undef PAIR
+#undef PROVED_FINITE
+
+#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+error:
+
+    iErrorCommand = pCmdPtr - Program.code.data();
+    return FloatingPointError(pMemPtr[pCmdPtr->iResult]);
+
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+}
+
+MathParser::ErrorCodes MathParser::ExecuteBatch(
+    ExecutionContext& Context, size_t& iErrorPosition, size_t& iErrorRow,
+    const vector<const double*>& args, double* rgdValues, size_t iRows,
+    size_t iIndex) const
+{
+    const auto& Program{ compiled_code[iIndex] };
+    size_t iErrorCommand{};
+
+    const auto err_code{ RunBatch(Context, Program, &Program.code.back(), 1,
+        &rgdValues, args, iRows, iErrorCommand, iErrorRow) };
+
+    if (err_code != OK) iErrorPosition = Program.error_positions[iErrorCommand];
+
+    return err_code;
+}
+
+// Execute Program on iRows rows of arguments: the common part of ExecuteBatch
+// and ExecuteFusedBatch. The value of output n (an EndMem or EndConst command
+// referring to the memory or the constants of Program) is stored in
+// rgpValues[n][row]. In case of error, iErrorCommand is the index of the failed
+// command.
+//
+MathParser::ErrorCodes MathParser::RunBatch(
+    ExecutionContext& Context, const CompiledProgram& Program,
+    const CompiledCommand* pOutputs, size_t iOutputs, double* const* rgpValues,
+    const vector<const double*>& args, size_t iRows,
+    size_t& iErrorCommand, size_t& iErrorRow) const
+{
+    // Choose the number of rows in a block so that the columns of intermediate
+    // values used by a block fit in L1 cache
+
+    constexpr size_t l1_cache_size{ 32768 }, min_block_size{ 16 }, max_block_size{ 1024 };
+
+    const auto iTemporaries{ Program.iMemorySize - Program.variables.size() };
+    auto iBlockSize{ max_block_size };
+
+    if (iTemporaries > 0)
+        iBlockSize = l1_cache_size / (sizeof(double) * iTemporaries);
+
+    if (iBlockSize > max_block_size) iBlockSize = max_block_size;
+    if (iBlockSize < min_block_size) iBlockSize = min_block_size;
+    iBlockSize -= iBlockSize % min_block_size;
+
+    auto& batch_mem{ Context.batch_mem };
+
+    if (batch_mem.size() < iTemporaries * iBlockSize)
+        batch_mem.resize(iTemporaries * iBlockSize);
+
+    for (size_t iFirstRow = 0; iFirstRow < iRows; iFirstRow += iBlockSize)
+    {
+        const auto iBlockRows{ iRows - iFirstRow < iBlockSize ? iRows - iFirstRow : iBlockSize };
+
+        const auto err_code{ ExecuteBlock(
+            Context, Program, pOutputs, iOutputs, rgpValues, args,
+            iFirstRow, iBlockRows, iBlockSize, iErrorCommand, iErrorRow) };
+
+        if (err_code != OK) return err_code;
+    }
+
+    return OK;
+}
+
+// Execute one block of rows for RunBatch.
+// Intermediate values of the nth row are kept in the nth element of the columns
+// of Context.batch_mem, each column being iBlockSize long. Column iResult of a command
+// is found at (iResult - Program.variables.size()) * iBlockSize; columns of user
+// variables are read directly from args.
+//
+MathParser::ErrorCodes MathParser::ExecuteBlock(
+    ExecutionContext& Context, const CompiledProgram& Program,
+    const CompiledCommand* pOutputs, size_t iOutputs, double* const* rgpValues,
+    const vector<const double*>& args, size_t iFirstRow, size_t iRows,
+    size_t iBlockSize, size_t& iErrorCommand, size_t& iErrorRow) const
+{
+    const auto& variables{ Program.variables };
+    const auto iVars{ variables.size() };
+    const auto& Kernels{ MathKernels::Selected() };
+    auto (*const pMemPtr) { Context.batch_mem.data() };
+
+    auto Column = [&](size_t iRunTimeIndex) -> const double*
+    {
+        return iRunTimeIndex < iVars ?
+            args[variables[iRunTimeIndex]] + iFirstRow : pMemPtr + (iRunTimeIndex - iVars) * iBlockSize;
+    };
+
+    const auto (*const pConstPtr) { Program.constants.data() };
+
+    // an operand of a superinstruction: a column, or a pointer to the constant
+
+    auto Operand = [&](bool fMem, size_t iIndex) -> const double*
+    {
+        return fMem ? Column(iIndex) : pConstPtr + iIndex;
+    };
+
+    for (auto (*pCmdPtr) { Program.code.data() }; ; ++pCmdPtr)
+    {
+        const auto& Cmd{ *pCmdPtr };
+        auto (*pResult) { pMemPtr + (Cmd.iResult - iVars) * iBlockSize };
+
+        switch (Cmd.iOpCode)
+        {
+        case CompiledCommand::PlusMemMem:
+        case CompiledCommand::MinusMemMem:
+        case CompiledCommand::MultiplyMemMem:
+        case CompiledCommand::DivideMemMem:
+        case CompiledCommand::PowerMemMem:
+            Kernels.MemMem[Cmd.iOpCode - CompiledCommand::PlusMemMem](
+                pResult, Column(Cmd.iFirstOperand), Column(Cmd.iSecondOperand), iRows);
+            break;
+
+        case CompiledCommand::PlusMemConst:
+        case CompiledCommand::MinusMemConst:
+        case CompiledCommand::MultiplyMemConst:
+        case CompiledCommand::DivideMemConst:
+        case CompiledCommand::PowerMemConst:
+            Kernels.MemConst[Cmd.iOpCode - CompiledCommand::PlusMemConst](
+                pResult, Column(Cmd.iFirstOperand), pConstPtr[Cmd.iSecondOperand], iRows);
+            break;
+
+        case CompiledCommand::PlusConstMem:
+        case CompiledCommand::MinusConstMem:
+        case CompiledCommand::MultiplyConstMem:
+        case CompiledCommand::DivideConstMem:
+        case CompiledCommand::PowerConstMem:
+            Kernels.ConstMem[Cmd.iOpCode - CompiledCommand::PlusConstMem](
+                pResult, pConstPtr[Cmd.iFirstOperand], Column(Cmd.iSecondOperand), iRows);
+            break;
+
+        case CompiledCommand::CallFunction:
+        {
+            auto Function{ MathLexeme::FunctionArrayAddress[Cmd.iSecondOperand] };
+
+            if (Program.fFastMath)
+                switch (Cmd.iSecondOperand)
+                {
+                case MathLexeme::Exp:   Function = Kernels.Exp; break;
+                case MathLexeme::Ln:    Function = Kernels.Ln;  break;
+                case MathLexeme::Lg:    Function = Kernels.Lg;  break;
+                case MathLexeme::Sin:   Function = Kernels.Sin; break;
+                case MathLexeme::Cos:   Function = Kernels.Cos; break;
+                case MathLexeme::Tan:   Function = Kernels.Tan; break;
+                }
+
+            Function(pResult, Column(Cmd.iFirstOperand), iRows);
+            break;
+        }
+
+        case CompiledCommand::SqrtMem:
+            Kernels.Sqrt(pResult, Column(Cmd.iFirstOperand), iRows);
+            break;
+
+        case CompiledCommand::AbsMem:
+            Kernels.Abs(pResult, Column(Cmd.iFirstOperand), iRows);
+            break;
+
+        case CompiledCommand::FloorMem:
+            Kernels.Floor(pResult, Column(Cmd.iFirstOperand), iRows);
+            break;
+
+        // function pairs: the next command holds the cosine
+
+        case CompiledCommand::SinCosMem:
+        case CompiledCommand::SinhCoshMem:
+        {
+            const auto ArrayPair{ Cmd.iOpCode == CompiledCommand::SinhCoshMem ?
+                MathLexeme::arraysinhcosh : Program.fFastMath ? Kernels.SinCos : MathLexeme::arraysincos };
+            const auto pSine{ pResult };
+
+            pResult = pMemPtr + ((++pCmdPtr)->iResult - iVars) * iBlockSize;
+
+            ArrayPair(pSine, pResult, Column(Cmd.iFirstOperand), iRows);
+            break;
+        }
+
+        case CompiledCommand::PowerMemInt:
+            Kernels.PowerMemInt(pResult, Column(Cmd.iFirstOperand), Cmd.iSecondOperand, iRows);
+            break;
+
+        case CompiledCommand::PolynomialMem:
+            Kernels.Polynomial(pResult, Column(Cmd.iFirstOperand), pConstPtr + Cmd.iSecondOperand, iRows);
+            break;
+
+        // superinstructions: the next command holds the result and the third operand
+
+        case CompiledCommand::MultiplyAddMemMemMem:
+        case CompiledCommand::MultiplyAddMemMemConst:
+        case CompiledCommand::MultiplyAddMemConstMem:
+        case CompiledCommand::MultiplyAddMemConstConst:
+        case CompiledCommand::FusedMultiplyAddMemMemMem:
+        case CompiledCommand::FusedMultiplyAddMemMemConst:
+        case CompiledCommand::FusedMultiplyAddMemConstMem:
+        case CompiledCommand::FusedMultiplyAddMemConstConst:
+        case CompiledCommand::PlusMultiplyMemMemConst:
+        case CompiledCommand::PlusMultiplyMemConstConst:
+        {
+            const auto& Second{ *++pCmdPtr };
+
+            pResult = pMemPtr + (Second.iResult - iVars) * iBlockSize;
+
+            Kernels.Fused[Cmd.iOpCode - CompiledCommand::MultiplyAddMemMemMem](pResult,
+                Column(Cmd.iFirstOperand), Operand(Cmd.IsSecondOperandMem(), Cmd.iSecondOperand),
+                Operand(Second.IsSecondOperandMem(), Second.iSecondOperand), iRows);
+            break;
+        }
+
+        case CompiledCommand::CheckMem:
+            pResult = pMemPtr + (Cmd.iFirstOperand - iVars) * iBlockSize;
+            break;
+
+        // termination: store the outputs
+
+        default:
+        // case CompiledCommand::EndMem:
+        // case CompiledCommand::EndConst:
+            for (size_t iOutput = 0; iOutput < iOutputs; ++iOutput)
+            {
+                const auto& Output{ pOutputs[iOutput] };
+                auto (*const pValues) { rgpValues[iOutput] + iFirstRow };
+
+                if (Output.iOpCode == CompiledCommand::EndMem)
+                    std::memcpy(pValues, Column(Output.iFirstOperand), sizeof(double) * iRows);
+                else
+                    for (size_t it = 0; it < iRows; ++it)
+                        pValues[it] = pConstPtr[Output.iFirstOperand];
+            }
+            return OK;
+        }
+
+#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+#ifdef MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+        if (Cmd.iOpCode != CompiledCommand::CheckMem) continue;
+#else //MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+        if (pCmdPtr->iFlags & CompiledCommand::Finite) continue;
+#endif //MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+
+        if (!Kernels.AllFinite(pResult, iRows))
+        {
+            // Some row of the block has failed, but not necessarily at this
+            // command. Find out which row is the first to fail and where,
+            // by executing the rows one by one (with deferred checks, only
+            // a row that fails is run again checking every command).
+
+            for (size_t iRow = 0; iRow < iRows; ++iRow)
+            {
+                GatherVars(Context, Program,
+                    [&args, iFirstRow, iRow](size_t iVar) { return args[iVar][iFirstRow + iRow]; });
+
+                double dValue{};
+                const auto err_code{ RunProgram(Context, Program, dValue, iErrorCommand) };
+
+                if (err_code != OK)
+                {
+                    iErrorRow = iFirstRow + iRow;
+                    return err_code;
+                }
+
+                for (size_t iOutput = 0; iOutput < iOutputs; ++iOutput)
+                    rgpValues[iOutput][iFirstRow + iRow] = OutputValue(
+                        Program, pOutputs[iOutput], Context.runtime_mem.data());
+            }
+
+            return OK; // all the values have been stored row by row
+        }
+
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+    }
+}
+
+MathParser::ErrorCodes MathParser::ExecuteFused(
+    ExecutionContext& Context, size_t& iErrorPosition, size_t& iErrorString,
+    const vector<double>& args, double* rgdValues, size_t iFusedIndex) const
+{
+    AdjustContext(Context);
+
+    const auto& Fused{ fused_code[iFusedIndex] };
+    size_t iErrorCommand{};
+    double dValue{};
+
+    GatherVars(Context, Fused.program, [&args](size_t iVar) { return args[iVar]; });
+
+    const auto err_code{ RunProgram(Context, Fused.program, dValue, iErrorCommand) };
+
+    if (err_code != OK)
+    {
+        iErrorPosition = Fused.program.error_positions[iErrorCommand];
+        iErrorString = Fused.error_strings[iErrorCommand];
+        return err_code;
+    }
+
+    for (size_t iOutput = 0; iOutput < Fused.outputs.size(); ++iOutput)
+        rgdValues[iOutput] = OutputValue(
+            Fused.program, Fused.outputs[iOutput], Context.runtime_mem.data());
+
+    return OK;
+}
+
+MathParser::ErrorCodes MathParser::ExecuteFusedBatch(
+    ExecutionContext& Context, size_t& iErrorPosition, size_t& iErrorString, size_t& iErrorRow,
+    const vector<const double*>& args, const vector<double*>& values, size_t iRows,
+    size_t iFusedIndex) const
+{
+    const auto& Fused{ fused_code[iFusedIndex] };
+    size_t iErrorCommand{};
+
+    const auto err_code{ RunBatch(Context, Fused.program,
+        Fused.outputs.data(), Fused.outputs.size(), values.data(), args, iRows,
+        iErrorCommand, iErrorRow) };
+
+    if (err_code != OK)
+    {
+        iErrorPosition = Fused.program.error_positions[iErrorCommand];
+        iErrorString = Fused.error_strings[iErrorCommand];
+    }
+
+    return err_code;
+}
+
+void MathParser::RemoveAllFusedPrograms()
+{
+    fused_code.clear();
+}
+
+void MathParser::InsertString(
+    wstring&& wstr, size_t requested_index, size_t& assigned_index)
+{
+    if (requested_index >= input_strings.size()) requested_index = input_strings.size();
+    assigned_index = requested_index;
+
+    const auto str_len = wstr.size();
+
+    input_strings.insert(input_strings.begin() + requested_index, move(wstr));
+
+    if (iMaxStringLength < str_len) iMaxStringLength = str_len;
+
+    // allocate memory for compiled code
+
+    CompiledProgram Program{};
+    Program.code.reserve(str_len + 2);
+    Program.error_positions.reserve(str_len + 2);
+
+    compiled_code.insert(compiled_code.begin() + requested_index, std::move(Program));
+
+    InvalidateCompiledCode(assigned_index);
+
+    // allocate/adjust the lexer buffer, the stack and memory for run-time data
+    // (arguments and intermediate storage) of the own context; other contexts
+    // are adjusted when they are used
+
+    AdjustContext(default_context);
+}
+
+void MathParser::RemoveString(size_t iIndex)
+{
+    input_strings.erase(input_strings.begin() + iIndex);
+    compiled_code.erase(compiled_code.begin() + iIndex);
+}
+
+size_t MathParser::TrimVarName(wstring& wstr)
+{
+    auto str_len{ wstr.size() };
+    size_t it{ 0 };
+
+    for (; it < str_len; ++it)
+        if (wstr[it] != ' ' && wstr[it] != '\t')
+            break;
+
+    if (it > 0)
+    {
+        wstr.erase(0, it);
+        str_len = wstr.size();
+    }
+
+    if (str_len > 0)
+    {
+        it = str_len - 1;
+
+        while (wstr[it] == ' ' || wstr[it] == '\t') --it;
+
+        if (it < str_len - 1)
+        {
+            wstr.erase(it + 1);
+            str_len = wstr.size();
+        }
+    }
+    return str_len;
+}
+
+MathParser::ErrorCodes MathParser::CheckVar(const wstring& wstr) const
+{
+    // check if wstr is a valid ID
+    if (!IsVarNameValid(wstr)) return InvalidIdentifier;
+
+    // check if in use
+    if (VarNameInUse(wstr.data(), wstr.size())) return IdentifierInUse;
+
+    return OK;
+}
+
+MathParser::ErrorCodes MathParser::CheckAndInsertVar(
+    wstring&& wstr, size_t requested_index, size_t& assigned_index)
+{
+    const auto err_code{ CheckVar(wstr) };
+
+    if (err_code != OK) return err_code;
+
+    if (requested_index >= user_vars.size())
+        requested_index = user_vars.size();
+
+    assigned_index = requested_index;
+
+    user_vars.insert(user_vars.begin() + requested_index, move(wstr));
+    var_ranges.insert(var_ranges.begin() + requested_index, ValueRange{ -HUGE_VAL, HUGE_VAL, true });
+    var_bindings.insert(var_bindings.begin() + requested_index,
+        VarBinding{ reinterpret_cast<const char*>(&unbound_value), 0 });
+
+    // the variables after an inserted one get new indices
+
+    if (requested_index + 1 == user_vars.size())
+        IndexVar(requested_index);
+    else
+        IndexAllVars();
+
+    return OK;
+}
+
+MathParser::ErrorCodes MathParser::CheckAndInsertVar(
+    wstring&& wstr, size_t requested_index, size_t& assigned_index, double dMin, double dMax)
+{
+    const auto err_code{ CheckAndInsertVar(move(wstr), requested_index, assigned_index) };
+
+    if (err_code == OK) SetVarRange(assigned_index, dMin, dMax);
+
+    return err_code;
+}
+
+void MathParser::SetVarRange(size_t iIndex, double dMin, double dMax)
+{
+    // an empty range, or a NaN bound, declares nothing
+
+    if (dMin <= dMax)
+        var_ranges[iIndex] = ValueRange{ dMin, dMax, false };
+    else
+        ClearVarRange(iIndex);
+}
+
+void MathParser::ClearVarRange(size_t iIndex)
+{
+    var_ranges[iIndex] = ValueRange{ -HUGE_VAL, HUGE_VAL, true };
+}
+
+void MathParser::BindVar(size_t iIndex, const double* pValue)
+{
+    var_bindings[iIndex] = VarBinding{ reinterpret_cast<const char*>(pValue), 0 };
+}
+
+void MathParser::BindVar(size_t iIndex, const void* pRecords, size_t iOffset, size_t iStride)
+{
+    var_bindings[iIndex] = VarBinding{ static_cast<const char*>(pRecords) + iOffset, iStride };
+}
+
+void MathParser::UnbindVar(size_t iIndex)
+{
+    BindVar(iIndex, &unbound_value);
+}
+
+void MathParser::RemoveVar(size_t iIndex)
+{
+    user_vars.erase(user_vars.begin() + iIndex);
+    var_ranges.erase(var_ranges.begin() + iIndex);
+    var_bindings.erase(var_bindings.begin() + iIndex);
+    IndexAllVars();
+}
+
+void MathParser::RemoveAllVars()
+{
+    user_vars.clear();
+    var_ranges.clear();
+    var_bindings.clear();
+    var_index.clear();
+}
+
+bool MathParser::OKtoExecute(size_t iIndex) const
+{
+    if (iIndex >= compiled_code.size()) return false;
+
+    const auto& code = compiled_code[iIndex].code;
+
+    if (code.empty()) return false; // never happens?
+
+    // check for error token
+    return code.front().iOpCode != CompiledCommand::Error;
+}
+
+bool MathParser::IsCaseSensitive() const { return case_sensitive; }
+
+void MathParser::SetCaseSensitive(bool case_sensitive)
+{
+    this->case_sensitive = case_sensitive;
+}
+
+bool MathParser::IsFastMath() const { return fast_math; }
+
+void MathParser::SetFastMath(bool fast_math)
+{
+    this->fast_math = fast_math;
+}
+
+// The entry of the perfect hash table of the built-in names, or -1 if
+// the name is not there
+//
+int MathParser::FindBuiltinName(const wchar_t* pName, size_t iLength) const
+{
+    const auto& Names{ MathLexeme::BuiltinNames };
+    const int iEntry{ Names.rgiEntry[
+        MathLexeme::NameSlot(MathLexeme::NameHash(pName, iLength), Names.iMultiplier)] };
+
+    if (iEntry < 0) return -1;
+
+    const auto (*const pID) { static_cast<size_t>(iEntry) < MathLexeme::MathLexNumberOfFunctions ?
+        MathLexeme::FunctionID[iEntry] :
+        MathLexeme::ConstantID[iEntry - MathLexeme::MathLexNumberOfFunctions] };
+
+    return MathLexeme::IsNameEqual(pName, iLength, pID, case_sensitive) ? iEntry : -1;
+}
+
+bool MathParser::FunctionExists(const wchar_t* pName, size_t iLength, size_t* index) const
+{
+    const auto iEntry{ FindBuiltinName(pName, iLength) };
+
+    if (iEntry < 0 || static_cast<size_t>(iEntry) >= MathLexeme::MathLexNumberOfFunctions ||
+        !MathLexeme::IsFunctionAllowed[iEntry])
+        return false;
+
+    if (index != nullptr) *index = iEntry;
+    return true;
+}
+
+bool MathParser::ConstantExists(const wchar_t* pName, size_t iLength, size_t* index) const
+{
+    const auto iEntry{ FindBuiltinName(pName, iLength) };
+    constexpr auto iFunctions{ static_cast<int>(MathLexeme::MathLexNumberOfFunctions) };
+
+    if (iEntry < iFunctions) return false;
+
+    const auto iConstant{ static_cast<size_t>(iEntry - iFunctions) };
+
+    if (!MathLexeme::IsConstantAllowed[iConstant]) return false;
+
+    if (index != nullptr) *index = iConstant;
+    return true;
+}
+
+// user_vars is indexed by an open addressing hash table with linear probing,
+// at most half full: a slot of var_index holds the index of a variable + 1,
+// or 0 if it is empty. The names are hashed in lower case, so the table does
+// not depend on case sensitivity.
+//
+bool MathParser::VariableExists(const wchar_t* pName, size_t iLength, size_t* index) const
+{
+    if (var_index.empty()) return false;
+
+    // names differing only in case can both be found after SetCaseSensitive(false):
+    // the first variable matches, as when the variables were searched in order
+
+    const auto iMask{ var_index.size() - 1 };
+    auto iFound{ NumberOfVars() };
+
+    for (auto iSlot{ MathLexeme::NameHash(pName, iLength) & iMask }; var_index[iSlot] != 0;
+        iSlot = (iSlot + 1) & iMask)
+    {
+        const auto iVar{ var_index[iSlot] - 1 };
+
+        if (iVar < iFound &&
+            MathLexeme::IsNameEqual(pName, iLength, user_vars[iVar].data(), case_sensitive))
+            iFound = iVar;
+    }
+
+    if (iFound == NumberOfVars()) return false;
+
+    if (index != nullptr) *index = iFound;
+    return true;
+}
+
+bool MathParser::VarNameInUse(const wchar_t* pName, size_t iLength) const
+{
+    return FunctionExists(pName, iLength) || ConstantExists(pName, iLength) ||
+        VariableExists(pName, iLength);
+}
+
+// Add nth variable to var_index, growing the table when it gets half full
+//
+void MathParser::IndexVar(size_t iIndex)
+{
+    if (2 * NumberOfVars() > var_index.size())
+    {
+        IndexAllVars();
+        return;
+    }
+
+    const auto& wstr{ user_vars[iIndex] };
+    const auto iMask{ var_index.size() - 1 };
+    auto iSlot{ MathLexeme::NameHash(wstr.data(), wstr.size()) & iMask };
+
+    while (var_index[iSlot] != 0) iSlot = (iSlot + 1) & iMask;
+
+    var_index[iSlot] = iIndex + 1;
+}
+
+void MathParser::IndexAllVars()
+{
+    size_t iSize{ 16 };
+
+    while (iSize < 2 * NumberOfVars()) iSize *= 2;
+
+    var_index.assign(iSize, 0);
+
+    for (size_t it = 0; it < NumberOfVars(); ++it) IndexVar(it);
+}
+
+bool MathParser::IsVarNameValid(const wstring& wstr)
+{
+    const auto str_len{ wstr.size() };
+
+    if (str_len == 0) return false;
+
+    if (!IsFirstChar(wstr[0]))
+        return false;
+    else
+        for (size_t it = 1; it < str_len; ++it)
+            if (!IsNextChar(wstr[it]))
+                return false;
+
+    return true;
+}
+
+void MathParser::EvaluateBinaryOp(MyStack& Stack)
+{
+    MathLexeme Op1{}, Op2{}, Sign{};
+    Stack.Pop(Op2);
+    Stack.Pop(Sign);
+    Stack.Pop(Op1);
+
+    switch (Sign.iItem)
+    {
+    case MathLexeme::Plus:
+        Op1.dValue += Op2.dValue;
+        break;
+
+    case MathLexeme::Minus:
+        Op1.dValue -= Op2.dValue;
+        break;
+
+    case MathLexeme::Multiply:
+        Op1.dValue *= Op2.dValue;
+        break;
+
+    case MathLexeme::Divide:
+        Op1.dValue /= Op2.dValue;
+        break;
+
+    default:
+        // case MathLexeme :: Power
+        Op1.dValue = MathLexeme::mypow(Op1.dValue, Op2.dValue);
+        break;
+    }
+
+    CheckForFloatingPointError(Op1.dValue);
+
+    Stack.Push(Op1);
+}
+
+void MathParser::CheckForFloatingPointError(double value)
+{
+#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+    if (!isfinite(value)) throw FloatingPointError(value);
+
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+}
+
+MathParser::ErrorCodes MathParser::FloatingPointError(double value)
+{
+    if (isnan(value))
+        return FloatingPointErrorNaN;
+    else
+        if (value > 0)
+            return FloatingPointErrorPosInf;
+        else
+            return FloatingPointErrorNegInf;
+}
+
+void MathParser::GetLexCheckSyntax(
+    MathParser::LexerMode LexerMode,
+    size_t& iFirstSymbol,
+    const wchar_t* pString,
+    size_t& iCurrentPosition,
+    MathLexeme& CurrentLexeme,
+    MathLexeme& PreviousLexeme,
+    long long int& iParBalance,
+    const double* rgdArguments,
+    MyStack& Stack
+) const
+{
+    PreviousLexeme = CurrentLexeme;
+
+    // skip blanks
+
+    size_t iFirstSpace = iCurrentPosition;
+    while (pString[iCurrentPosition] == ' ' ||
+        pString[iCurrentPosition] == '\t') ++iCurrentPosition;
+
+    iFirstSymbol = iCurrentPosition;
+    wchar_t cCurrentChar(pString[iCurrentPosition]);
+
+    switch (cCurrentChar)
+    {
+
+    // end of line
+
+    case '\0':
+        CurrentLexeme.iType = MathLexeme::End;
+        iFirstSymbol = iFirstSpace;
+        //--iCurrentPosition;
+
+        if (LexerMode != ParseMode)
+            if (PreviousLexeme.iType == MathLexeme::Begin)
+                Stack.Push(MathLexeme(MathLexeme::Number, MathLexeme::Constant, 0.0));
+        break;
+
+    // signs (assume now they are all binary; check for unary later)
+
+    case '+':
+        CurrentLexeme.iType = MathLexeme::Binary;
+        CurrentLexeme.iItem = MathLexeme::Plus;
+        CurrentLexeme.iPosition = iFirstSymbol;
+        break;
+
+    case '-':
+        CurrentLexeme.iType = MathLexeme::Binary;
+        CurrentLexeme.iItem = MathLexeme::Minus;
+        CurrentLexeme.iPosition = iFirstSymbol;
+        break;
+
+    case '*':
+        CurrentLexeme.iType = MathLexeme::Binary;
+        CurrentLexeme.iItem = MathLexeme::Multiply;
+        CurrentLexeme.iPosition = iFirstSymbol;
+
+#ifdef MATH_PARSER_DOUBLE_ASTERISK_ALLOWED
+
+        if (pString[++iCurrentPosition] == '*')
+            CurrentLexeme.iItem = MathLexeme::Power;
+        else --iCurrentPosition;
+
+#endif //MATH_PARSER_DOUBLE_ASTERISK_ALLOWED
+
+        break;
+
+    case '/':
+
+#ifdef MATH_PARSER_COLON_ALLOWED
+
+    case ':':
+
+#endif //MATH_PARSER_COLON_ALLOWED
+
+        CurrentLexeme.iType = MathLexeme::Binary;
+        CurrentLexeme.iItem = MathLexeme::Divide;
+        CurrentLexeme.iPosition = iFirstSymbol;
+        break;
+
+    case '^':
+        CurrentLexeme.iType = MathLexeme::Binary;
+        CurrentLexeme.iItem = MathLexeme::Power;
+        CurrentLexeme.iPosition = iFirstSymbol;
+        break;
+
+    // parentheses
+
+    case '(':
+        CurrentLexeme.iType = MathLexeme::LeftPar;
+        ++iParBalance;
+        break;
+
+    case ')':
+        // check balance
+        if (iParBalance <= 0) throw ExtraRightPar;
+
+        CurrentLexeme.iType = MathLexeme::RightPar;
+        --iParBalance;
+        break;
+
+    // possibly number, variable or function
+
+    default:
+        if (cCurrentChar == '0' ||
+            (cCurrentChar >= '1' && cCurrentChar <= '9') ||
+            cCurrentChar == '.')
+        {
+            // possibly number, read in place
+
+            auto fExpFound{ false }, fPointFound{ false }, fSignFound{ false };
+            for ( ; ; )
+            {
+                cCurrentChar = pString[iCurrentPosition];
+
+                if ((cCurrentChar >= '1' && cCurrentChar <= '9') || cCurrentChar == '0')
+                    ++iCurrentPosition;
+                else
+                    if (cCurrentChar == 'e' || cCurrentChar == 'E')
+                    {
+                        if (fExpFound)
+                        {
+                            --iCurrentPosition;
+                            break;
+                        }
+                        else
+                        {
+                            ++iCurrentPosition;
+                            fExpFound = true;
+                        }
+                    }
+                    else
+                        if (cCurrentChar == '.')
+                        {
+                            if (fPointFound)
+                            {
+                                --iCurrentPosition;
+                                break;
+                            }
+                            else
+                            {
+                                ++iCurrentPosition;
+                                fPointFound = true;
+                            }
+                        }
+                        else
+                            if (cCurrentChar == '+' || cCurrentChar == '-')
+                            {
+
+                                // check whether +/- belongs to the exponent or next lexeme
+
+                                if (pString[iCurrentPosition - 1] == 'e' ||
+                                    pString[iCurrentPosition - 1] == 'E')
+                                {
+                                    if (fSignFound)
+                                    {
+                                        --iCurrentPosition;
+                                        break;
+                                    }
+                                    else
+                                    {
+                                        ++iCurrentPosition;
+                                        fSignFound = true;
+                                    }
+                                }
+                                else
+                                {
+                                    --iCurrentPosition;
+                                    break;
+                                }
+                            }
+                            else
+                            {
+                                --iCurrentPosition;
+                                break;
+                            }
+
+            } // for
+
+            // possibly got a number, check it
+
+            if (DecimalNumber::Read(pString + iFirstSymbol, iCurrentPosition + 1 - iFirstSymbol,
+                CurrentLexeme.dValue))
+            {
+                CurrentLexeme.iType = MathLexeme::Number;
+                CurrentLexeme.iItem = MathLexeme::Constant;
+                CurrentLexeme.iPosition = iFirstSymbol;//is this needed? - can be inf/NaN
+                // check here for inf/nan and throw floating point error
+
+                if (LexerMode != ParseMode)
+                    CheckForFloatingPointError(CurrentLexeme.dValue);
+            }
+            else throw MathParser::InvalidNumber;
+
+        } // if
+
+        else // not a number, possibly function, constant or variable
+
+            if (IsFirstChar(cCurrentChar))
+            {
+                while (IsNextChar(pString[iCurrentPosition])) ++iCurrentPosition;
+                --iCurrentPosition;
+
+                // check for matching names (functions, constants, variables)
+
+                const auto (*const pName) { pString + iFirstSymbol };
+                const auto iLength{ iCurrentPosition + 1 - iFirstSymbol };
+                size_t iIndex{ 0 };
+
+                if (FunctionExists(pName, iLength, &iIndex)) // check for matching functions
+                {
+                    CurrentLexeme.iType = MathLexeme::Function;
+                    CurrentLexeme.iItem = static_cast<int>(iIndex);
+                    CurrentLexeme.pFunction = MathLexeme::FunctionAddress[iIndex];
+                    CurrentLexeme.iPosition = iFirstSymbol; // is this needed?
+                }
+                else // no function matches, check for built-in constants
+                    if (ConstantExists(pName, iLength, &iIndex))
+                    {
+                        CurrentLexeme.iType = MathLexeme::Number;
+                        CurrentLexeme.iItem = MathLexeme::Constant;
+                        CurrentLexeme.dValue = MathLexeme::ConstantValue[iIndex];
+                    }
+                    else // no constant matches, check for user-defined variables (no check for Parse)
+                        if (LexerMode == ParseMode || VariableExists(pName, iLength, &iIndex))
+                        {
+                            CurrentLexeme.iType = MathLexeme::Number;
+                            CurrentLexeme.iItem = MathLexeme::Variable;
+                            CurrentLexeme.iRunTimeIndex = iIndex;
+
+                            if (LexerMode == EvaluateMode)
+                                CurrentLexeme.dValue = rgdArguments[iIndex];
+                        }
+                        else throw UnknownIdentifier; // no matches
+
+            } // if IsFirstChar
+
+            else // invalid character
+                throw InvalidCharacter;
+
+    } // switch (cCurrentChar)
+
+    ++iCurrentPosition;
+
+    // got a lexeme, now check syntax
+
+    // Check if a binary sign is actually unary
+
+    if (CurrentLexeme.iType == MathLexeme::Binary)
+        if (CurrentLexeme.iItem == MathLexeme::Plus ||
+            CurrentLexeme.iItem == MathLexeme::Minus)
+            if (Expected[PreviousLexeme.iType][MathLexeme::Unary])
+                CurrentLexeme.iType = MathLexeme::Unary;
+
+    // Check syntax
+
+    if (!Expected[PreviousLexeme.iType][CurrentLexeme.iType])
+        switch (PreviousLexeme.iType)
+        {
+        case MathLexeme::Begin:
+
+#ifndef MATH_PARSER_EMPTY_STRING_ALLOWED
+
+            if (CurrentLexeme.iType == MathLexeme::End)
+                throw EmptyString;
+            else
+
+#endif //MATH_PARSER_EMPTY_STRING_ALLOWED
+
+                throw ExpectedRealFunUnSignLeftPar;
+
+        case MathLexeme::LeftPar:
+            throw ExpectedRealFunUnSignLeftPar;
+
+        case MathLexeme::Unary:
+        case MathLexeme::Binary:
+            throw ExpectedRealFunLeftPar;
+
+        case MathLexeme::Number:
+        case MathLexeme::RightPar:
+            if (CurrentLexeme.iType == MathLexeme::LeftPar)
+                throw iParBalance > 1 ? ExpectedBiSignRightPar : ExpectedBiSign;
+            else
+                throw iParBalance > 0 ? ExpectedBiSignRightPar : ExpectedBiSign;
+
+        default:
+            // case MathLexeme::Function:
+            throw ExpectedLeftPar;
+        }
+}
+
+// Check and increase if necessary the lexer buffer, the stack and the runtime
+// memory used by Execute, based off the longest string and the number of
+// user variables
+//
+void MathParser::AdjustContext(ExecutionContext& Context) const
+{
+    // the stack and the memory are created when the context is used for the first time
+
+    auto required_stack_size = iMaxStringLength + 2; // was 2*iNewStringLength + 2
+
+    if (Context.Stack.iCurrentStackSize < required_stack_size)
+    {
+        constexpr size_t stack_size_extra{ 128 }; // 0 == test value, to be increased
+        required_stack_size += stack_size_extra;
+
+        Context.Stack.Resize(required_stack_size);
+    }
+
+    constexpr size_t min_runtime_mem{ 128 }; // 1 == test value, to be increased
+    auto required_runtime_mem{ min_runtime_mem };
+
+    if (required_runtime_mem < iMaxStringLength + 1)
+        required_runtime_mem = iMaxStringLength + 1;
+
+    auto& runtime_mem{ Context.runtime_mem };
+
+    if (runtime_mem.size() < required_runtime_mem)
+    {
+        constexpr size_t runtime_mem_extra{ 128 }; // 0 == test value, to be increased
+        const auto current_runtime_mem = required_runtime_mem + runtime_mem_extra;
+
+        runtime_mem.resize(current_runtime_mem);
+    }
+}
+
+void MathParser::CompileBinaryOp(MyStack& Stack)
+{
+    MathLexeme Op1{}, Op2{}, Sign{};
+    Stack.Pop(Op2);
+    Stack.Pop(Sign);
+    Stack.Pop(Op1);
+
+    if (Op1.iItem == MathLexeme::Constant)
+    {
+        if (Op2.iItem == MathLexeme::Constant)
+        {
+            // both operands' values are known at the time of compilation,
+            // therefore just evaluate the operation, nothing to compile
+
+            switch (Sign.iItem)
+            {
+            case MathLexeme::Plus:
+                Op1.dValue += Op2.dValue;
+                break;
+
+            case MathLexeme::Minus:
+                Op1.dValue -= Op2.dValue;
+                break;
+
+            case MathLexeme::Multiply:
+                Op1.dValue *= Op2.dValue;
+                break;
+
+            case MathLexeme::Divide:
+                Op1.dValue /= Op2.dValue;
+                break;
+
+            default:
+                // case MathLexeme::Power
+                Op1.dValue = MathLexeme::mypow(Op1.dValue, Op2.dValue);
+            }
+
+            CheckForFloatingPointError(Op1.dValue);
+
+            Stack.Push(Op1);
+
+        } // if both are constants
+        else
+        {
+            // Op2's value is not known now
+            // produce const+mem operation
+
+            EmitCommand(CompiledCommand::PlusConstMem + Sign.iItem, iMemoryCounter,
+                EmitConstant(Op1.dValue), Op2.iRunTimeIndex, Sign.iPosition);
+
+            Op2.iRunTimeIndex = iMemoryCounter++;
+            Stack.Push(Op2);
+        }
+    }
+    else
+    {
+        if (Op2.iItem == MathLexeme::Constant)
+        {
+            // Op1's value is not known now
+            // produce mem+const operation
+
+            EmitCommand(CompiledCommand::PlusMemConst + Sign.iItem, iMemoryCounter,
+                Op1.iRunTimeIndex, EmitConstant(Op2.dValue), Sign.iPosition);
+
+            Op1.iRunTimeIndex = iMemoryCounter++;
+            Stack.Push(Op1);
+        }
+        else
+        {
+            // neither value is known
+            // produce mem+mem operation
+
+            EmitCommand(CompiledCommand::PlusMemMem + Sign.iItem, iMemoryCounter,
+                Op1.iRunTimeIndex, Op2.iRunTimeIndex, Sign.iPosition);
+
+            Op1.iRunTimeIndex = iMemoryCounter++;
+            Stack.Push(Op1);
+        }
+    }
+}
+
+// Append a command to the program being compiled
+//
+void MathParser::EmitCommand(
+    int iOpCode, size_t iResult, size_t iFirstOperand, size_t iSecondOperand,
+    size_t iErrorPosition)
+{
+    pCompiledProgram->code.emplace_back(static_cast<CompiledCommand::OpCodes>(iOpCode),
+        iResult, iFirstOperand, iSecondOperand);
+    pCompiledProgram->error_positions.push_back(iErrorPosition);
+}
+
+// Append a value to the constant pool of the program being compiled.
+// Returns its index.
+//
+size_t MathParser::EmitConstant(double dValue)
+{
+    pCompiledProgram->constants.push_back(dValue);
+    return pCompiledProgram->constants.size() - 1;
+}
+
+// Append the commands computing function iFunction of mem[iOperand] to
+// the program being compiled. Returns the memory index of the result.
+// sqrt, abs and int have inline opcodes. sec(x) is 1 / cos(x), and so on:
+// the same value, with a cheaper call that can be shared with cos(x).
+// Not sech and csch, since cosh and sinh overflow where their reciprocals
+// do not. A function with two names (sh and sinh...) gets one index, so that
+// the two are shared.
+//
+size_t MathParser::EmitFunction(size_t iFunction, size_t iOperand, size_t iErrorPosition)
+{
+    auto Reciprocal = [&](size_t iReciprocalFunction)
+    {
+        const auto iDivisor{ EmitFunction(iReciprocalFunction, iOperand, iErrorPosition) };
+
+        EmitCommand(CompiledCommand::DivideConstMem, iMemoryCounter,
+            EmitConstant(1.0), iDivisor, iErrorPosition);
+        return iMemoryCounter++;
+    };
+
+    auto iOpCode{ CompiledCommand::CallFunction };
+
+    switch (iFunction)
+    {
+    case MathLexeme::Sec:   return Reciprocal(MathLexeme::Cos);
+    case MathLexeme::Csc:   return Reciprocal(MathLexeme::Sin);
+    case MathLexeme::Ctg:
+    case MathLexeme::Cot:   return Reciprocal(MathLexeme::Tan);
+    case MathLexeme::Cth:
+    case MathLexeme::Coth:  return Reciprocal(MathLexeme::Tanh);
+
+    case MathLexeme::Log:   iFunction = MathLexeme::Lg;     break;
+    case MathLexeme::Tg:    iFunction = MathLexeme::Tan;    break;
+    case MathLexeme::Sh:    iFunction = MathLexeme::Sinh;   break;
+    case MathLexeme::Ch:    iFunction = MathLexeme::Cosh;   break;
+    case MathLexeme::Th:    iFunction = MathLexeme::Tanh;   break;
+
+    case MathLexeme::Sqrt:  iOpCode = CompiledCommand::SqrtMem;     break;
+    case MathLexeme::Abs:   iOpCode = CompiledCommand::AbsMem;      break;
+    case MathLexeme::Int:   iOpCode = CompiledCommand::FloorMem;    break;
+    }
+
+    EmitCommand(iOpCode, iMemoryCounter, iOperand, iFunction, iErrorPosition);
+    return iMemoryCounter++;
+}
+
+void MathParser::InvalidateCompiledCode(size_t ind)
+{
+    auto& Program{ compiled_code[ind] };
+
+    Program.code.assign(1, CompiledCommand{});
+    Program.constants.clear();
+    Program.error_positions.assign(1, 0);
+    Program.variables.clear();
+    Program.native = NativeCode{};
+    Program.fFastMath = false;
 }
\ No newline at end of file
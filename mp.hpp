@@ -1,426 +1,948 @@
-//
-// MathParser class declaration
-//
-
-#pragma once
-
-#include <vector>
-#include <string>
-#include "mp_mystack.hpp"
-
-using std::vector;
-using std::wstring;
-
-struct CompiledCommand;
-
-//
-//
-// MathParser class can parse, evaluate and compile math expressions such as
-//     (sin(x1)^2 + cos(y1)^2)^(-1) + z
-// 
-// It also serves as a container for the expressions, user variable names and
-// compiled code.
-// 
-// More details below.
-//
-//
-
-// Allow/disallow empty strings (spaces/tabs) as grammatically correct
-// (they'll evaluate to 0)
-#define MATH_PARSER_EMPTY_STRING_ALLOWED
-
-// "**" as a power sign allowed/not allowed (the regular power sign '^' is always allowed)
-#define MATH_PARSER_DOUBLE_ASTERISK_ALLOWED
-
-// ':' as a division sign allowed/not allowed (the regular division sign '/' is always allowed)
-#define MATH_PARSER_COLON_ALLOWED
-
-// Makes the parser check for floating point errors including constants
-#define MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
-
-class MathParser {
-
-public:
-
-    // Codes returned by Parse, Evaluate, Compile, Execute, CheckVar
-    // and CheckAndInsertVar
-
-    enum ErrorCodes {                   // used by:
-
-        OK,                             // Pa, Ev, Co, Ex, CV, CIV
-        WrongIndex,                     // Pa, Ev, Co
-        InvalidNumber,                  // Pa, Ev, Co
-        UnknownIdentifier,              // Pa, Ev, Co
-        InvalidIdentifier,              // CV, CIV
-        InvalidCharacter,               // Pa, Ev, Co
-        EmptyString,                    // Pa, Ev, Co
-        ExpectedRealFunUnSignLeftPar,   // Pa, Ev, Co
-        ExpectedRealFunLeftPar,         // Pa, Ev, Co
-        ExpectedBiSignRightPar,         // Pa, Ev, Co
-        ExpectedBiSign,                 // Pa, Ev, Co
-        ExpectedLeftPar,                // Pa, Ev, Co
-        ExpectedRightPar,               // Pa, Ev, Co
-        ExtraRightPar,                  // Pa, Ev, Co
-        FloatingPointErrorPosInf,       // Ev, Co, Ex
-        FloatingPointErrorNegInf,       // Ev, Co, Ex
-        FloatingPointErrorNaN,          // Ev, Co, Ex
-        IdentifierInUse                 // CV, CIV
-    };
-
-    explicit MathParser(bool case_sensitive);
-    MathParser() = delete;
-    ~MathParser() = default;
-
-    MathParser(const MathParser&) = delete;
-    MathParser(MathParser&&) = delete;
-    MathParser& operator = (const MathParser&) = delete;
-    MathParser& operator = (MathParser&&) = delete;
-
-    //
-    //
-    // Main functionality of the class: Parse/Evaluate/Compile/Execute.
-    // iIndex refers to the nth string stored in the MathParser object.
-    // In case of error, its position is stored in iErrorPosition.
-    //
-    // Compile/Execute are meant to be used together, and the result is 
-    // identical to Evaluate. You can Compile a string once and then Execute
-    // it multiple times with different argument sets, which is more efficient
-    // than calling Execute for each argument set.
-    //
-    //
-
-    // Check the syntax of a string with the specified index without evaluating it.
-    // Parse does not require user variables to be inserted.
-    // Returns OK if the syntax is OK, otherwise -- one of the error codes above.
-    //
-    ErrorCodes Parse(size_t& iErrorPosition, size_t iIndex = 0);
-
-    // Evaluate the string with the specified index.
-    // The values of the user-defined arguments need supplied in args.
-    // On success returns OK and stores the result in dValue.
-    // Otherwise, returns one of the error codes above.
-    //
-    ErrorCodes Evaluate(
-        size_t& iErrorPosition, const vector<double>& args,
-        double& dValue, size_t iIndex = 0);
-
-    // Compile the string with the specified index into internal code to be used
-    // by Execute. On success returns OK, otherwise returns one of the
-    // error codes above. 
-    //
-    ErrorCodes Compile(size_t& iErrorPosition, size_t iIndex = 0);
-
-    // Execute the internal code produced by Compile with the same index.
-    // The values of the user-defined arguments need supplied in args.
-    // Client should check that Compile has returned OK.
-    // On success returns OK and stores the result in dValue.
-    // Otherwise, returns FloatingPointError if this option is enabled.
-    // No checks on validity of pointers - use IsExecutionAllowed prior to.
-    //
-    ErrorCodes Execute(
-        size_t& iErrorPosition, const vector<double>& args,
-        double& dValue, size_t iIndex = 0);
-
-    //
-    // 
-    // Before strings can be Parsed/Evaluated/Compiled/Executed, they need inserted
-    // into the MathParser object. These functions handle manipulations with strings.
-    //
-    //
-
-    // Insert a string at the position designated by iRequestedIndex.
-    // The internal semantics is a list of strings, therefore, iRequestedIndex
-    // should be in the range [0, NumberOfStrings() - 1]. If its value is higher
-    // then the string will be inserted at the position NumberofStrings().
-    // The actual assigned index is returned in iAssignedIndex.
-    //
-    void InsertString(
-        wstring&& wstr, size_t iRequestedIndex, size_t& iAssignedIndex);
-
-    // Return nth stored string using vector's at().
-    // Should be 0 <= iIndex < NumberOfStrings(),
-    // otherwise vector throws an exception.
-    //
-    const wchar_t* String(size_t iIndex) const;
-
-    // Return nth stored string using vector's operator[]
-    // should be 0 <= iIndex < NumberOfStrings(),
-    // otherwise behavior undefined.
-    //
-    const wchar_t* operator[](size_t iIndex) const;
-    
-    // Remove nth string.
-    // Should be 0 <= iIndex < NumberOfStrings()
-    // otherwise throws an exception.
-    //
-    void RemoveString(size_t iIndex);
-
-    // The current number of stored strings
-    //
-    size_t NumberOfStrings() const;
-
-    //
-    //
-    // Strings can contain user-defined variables, such as x1 in "sin(x1)^2".
-    // Such user-defined variables need inserted into the MathParser object.
-    // User-defined variable names can contain letters, digits and underscore, and
-    // cannot begin with a digit.
-    //
-    //
-
-    // A helper to remove leading and trailing blanks (' ' and '\t').
-    // Returns the length of the resulting string.
-    //
-    static size_t TrimVarName(wstring&);
-
-    // Check if this is a valid variable name.
-    // Return value =
-    //    = InvalidIdentifier if wstr does not contain a valid variable name
-    //    = IdentifierInUse if wstr contains a valid name but it is already in use
-    //    = otherwise it is OK
-    //
-    ErrorCodes CheckVar(const wstring&) const;
-
-    // Check if this is a valid variable name, and if so, insert it.
-    // Return value =
-    //    = InvalidIdentifier if wstr does not contain a valid variable name
-    //    = IdentifierInUse if wstr contains a valid name but it is already in use
-    //    = otherwise it is OK
-    //
-    // If OK then the variable is inserted.
-    //
-    ErrorCodes CheckAndInsertVar(
-        wstring&& wstr, size_t iRequestedIndex, size_t& iAssignedIndex);
-
-    // Return nth stored variable name
-    //
-    const wchar_t* Var(size_t iIndex) const;
-
-    // Remove nth variable.
-    // Should be 0 <= iIndex < NumberOfStrings()
-    // otherwise throws an exception.
-    //
-    void RemoveVar(size_t iIndex);
-
-    // Remove all variables.
-    //
-    void RemoveAllVars();
-
-    // The current number of stored strings
-    //
-    size_t NumberOfVars() const;
-    
-    //
-    //
-    // Other functions
-    //
-    //
-    
-    // Check if nth string can be Executed (internal representation contains valid
-    // code). No need to do this check if the last call to Compile on
-    // the same string returned OK.
-    //
-    bool OKtoExecute(size_t iIndex = 0) const;
-
-    // Case sensitivity is set in the constructor, and can be checked/changed at runtime.
-    //
-    bool IsCaseSensitive() const;
-    void SetCaseSensitive(bool case_sensitive);
-
-private:
-
-    int mp_str_cmp(const wchar_t*, const wchar_t*) const;
-    static inline bool IsFirstChar(wchar_t);
-    static inline bool IsNextChar(wchar_t);
-    bool FunctionExists(const wchar_t*, size_t* = nullptr) const;
-    bool ConstantExists(const wchar_t*, size_t* = nullptr) const;
-    bool VariableExists(const wchar_t*, size_t* = nullptr) const;
-    bool VarNameInUse(const wchar_t*) const;
-    static bool IsVarNameValid(const wstring&);
-    void EvaluateBinaryOp();
-    static inline void CheckForFloatingPointError(double);
-
-    enum LexerMode {ParseMode, EvaluateMode, CompileMode};
-    void GetLexCheckSyntax(
-        MathParser::LexerMode LexerMode,
-        size_t& iFirstSymbol,
-        const wchar_t* pString,
-        wchar_t* pBuffer,
-        size_t& iCurrentPosition,
-        size_t& iBufferPosition,
-        MathLexeme& CurrentLexeme,
-        MathLexeme& PreviousLexeme,
-        long long int& iParBalance,
-        const double* rgdArguments
-    );
-
-    void AdjustRunTimeMem();
-    void CompileBinaryOp();
-    void InvalidateCompiledCode(size_t);
-
-    vector<wstring> input_strings;
-    vector<wstring> user_vars;
-    MyStack         Stack;
-    vector<wchar_t> lexer_buffer;
-    bool            case_sensitive;
-
-    static const bool Expected[8][8];
-
-    vector<vector<CompiledCommand>> compiled_code;
-    vector<double>  runtime_mem;
-    size_t          iCommandCounter; // counter of produced commands
-    size_t          iMemoryCounter;  // counter of used runtime memory
-    CompiledCommand*pCompiledCode;   // shortcut to the member of CompiledCode being used
-};
-
-// Internal representation of commands used by Compile/Execute
-//
-struct CompiledCommand {
-
-    friend class MathParser;
-
-    CompiledCommand() = default; // used by std::vector allocators
-
-private:
-
-    // different signatures are used to produce different types of commands
-    //
-    CompiledCommand(
-        size_t iFirstOperand, double dValue, size_t iResult,
-        size_t iBinaryOp, size_t iErrorPosition);
-    CompiledCommand(
-        double dValue, size_t iSecondOperand, size_t iResult,
-        size_t iBinaryOp, size_t iErrorPosition);
-    CompiledCommand(
-        size_t iFirstOperand, size_t iSecondOperand, size_t iResult,
-        size_t iBinaryOp, size_t iErrorPosition);
-    CompiledCommand(
-        size_t iFirstOperand, size_t iResult, double (*pFunction)(double),
-        size_t iErrorPosition);
-    CompiledCommand(size_t iFirstOperand);
-    CompiledCommand(double dValue);
-    CompiledCommand(bool);
-
-    // 3 flags indicate the type of the command
-    // mem+const:       f1==true, f2==true, (f3==false)
-    // const+mem:       f1==true, f2==false, (f3==false)
-    // mem+mem:         f2==false, f2==true, f3 not used
-    // function call:   f1==false, f2==false, f3==true
-    // end:             f1==false, f2==false, f3==false
-    // 
-    // f3 is not used by MathParser::Execute in the case of mem+const
-    // or const+mem command, but it should be set to false for these
-    // commands, because the "command" with the following combination:
-    //
-    // error:			f1==true, f3==true
-    //
-    // will be output in case of unsuccessful compilation.
-    // OKtoExecute will check for this combination.
-
-    const bool      fFlag1{}, fFlag2{}, fFlag3{};
-
-    const size_t    iFirstOperand{}, iSecondOperand{}, iResult{};
-    const double    dValue{};
-    const size_t    iBinaryOp{};
-    double          (*const pFunction)(double) {};
-    const bool      fResultInMemory{}; // == true if the result of Execute should be taken from memory
-    const size_t    iErrorPosition{};
-};
-
-inline const wchar_t* MathParser::String(size_t iIndex) const
-{
-    return input_strings.at(iIndex).data();
-}
-
-inline const wchar_t* MathParser::operator[](size_t iIndex) const
-{
-    return input_strings[iIndex].data();
-}
-
-inline size_t MathParser::NumberOfStrings() const
-{
-    return input_strings.size();
-}
-
-inline const wchar_t* MathParser::Var(size_t iIndex) const
-{
-    return user_vars[iIndex].data();
-}
-
-inline size_t MathParser::NumberOfVars() const
-{
-    return user_vars.size();
-}
-
-inline int MathParser::mp_str_cmp(const wchar_t* str1, const wchar_t* str2) const
-{
-    return case_sensitive ? wcscmp(str1, str2) : _wcsicmp(str1, str2);
-}
-
-inline bool MathParser::IsFirstChar(wchar_t c)
-{
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
-}
-
-inline bool MathParser::IsNextChar(wchar_t c)
-{
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
-        (c >= '1' && c <= '9') || c == '0' || c == '_';
-}
-
-// will produce mem+const command
-inline CompiledCommand::CompiledCommand(
-    size_t iFirstOperand, double dValue, size_t iResult,
-    size_t iBinaryOp, size_t iErrorPosition)
-    : iFirstOperand(iFirstOperand), dValue(dValue), iResult(iResult),
-    iBinaryOp(iBinaryOp), fFlag1(true), fFlag2(true), fFlag3(false),
-    iErrorPosition(iErrorPosition)
-{
-}
-
-// will produce const+mem command
-inline CompiledCommand::CompiledCommand(
-    double dValue, size_t iSecondOperand, size_t iResult,
-    size_t iBinaryOp, size_t iErrorPosition)
-    : dValue(dValue), iSecondOperand(iSecondOperand), iResult(iResult),
-    iBinaryOp(iBinaryOp), fFlag1(true), fFlag2(false), fFlag3(false),
-    iErrorPosition(iErrorPosition)
-{
-}
-
-// will produce mem+mem command
-inline CompiledCommand::CompiledCommand(
-    size_t iFirstOperand, size_t iSecondOperand, size_t iResult,
-    size_t iBinaryOp, size_t iErrorPosition)
-    : iFirstOperand(iFirstOperand), iSecondOperand(iSecondOperand), iResult(iResult),
-    iBinaryOp(iBinaryOp), fFlag1(false), fFlag2(true),
-    iErrorPosition(iErrorPosition)
-{
-}
-
-// will produce function call command
-inline CompiledCommand::CompiledCommand(
-    size_t iFirstOperand, size_t iResult, double (*pFunction)(double), size_t iErrorPosition)
-    : iFirstOperand(iFirstOperand), iResult(iResult), pFunction(pFunction),
-    fFlag1(false), fFlag2(false), fFlag3(true), iErrorPosition(iErrorPosition)
-{
-}
-
-// will produce end command, final result taken from memory
-inline CompiledCommand::CompiledCommand(size_t iFirstOperand)
-    : iFirstOperand(iFirstOperand), fFlag1(false), fFlag2(false), fFlag3(false),
-    fResultInMemory(true)
-{
-}
-
-// will produce end command, final result taken is known at the time of compilation
-inline CompiledCommand::CompiledCommand(double dValue)
-    : dValue(dValue), fFlag1(false), fFlag2(false), fFlag3(false),
-    fResultInMemory(false)
-{
-}
-
-// will produce error token
-inline CompiledCommand::CompiledCommand(bool) : fFlag1(true), fFlag3(true)
-{
+//
+// MathParser class declaration
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include "mp_mystack.hpp"
+#include "mp_jit.hpp"
+
+using std::vector;
+using std::wstring;
+
+struct CompiledCommand;
+struct CompiledProgram;
+struct FusedProgram;
+struct ValueRange;
+struct VarBinding;
+
+//
+// Scratch memory used by Parse, Evaluate, Execute and ExecuteBatch.
+//
+// MathParser has its own context, used by the functions without a context
+// parameter. Threads sharing one MathParser call the overloads taking
+// an ExecutionContext, each thread with its own context. These overloads are
+// const and only read the MathParser object, so they can run concurrently as
+// long as no other function modifies the object in the meantime.
+// The context grows as needed when it is used.
+//
+class ExecutionContext {
+
+    friend class MathParser;
+
+public:
+
+    ExecutionContext() = default;
+    ~ExecutionContext() = default;
+
+    ExecutionContext(const ExecutionContext&) = delete;
+    ExecutionContext(ExecutionContext&&) = delete;
+    ExecutionContext& operator = (const ExecutionContext&) = delete;
+    ExecutionContext& operator = (ExecutionContext&&) = delete;
+
+private:
+
+    MyStack         Stack;
+    vector<double>  runtime_mem;
+    vector<double>  batch_mem;      // intermediate columns used by ExecuteBatch
+};
+
+//
+//
+// MathParser class can parse, evaluate and compile math expressions such as
+//     (sin(x1)^2 + cos(y1)^2)^(-1) + z
+// 
+// It also serves as a container for the expressions, user variable names and
+// compiled code.
+// 
+// More details below.
+//
+//
+
+// Allow/disallow empty strings (spaces/tabs) as grammatically correct
+// (they'll evaluate to 0)
+#define MATH_PARSER_EMPTY_STRING_ALLOWED
+
+// "**" as a power sign allowed/not allowed (the regular power sign '^' is always allowed)
+#define MATH_PARSER_DOUBLE_ASTERISK_ALLOWED
+
+// ':' as a division sign allowed/not allowed (the regular division sign '/' is always allowed)
+#define MATH_PARSER_COLON_ALLOWED
+
+// Makes the parser check for floating point errors including constants
+#define MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+// Makes the compiled code check only the values through which a floating point
+// error could otherwise go unnoticed (the final result, a divisor, the argument
+// of most functions...), instead of the result of every command. When one of them
+// is not finite, the row is run again checking every command, so that the error
+// reported is the same. Only with MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS.
+#define MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+
+#ifndef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+#undef MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+// Execute jumps from one command's handler directly to the next one's
+// (computed goto, a GCC/Clang extension); otherwise it uses a switch
+#ifdef __GNUC__
+#define MATH_PARSER_THREADED_CODE
+#endif //__GNUC__
+
+class MathParser {
+
+    friend class StaticMathParser;
+
+public:
+
+    // Codes returned by Parse, Evaluate, Compile, Execute, CheckVar
+    // and CheckAndInsertVar
+
+    enum ErrorCodes {                   // used by:
+
+        OK,                             // Pa, Ev, Co, Ex, CV, CIV
+        WrongIndex,                     // Pa, Ev, Co
+        InvalidNumber,                  // Pa, Ev, Co
+        UnknownIdentifier,              // Pa, Ev, Co
+        InvalidIdentifier,              // CV, CIV
+        InvalidCharacter,               // Pa, Ev, Co
+        EmptyString,                    // Pa, Ev, Co
+        ExpectedRealFunUnSignLeftPar,   // Pa, Ev, Co
+        ExpectedRealFunLeftPar,         // Pa, Ev, Co
+        ExpectedBiSignRightPar,         // Pa, Ev, Co
+        ExpectedBiSign,                 // Pa, Ev, Co
+        ExpectedLeftPar,                // Pa, Ev, Co
+        ExpectedRightPar,               // Pa, Ev, Co
+        ExtraRightPar,                  // Pa, Ev, Co
+        FloatingPointErrorPosInf,       // Ev, Co, Ex
+        FloatingPointErrorNegInf,       // Ev, Co, Ex
+        FloatingPointErrorNaN,          // Ev, Co, Ex
+        IdentifierInUse                 // CV, CIV
+    };
+
+    explicit MathParser(bool case_sensitive);
+    MathParser() = delete;
+    ~MathParser() = default;
+
+    MathParser(const MathParser&) = delete;
+    MathParser(MathParser&&) = delete;
+    MathParser& operator = (const MathParser&) = delete;
+    MathParser& operator = (MathParser&&) = delete;
+
+    //
+    //
+    // Main functionality of the class: Parse/Evaluate/Compile/Execute.
+    // iIndex refers to the nth string stored in the MathParser object.
+    // In case of error, its position is stored in iErrorPosition.
+    // Parse/Evaluate/Execute/ExecuteBatch have overloads taking
+    // an ExecutionContext (see above) to be called from multiple threads.
+    //
+    // Compile/Execute are meant to be used together, and the result is 
+    // identical to Evaluate. You can Compile a string once and then Execute
+    // it multiple times with different argument sets, which is more efficient
+    // than calling Execute for each argument set.
+    //
+    //
+
+    // Check the syntax of a string with the specified index without evaluating it.
+    // Parse does not require user variables to be inserted.
+    // Returns OK if the syntax is OK, otherwise -- one of the error codes above.
+    //
+    ErrorCodes Parse(size_t& iErrorPosition, size_t iIndex = 0);
+    ErrorCodes Parse(ExecutionContext&, size_t& iErrorPosition, size_t iIndex = 0) const;
+
+    // Evaluate the string with the specified index.
+    // The values of the user-defined arguments need supplied in args.
+    // On success returns OK and stores the result in dValue.
+    // Otherwise, returns one of the error codes above.
+    //
+    ErrorCodes Evaluate(
+        size_t& iErrorPosition, const vector<double>& args,
+        double& dValue, size_t iIndex = 0);
+    ErrorCodes Evaluate(
+        ExecutionContext&, size_t& iErrorPosition, const vector<double>& args,
+        double& dValue, size_t iIndex = 0) const;
+
+    // Compile the string with the specified index into internal code to be used
+    // by Execute. On success returns OK, otherwise returns one of the
+    // error codes above. 
+    //
+    ErrorCodes Compile(size_t& iErrorPosition, size_t iIndex = 0);
+
+    // Execute the internal code produced by Compile with the same index.
+    // The values of the user-defined arguments need supplied in args.
+    // Client should check that Compile has returned OK.
+    // On success returns OK and stores the result in dValue.
+    // Otherwise, returns FloatingPointError if this option is enabled.
+    // No checks on validity of pointers - use IsExecutionAllowed prior to.
+    //
+    ErrorCodes Execute(
+        size_t& iErrorPosition, const vector<double>& args,
+        double& dValue, size_t iIndex = 0);
+    ErrorCodes Execute(
+        ExecutionContext&, size_t& iErrorPosition, const vector<double>& args,
+        double& dValue, size_t iIndex = 0) const;
+
+    // The indices of the user variables read by the code produced by Compile with
+    // the same index, in increasing order (empty if Compile has failed). Execute
+    // and ExecuteBatch read only these arguments: the other elements of args need
+    // not be set, and the other columns of ExecuteBatch can be null. Like the code,
+    // the list refers to the variables as they were at Compile.
+    //
+    const vector<size_t>& UsedVars(size_t iIndex = 0) const;
+
+    // Execute reading the user variables from where they are bound (see BindVar)
+    // instead of from a vector of arguments, in record iRecord of the bound arrays.
+    // Only the variables listed by UsedVars are read; an unbound one reads as 0.
+    // Otherwise the same as Execute.
+    //
+    ErrorCodes ExecuteBound(
+        size_t& iErrorPosition, double& dValue, size_t iIndex = 0, size_t iRecord = 0);
+    ErrorCodes ExecuteBound(
+        ExecutionContext&, size_t& iErrorPosition, double& dValue,
+        size_t iIndex = 0, size_t iRecord = 0) const;
+
+    // Execute the internal code produced by Compile on iRows argument sets at once.
+    // args holds one column per user variable: args[n][row] is the value of the
+    // nth variable in the given row. The result for each row is stored in
+    // rgdValues[row]. The rows are processed in blocks sized to stay in L1 cache,
+    // so every command is decoded once per block rather than once per row.
+    // For a string compiled with fast math, exp, ln, lg, sin, cos and tan are
+    // computed by vector approximations, within a few ulp of those of Execute.
+    // On success returns OK. Otherwise, returns FloatingPointError if this option
+    // is enabled: iErrorRow is then the first row Execute would fail on, and
+    // iErrorPosition is what Execute would report for it. The values of the rows
+    // preceding iErrorRow are stored anyway.
+    // No checks on validity of pointers - use OKtoExecute prior to.
+    //
+    ErrorCodes ExecuteBatch(
+        size_t& iErrorPosition, size_t& iErrorRow, const vector<const double*>& args,
+        double* rgdValues, size_t iRows, size_t iIndex = 0);
+    ErrorCodes ExecuteBatch(
+        ExecutionContext&, size_t& iErrorPosition, size_t& iErrorRow,
+        const vector<const double*>& args, double* rgdValues, size_t iRows,
+        size_t iIndex = 0) const;
+
+    // A batch for ExecuteBatchJobs: the arguments are the same as ExecuteBatch's,
+    // the error code, position and row are stored in the job when it is done.
+    //
+    struct BatchJob {
+
+        size_t                  iIndex{ 0 };
+        vector<const double*>   args;
+        double*                 rgdValues{ nullptr };
+        size_t                  iRows{ 0 };
+
+        ErrorCodes              iErrorCode{ OK };
+        size_t                  iErrorPosition{ 0 };
+        size_t                  iErrorRow{ 0 };
+    };
+
+    // Execute several batches on up to iThreads cores (0 == all of them).
+    // The rows of each job are split into chunks run by a shared work-stealing
+    // thread pool (mp_pool.hpp), each thread with its own ExecutionContext.
+    // Each job ends up with the same results ExecuteBatch would report for it,
+    // except that the rows following iErrorRow may be computed as well.
+    // Like ExecuteBatch with a context, this can be called concurrently as long
+    // as nothing modifies the object; the calls then take turns on the pool.
+    //
+    void ExecuteBatchJobs(vector<BatchJob>& jobs, size_t iThreads = 0) const;
+
+    // ExecuteBatch split across up to iThreads cores (0 == all of them),
+    // as a single job of ExecuteBatchJobs
+    //
+    ErrorCodes ExecuteBatchParallel(
+        size_t& iErrorPosition, size_t& iErrorRow, const vector<const double*>& args,
+        double* rgdValues, size_t iRows, size_t iIndex = 0, size_t iThreads = 0) const;
+
+    // The number of cores ExecuteBatchJobs can use
+    //
+    static size_t MaxThreads();
+
+    // Translate the internal code produced by Compile with the same index into
+    // native machine code (x86-64 only). Execute runs the native code from then
+    // on, until the string is compiled again. Returns false if the translation
+    // is not supported, Execute then keeps using the internal code.
+    // Client should check that Compile has returned OK.
+    //
+    bool CompileNative(size_t iIndex = 0);
+
+    // Compile the strings with the given indices into one fused program computing
+    // all of them at once, with an output per string in the order of indices.
+    // A value needed by several strings, e.g. x1 + x2 in sin(x1 + x2)^2 and
+    // cos(x1 + x2)^2, is computed once per row, and each argument is loaded once.
+    // Each string is compiled by Compile on the way. On success returns OK and
+    // the index of the new fused program in iFusedIndex. Otherwise returns the
+    // error of the first string failing to compile, iErrorString being its
+    // position in indices.
+    //
+    ErrorCodes CompileFused(
+        size_t& iErrorPosition, size_t& iErrorString, const vector<size_t>& indices,
+        size_t& iFusedIndex);
+
+    // Execute a fused program: the value of the nth string is stored in rgdValues[n].
+    // In case of error, iErrorString is the position of the string the failed
+    // operation comes from (the first one if the operation is shared),
+    // iErrorPosition is the position in that string, and no values are stored.
+    //
+    ErrorCodes ExecuteFused(
+        size_t& iErrorPosition, size_t& iErrorString, const vector<double>& args,
+        double* rgdValues, size_t iFusedIndex = 0);
+    ErrorCodes ExecuteFused(
+        ExecutionContext&, size_t& iErrorPosition, size_t& iErrorString,
+        const vector<double>& args, double* rgdValues, size_t iFusedIndex = 0) const;
+
+    // ExecuteBatch for a fused program: the value of the nth string in the given
+    // row is stored in values[n][row]. Errors are reported as by ExecuteFused
+    // and ExecuteBatch.
+    //
+    ErrorCodes ExecuteFusedBatch(
+        size_t& iErrorPosition, size_t& iErrorString, size_t& iErrorRow,
+        const vector<const double*>& args, const vector<double*>& values, size_t iRows,
+        size_t iFusedIndex = 0);
+    ErrorCodes ExecuteFusedBatch(
+        ExecutionContext&, size_t& iErrorPosition, size_t& iErrorString, size_t& iErrorRow,
+        const vector<const double*>& args, const vector<double*>& values, size_t iRows,
+        size_t iFusedIndex = 0) const;
+
+    // UsedVars of a fused program: the variables read by any of its strings
+    //
+    const vector<size_t>& UsedVarsFused(size_t iFusedIndex = 0) const;
+
+    // The fused programs do not depend on the strings once compiled,
+    // and are only removed all at once
+    //
+    size_t NumberOfFusedPrograms() const;
+    void RemoveAllFusedPrograms();
+
+    //
+    // 
+    // Before strings can be Parsed/Evaluated/Compiled/Executed, they need inserted
+    // into the MathParser object. These functions handle manipulations with strings.
+    //
+    //
+
+    // Insert a string at the position designated by iRequestedIndex.
+    // The internal semantics is a list of strings, therefore, iRequestedIndex
+    // should be in the range [0, NumberOfStrings() - 1]. If its value is higher
+    // then the string will be inserted at the position NumberofStrings().
+    // The actual assigned index is returned in iAssignedIndex.
+    //
+    void InsertString(
+        wstring&& wstr, size_t iRequestedIndex, size_t& iAssignedIndex);
+
+    // Return nth stored string using vector's at().
+    // Should be 0 <= iIndex < NumberOfStrings(),
+    // otherwise vector throws an exception.
+    //
+    const wchar_t* String(size_t iIndex) const;
+
+    // Return nth stored string using vector's operator[]
+    // should be 0 <= iIndex < NumberOfStrings(),
+    // otherwise behavior undefined.
+    //
+    const wchar_t* operator[](size_t iIndex) const;
+    
+    // Remove nth string.
+    // Should be 0 <= iIndex < NumberOfStrings()
+    // otherwise throws an exception.
+    //
+    void RemoveString(size_t iIndex);
+
+    // The current number of stored strings
+    //
+    size_t NumberOfStrings() const;
+
+    //
+    //
+    // Strings can contain user-defined variables, such as x1 in "sin(x1)^2".
+    // Such user-defined variables need inserted into the MathParser object.
+    // User-defined variable names can contain letters, digits and underscore, and
+    // cannot begin with a digit.
+    //
+    //
+
+    // A helper to remove leading and trailing blanks (' ' and '\t').
+    // Returns the length of the resulting string.
+    //
+    static size_t TrimVarName(wstring&);
+
+    // Check if this is a valid variable name.
+    // Return value =
+    //    = InvalidIdentifier if wstr does not contain a valid variable name
+    //    = IdentifierInUse if wstr contains a valid name but it is already in use
+    //    = otherwise it is OK
+    //
+    ErrorCodes CheckVar(const wstring&) const;
+
+    // Check if this is a valid variable name, and if so, insert it.
+    // Return value =
+    //    = InvalidIdentifier if wstr does not contain a valid variable name
+    //    = IdentifierInUse if wstr contains a valid name but it is already in use
+    //    = otherwise it is OK
+    //
+    // If OK then the variable is inserted. Only appending a variable
+    // (iRequestedIndex >= NumberOfVars()) takes amortized constant time.
+    // Inserting it before others renumbers them: their names, ranges and
+    // bindings are moved and the hash table of all the names is rebuilt, in
+    // time proportional to the number of variables. With many variables,
+    // insert them in the order of their indices.
+    //
+    ErrorCodes CheckAndInsertVar(
+        wstring&& wstr, size_t iRequestedIndex, size_t& iAssignedIndex);
+
+    // The same, declaring the range of the variable as SetVarRange does.
+    //
+    ErrorCodes CheckAndInsertVar(
+        wstring&& wstr, size_t iRequestedIndex, size_t& iAssignedIndex,
+        double dMin, double dMax);
+
+    // Declare that the values of nth variable passed to Execute are always in
+    // [dMin, dMax] (either bound can be infinite, the value is never NaN).
+    // Compile uses the ranges to prove that some commands cannot produce
+    // an infinity or a NaN, and does not check their results for floating point
+    // errors: with a value out of its range, such an error may go unnoticed.
+    // ClearVarRange makes the value unknown again, which is the default.
+    // Applies to the strings compiled after the change.
+    //
+    void SetVarRange(size_t iIndex, double dMin, double dMax);
+    void ClearVarRange(size_t iIndex);
+
+    // Bind nth variable to a value kept by the client, read by ExecuteBound
+    // at every call: *pValue, whatever the record.
+    //
+    void BindVar(size_t iIndex, const double* pValue);
+
+    // Bind nth variable to a double member of an array of records, such as
+    // the structs of a simulation: its value in record r is read at
+    // static_cast<const char*>(pRecords) + iOffset + r * iStride, e.g.
+    // BindVar(n, states.data(), offsetof(State, x), sizeof(State)).
+    //
+    void BindVar(size_t iIndex, const void* pRecords, size_t iOffset, size_t iStride);
+
+    // Unbind nth variable, which is the default. Only ExecuteBound uses
+    // the bindings; the client keeps the bound memory valid while it is called.
+    //
+    void UnbindVar(size_t iIndex);
+
+    // Return nth stored variable name
+    //
+    const wchar_t* Var(size_t iIndex) const;
+
+    // Remove nth variable.
+    // Should be 0 <= iIndex < NumberOfStrings()
+    // otherwise throws an exception.
+    // Renumbers the variables after it and rebuilds the hash table of all
+    // the names, in time proportional to the number of variables.
+    //
+    void RemoveVar(size_t iIndex);
+
+    // Remove all variables.
+    //
+    void RemoveAllVars();
+
+    // The current number of stored strings
+    //
+    size_t NumberOfVars() const;
+    
+    //
+    //
+    // Other functions
+    //
+    //
+    
+    // Check if nth string can be Executed (internal representation contains valid
+    // code). No need to do this check if the last call to Compile on
+    // the same string returned OK.
+    //
+    bool OKtoExecute(size_t iIndex = 0) const;
+
+    // Case sensitivity is set in the constructor, and can be checked/changed at runtime.
+    //
+    bool IsCaseSensitive() const;
+    void SetCaseSensitive(bool case_sensitive);
+
+    // Fast math is off by default: Compile only simplifies the code in ways that
+    // cannot change any result (x * 1, x - 0 and such on computed values,
+    // division by a power of 2), so Execute produces the same result as Evaluate.
+    // Both compute x ^ 2, x ^ -1 and x ^ 0.5 correctly rounded (see
+    // MathLexeme::mypow), which may differ from the C runtime's pow in the
+    // last bit. With fast math on, Compile also reassociates operations with
+    // constants (2 * x * 3 becomes x * 6, x / 3 becomes x * (1 / 3)) and removes
+    // x + 0 and double negation, ln(exp(x)) and, if floating point errors are
+    // not checked, exp(ln(x)), computes x ^ 0.5 by the sqrt command, giving -0
+    // for -0 and NaN for -inf, and x ^ 3 .. x ^ 8 by repeated multiplication,
+    // polynomials such as 1 + 2 * x + 3 * x ^ 2 by Horner's scheme, sinh and
+    // cosh of the same value from one exponential, and tan(x) as sin(x) / cos(x)
+    // when sin(x) or cos(x) is computed, and lets ExecuteBatch approximate exp,
+    // ln, lg, sin, cos and tan by vector code. A result may then differ in the last
+    // bits or in the sign of a zero, and a floating point error in an
+    // intermediate value may go unnoticed. Applies to the strings compiled
+    // after the change.
+    //
+    bool IsFastMath() const;
+    void SetFastMath(bool fast_math);
+
+private:
+
+    static constexpr bool IsFirstChar(wchar_t);
+    static constexpr bool IsNextChar(wchar_t);
+
+    // The names are of iLength characters, not necessarily zero-terminated
+    bool FunctionExists(const wchar_t* pName, size_t iLength, size_t* = nullptr) const;
+    bool ConstantExists(const wchar_t* pName, size_t iLength, size_t* = nullptr) const;
+    bool VariableExists(const wchar_t* pName, size_t iLength, size_t* = nullptr) const;
+    bool VarNameInUse(const wchar_t* pName, size_t iLength) const;
+    int FindBuiltinName(const wchar_t* pName, size_t iLength) const;
+    void IndexVar(size_t iIndex);
+    void IndexAllVars();
+    static bool IsVarNameValid(const wstring&);
+    static void EvaluateBinaryOp(MyStack&);
+    static inline void CheckForFloatingPointError(double);
+    static ErrorCodes FloatingPointError(double);
+
+    enum LexerMode {ParseMode, EvaluateMode, CompileMode};
+    void GetLexCheckSyntax(
+        MathParser::LexerMode LexerMode,
+        size_t& iFirstSymbol,
+        const wchar_t* pString,
+        size_t& iCurrentPosition,
+        MathLexeme& CurrentLexeme,
+        MathLexeme& PreviousLexeme,
+        long long int& iParBalance,
+        const double* rgdArguments,
+        MyStack& Stack
+    ) const;
+
+    void AdjustContext(ExecutionContext&) const;
+    void CompileBinaryOp(MyStack&);
+    void EmitCommand(
+        int iOpCode, size_t iResult, size_t iFirstOperand, size_t iSecondOperand,
+        size_t iErrorPosition);
+    size_t EmitConstant(double);
+    size_t EmitFunction(size_t iFunction, size_t iOperand, size_t iErrorPosition);
+    void AllocateMemory(vector<CompiledCommand>* pOutputs = nullptr);
+    void InvalidateCompiledCode(size_t);
+    void SelectVariables();
+
+    // Value numbering (mp_optimizer.cpp)
+    struct ValueTable;
+    CompiledCommand AppendNumbered(const CompiledProgram& Source, ValueTable&);
+    void EliminateCommonSubexpressions();
+    void Simplify();
+    void SelectPolynomials();
+    void ExpandTangents();
+    void SelectFunctionPairs(vector<size_t>* pErrorStrings = nullptr);
+    void RemoveUnusedCommands();
+    void SelectSuperinstructions(const vector<CompiledCommand>* pOutputs = nullptr);
+    void AnalyzeRanges();
+    void DeferFloatingPointChecks(
+        const vector<CompiledCommand>* pOutputs = nullptr, vector<size_t>* pErrorStrings = nullptr);
+
+    template<typename VarValue>
+    void GatherVars(ExecutionContext&, const CompiledProgram&, const VarValue&) const;
+    ErrorCodes RunProgram(
+        ExecutionContext&, const CompiledProgram&, double& dValue, size_t& iErrorCommand) const;
+    template<bool fCheckEach>
+    ErrorCodes Interpret(
+        ExecutionContext&, const CompiledProgram&, double& dValue, size_t& iErrorCommand) const;
+    ErrorCodes RunBatch(
+        ExecutionContext&, const CompiledProgram&,
+        const CompiledCommand* pOutputs, size_t iOutputs, double* const* rgpValues,
+        const vector<const double*>& args, size_t iRows,
+        size_t& iErrorCommand, size_t& iErrorRow) const;
+    ErrorCodes ExecuteBlock(
+        ExecutionContext&, const CompiledProgram&,
+        const CompiledCommand* pOutputs, size_t iOutputs, double* const* rgpValues,
+        const vector<const double*>& args, size_t iFirstRow, size_t iRows,
+        size_t iBlockSize, size_t& iErrorCommand, size_t& iErrorRow) const;
+    double OutputValue(
+        const CompiledProgram&, const CompiledCommand& Output, const double* pMem) const;
+
+    vector<wstring> input_strings;
+    vector<wstring> user_vars;
+    vector<size_t>  var_index;      // hash table of user_vars (see IndexVar)
+    vector<ValueRange> var_ranges;  // the range declared for each user variable
+    vector<VarBinding> var_bindings;// where ExecuteBound reads each user variable
+    size_t          iMaxStringLength;// the longest string ever inserted, sizes the contexts
+    ExecutionContext default_context;// used by the functions without a context parameter
+    bool            case_sensitive;
+    bool            fast_math;
+
+    // Expected[Lexeme1][Lexeme2]=
+    //    = true if Lexeme2 may follow Lexeme1,
+    //    = false otherwise
+    //
+    static constexpr bool Expected[8][8]
+    {
+        {false,
+#ifdef MATH_PARSER_EMPTY_STRING_ALLOWED            
+                 true,
+#else //MATH_PARSER_EMPTY_STRING_ALLOWED
+                false,
+#endif //MATH_PARSER_EMPTY_STRING_ALLOWED
+                        true,  true,  true, false,  true, false},
+        {false, false, false, false, false, false, false, false},
+        {false,  true, false, false, false,  true, false,  true},
+        {false, false, false, false, false, false,  true, false},
+        {false, false,  true,  true, false, false,  true, false},
+        {false, false,  true,  true, false, false,  true, false},
+        {false, false,  true,  true,  true, false,  true, false},
+        {false,  true, false, false, false,  true, false,  true}
+    };
+
+    vector<CompiledProgram> compiled_code;
+    vector<FusedProgram> fused_code;
+    size_t          iMemoryCounter;  // counter of used runtime memory
+    CompiledProgram*pCompiledProgram;// shortcut to the member of compiled_code being compiled
+};
+
+// Internal representation of commands used by Compile/Execute.
+//
+// A command is 16 bytes: an operation code and up to three 32-bit operands,
+// which are indices in the runtime memory, or in the constant pool of the
+// program, depending on the operation. Data needed only when something goes
+// wrong (error positions) are kept apart from the code.
+//
+struct CompiledCommand {
+
+    // Binary operations are laid out in the order of MathLexeme::MathLexBiItem,
+    // i.e. PlusMemMem + MathLexeme::Divide == DivideMemMem etc.
+
+    enum OpCodes : uint16_t {
+
+        // mem+mem:         mem[iResult] = mem[iFirstOperand] <op> mem[iSecondOperand]
+        PlusMemMem, MinusMemMem, MultiplyMemMem, DivideMemMem, PowerMemMem,
+
+        // mem+const:       mem[iResult] = mem[iFirstOperand] <op> const[iSecondOperand]
+        PlusMemConst, MinusMemConst, MultiplyMemConst, DivideMemConst, PowerMemConst,
+
+        // const+mem:       mem[iResult] = const[iFirstOperand] <op> mem[iSecondOperand]
+        PlusConstMem, MinusConstMem, MultiplyConstMem, DivideConstMem, PowerConstMem,
+
+        // function call:   mem[iResult] = FunctionAddress[iSecondOperand](mem[iFirstOperand])
+        CallFunction,
+
+        // inline function: the same for sqrt, abs and int, computed without a call
+        SqrtMem, AbsMem, FloorMem,
+
+        // function pair:   this command and the next one, a CallFunction on the same
+        //                      operand, compute sin and cos (sinh and cosh, fast math)
+        //                      of mem[iFirstOperand] by one call, this command storing
+        //                      the sine and the next one the cosine
+        SinCosMem, SinhCoshMem,
+
+        // integer power:   mem[iResult] = MathLexeme::myintpow(mem[iFirstOperand], iSecondOperand)
+        PowerMemInt,
+
+        // polynomial:      mem[iResult] = MathLexeme::mypolynomial(mem[iFirstOperand],
+        //                      &const[iSecondOperand]), the degree and the coefficients
+        //                      being consecutive constants (fast math)
+        PolynomialMem,
+
+        // Superinstructions, made of this command and the next one. This command
+        // is the first operation, computing the value iResult; the next command is
+        // the second operation, as it was before fusion, with iResult as its first
+        // operand. Only the result of the second operation is stored.
+        // (' marks the fields of the next command)
+
+        // multiply-add:    mem[iResult'] = mem[iFirstOperand] * <mem/const>[iSecondOperand]
+        //                      + <mem/const>[iSecondOperand']
+        MultiplyAddMemMemMem, MultiplyAddMemMemConst, MultiplyAddMemConstMem, MultiplyAddMemConstConst,
+
+        // the same rounded once, as by fma (fast math)
+        FusedMultiplyAddMemMemMem, FusedMultiplyAddMemMemConst,
+        FusedMultiplyAddMemConstMem, FusedMultiplyAddMemConstConst,
+
+        // add-multiply:    mem[iResult'] = (mem[iFirstOperand] + <mem/const>[iSecondOperand])
+        //                      * const[iSecondOperand']
+        PlusMultiplyMemMemConst, PlusMultiplyMemConstConst,
+
+        // check:           mem[iFirstOperand] should be finite
+        // (only with MATH_PARSER_DEFER_FLOATING_POINT_CHECKS)
+        CheckMem,
+
+        // end:             the final result is mem[iFirstOperand]
+        EndMem,
+
+        // end:             the final result is const[iFirstOperand]
+        EndConst,
+
+        // error token, output in case of unsuccessful compilation;
+        // OKtoExecute will check for it
+        Error
+    };
+
+    CompiledCommand() = default; // used by std::vector allocators
+    CompiledCommand(
+        OpCodes iOpCode, size_t iResult, size_t iFirstOperand, size_t iSecondOperand);
+
+    // Which fields refer to runtime memory
+    bool HasResult() const;
+    bool IsFirstOperandMem() const;
+    bool IsSecondOperandMem() const;
+
+    // CallFunction, an inline function or the first command of a function pair
+    bool IsFunction() const;
+
+    // SinCosMem or SinhCoshMem
+    bool IsFunctionPair() const;
+
+    // Superinstructions, and the opcode of their first operation
+    // (CallFunction for a function pair)
+    bool IsFused() const;
+    OpCodes FirstOperation() const;
+
+    // Finite: the result is never an infinity or a NaN (see AnalyzeRanges),
+    // so it is not checked for floating point errors
+    enum Flags : uint16_t { Finite = 1 };
+
+    uint16_t    iOpCode{ Error };
+    uint16_t    iFlags{};
+    uint32_t    iResult{};
+    uint32_t    iFirstOperand{};
+    uint32_t    iSecondOperand{};
+};
+
+static_assert(sizeof(CompiledCommand) == 16, "CompiledCommand should be 16 bytes");
+
+// Compiled code of a string along with its data
+//
+struct CompiledProgram {
+
+    vector<CompiledCommand> code;
+    vector<double>          constants;          // referred to by the const operands
+    vector<size_t>          error_positions;    // position in the string for each command
+    vector<size_t>          variables;          // the user variables read, in the order of
+                                                // user_vars, held by the first memory indices
+    size_t                  iMemorySize{};      // runtime memory used, including the variables
+    bool                    fFastMath{};        // compiled with fast math, so ExecuteBatch may
+                                                // use the approximations of MathKernels
+    NativeCode              native;             // translation of code made by CompileNative
+};
+
+// Several strings compiled into one program by CompileFused
+//
+struct FusedProgram {
+
+    CompiledProgram         program;        // ends with the output of the last string
+    vector<CompiledCommand> outputs;        // EndMem/EndConst giving the value of each string
+    vector<size_t>          error_strings;  // the string each command of program comes from
+};
+
+// The values a user variable or a command can take: from dMin to dMax,
+// and NaN if fNaN
+//
+struct ValueRange {
+
+    double  dMin;
+    double  dMax;
+    bool    fNaN;
+
+    bool IsFinite() const;
+};
+
+inline bool ValueRange::IsFinite() const
+{
+    return !fNaN && dMin > -HUGE_VAL && dMax < HUGE_VAL;
+}
+
+// Where ExecuteBound reads a user variable: at pBase + iRecord * iStride
+// (bytes), the stride being 0 for a single value
+//
+struct VarBinding {
+
+    const char* pBase;
+    size_t      iStride;
+
+    double Value(size_t iRecord) const;
+};
+
+inline double VarBinding::Value(size_t iRecord) const
+{
+    return *reinterpret_cast<const double*>(pBase + iRecord * iStride);
+}
+
+inline MathParser::ErrorCodes MathParser::Parse(size_t& iErrorPosition, size_t iIndex)
+{
+    return Parse(default_context, iErrorPosition, iIndex);
+}
+
+inline MathParser::ErrorCodes MathParser::Evaluate(
+    size_t& iErrorPosition, const vector<double>& args, double& dValue, size_t iIndex)
+{
+    return Evaluate(default_context, iErrorPosition, args, dValue, iIndex);
+}
+
+inline MathParser::ErrorCodes MathParser::Execute(
+    size_t& iErrorPosition, const vector<double>& args, double& dValue, size_t iIndex)
+{
+    return Execute(default_context, iErrorPosition, args, dValue, iIndex);
+}
+
+inline MathParser::ErrorCodes MathParser::ExecuteBound(
+    size_t& iErrorPosition, double& dValue, size_t iIndex, size_t iRecord)
+{
+    return ExecuteBound(default_context, iErrorPosition, dValue, iIndex, iRecord);
+}
+
+inline MathParser::ErrorCodes MathParser::ExecuteBatch(
+    size_t& iErrorPosition, size_t& iErrorRow, const vector<const double*>& args,
+    double* rgdValues, size_t iRows, size_t iIndex)
+{
+    return ExecuteBatch(default_context, iErrorPosition, iErrorRow, args, rgdValues, iRows, iIndex);
+}
+
+inline MathParser::ErrorCodes MathParser::ExecuteFused(
+    size_t& iErrorPosition, size_t& iErrorString, const vector<double>& args,
+    double* rgdValues, size_t iFusedIndex)
+{
+    return ExecuteFused(default_context, iErrorPosition, iErrorString, args, rgdValues, iFusedIndex);
+}
+
+inline MathParser::ErrorCodes MathParser::ExecuteFusedBatch(
+    size_t& iErrorPosition, size_t& iErrorString, size_t& iErrorRow,
+    const vector<const double*>& args, const vector<double*>& values, size_t iRows,
+    size_t iFusedIndex)
+{
+    return ExecuteFusedBatch(default_context,
+        iErrorPosition, iErrorString, iErrorRow, args, values, iRows, iFusedIndex);
+}
+
+inline size_t MathParser::NumberOfFusedPrograms() const
+{
+    return fused_code.size();
+}
+
+// The value of Output (EndMem or EndConst) after Program has run,
+// its variables and intermediate values being in pMem
+//
+inline double MathParser::OutputValue(
+    const CompiledProgram& Program, const CompiledCommand& Output, const double* pMem) const
+{
+    if (Output.iOpCode == CompiledCommand::EndConst)
+        return Program.constants[Output.iFirstOperand];
+
+    return pMem[Output.iFirstOperand];
+}
+
+inline const vector<size_t>& MathParser::UsedVars(size_t iIndex) const
+{
+    return compiled_code[iIndex].variables;
+}
+
+inline const vector<size_t>& MathParser::UsedVarsFused(size_t iFusedIndex) const
+{
+    return fused_code[iFusedIndex].program.variables;
+}
+
+inline const wchar_t* MathParser::String(size_t iIndex) const
+{
+    return input_strings.at(iIndex).data();
+}
+
+inline const wchar_t* MathParser::operator[](size_t iIndex) const
+{
+    return input_strings[iIndex].data();
+}
+
+inline size_t MathParser::NumberOfStrings() const
+{
+    return input_strings.size();
+}
+
+inline const wchar_t* MathParser::Var(size_t iIndex) const
+{
+    return user_vars[iIndex].data();
+}
+
+inline size_t MathParser::NumberOfVars() const
+{
+    return user_vars.size();
+}
+
+constexpr bool MathParser::IsFirstChar(wchar_t c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+constexpr bool MathParser::IsNextChar(wchar_t c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+        (c >= '1' && c <= '9') || c == '0' || c == '_';
+}
+
+inline CompiledCommand::CompiledCommand(
+    OpCodes iOpCode, size_t iResult, size_t iFirstOperand, size_t iSecondOperand)
+    : iOpCode(iOpCode), iResult(static_cast<uint32_t>(iResult)),
+    iFirstOperand(static_cast<uint32_t>(iFirstOperand)),
+    iSecondOperand(static_cast<uint32_t>(iSecondOperand))
+{
+}
+
+inline bool CompiledCommand::HasResult() const
+{
+    return iOpCode < CheckMem;
+}
+
+inline bool CompiledCommand::IsFirstOperandMem() const
+{
+    return iOpCode < PlusConstMem || IsFunction() || iOpCode == PowerMemInt || iOpCode == PolynomialMem ||
+        IsFused() || iOpCode == CheckMem || iOpCode == EndMem;
+}
+
+inline bool CompiledCommand::IsSecondOperandMem() const
+{
+    return iOpCode < PlusMemConst ||
+        (iOpCode >= PlusConstMem && iOpCode <= PowerConstMem) ||
+        (IsFused() && FirstOperation() < PlusMemConst);
+}
+
+inline bool CompiledCommand::IsFunction() const
+{
+    return iOpCode >= CallFunction && iOpCode <= SinhCoshMem;
+}
+
+inline bool CompiledCommand::IsFunctionPair() const
+{
+    return iOpCode == SinCosMem || iOpCode == SinhCoshMem;
+}
+
+inline bool CompiledCommand::IsFused() const
+{
+    return iOpCode >= MultiplyAddMemMemMem && iOpCode <= PlusMultiplyMemConstConst;
+}
+
+inline CompiledCommand::OpCodes CompiledCommand::FirstOperation() const
+{
+    switch (iOpCode)
+    {
+    case MultiplyAddMemMemMem:
+    case MultiplyAddMemMemConst:
+    case FusedMultiplyAddMemMemMem:
+    case FusedMultiplyAddMemMemConst:
+        return MultiplyMemMem;
+
+    case MultiplyAddMemConstMem:
+    case MultiplyAddMemConstConst:
+    case FusedMultiplyAddMemConstMem:
+    case FusedMultiplyAddMemConstConst:
+        return MultiplyMemConst;
+
+    case PlusMultiplyMemMemConst:
+        return PlusMemMem;
+
+    case PlusMultiplyMemConstConst:
+        return PlusMemConst;
+
+    case SinCosMem:
+    case SinhCoshMem:
+        return CallFunction;
+
+    default:
+        return static_cast<OpCodes>(iOpCode);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,531 @@
+//
+// Benchmark of MathParser (console program, built by MParserBench.vcxproj)
+//
+// ExecuteBatchParallel throughput on 1..N cores, Parse/Evaluate/Compile
+// throughput on a string made mostly of numbers, Execute of small formulas
+// among many variables, and ExecuteBound on an array of structs. Checks first
+// that the powers computed without pow give the values of pow where the C
+// standard specifies them and the same values in Evaluate and Execute, that
+// fast math keeps the precision of powers of sums near their roots, and that
+// the vector approximations of exp, ln, lg, sin, cos and tan are within 4 ulp.
+//
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include "mp.hpp"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    const wchar_t* const rgszFormulas[]{
+        L"x * y + z",
+        L"sin(x)^2 + cos(y)^2 * z",
+        L"sqrt(x^2 + y^2 + z^2) * exp(-z / 10) + ln(1 + x * y)"
+    };
+
+    // The best time of a few runs, in seconds
+
+    template<typename Function>
+    double Measure(const Function& Run)
+    {
+        constexpr int repetitions{ 5 };
+        auto dBest{ HUGE_VAL };
+
+        for (int it = 0; it < repetitions; ++it)
+        {
+            const auto Start{ Clock::now() };
+            Run();
+            const std::chrono::duration<double> Elapsed{ Clock::now() - Start };
+
+            if (dBest > Elapsed.count()) dBest = Elapsed.count();
+        }
+        return dBest;
+    }
+
+    // The same bits, or both NaN
+
+    bool SameValue(double dValue1, double dValue2)
+    {
+        return memcmp(&dValue1, &dValue2, sizeof(double)) == 0 ||
+            (std::isnan(dValue1) && std::isnan(dValue2));
+    }
+
+    // x ^ 2, x ^ -1 and x ^ 0.5 are computed without pow, correctly rounded,
+    // so they may differ from the pow of the C runtime in the last bit. For
+    // 0, -0, inf, -inf and NaN, whose powers the C standard specifies exactly
+    // (sqrt(x) is not x ^ 0.5 for -0 and -inf), they must be those of pow.
+    // For any value, Execute and the native code must give the value of
+    // Evaluate, or the same error.
+
+    bool PowerEdgeCases()
+    {
+        constexpr size_t special_values{ 5 }, random_values{ 1000 };
+        const double rgdPowers[]{ 2, -1, 0.5 };
+        const wchar_t* const rgszPowers[]{ L"x ^ 2", L"x ^ -1", L"x ^ 0.5" };
+
+        vector<double> values{ 0.0, -0.0, HUGE_VAL, -HUGE_VAL, NAN, -1, 2, 1e-300, 1e300 };
+        uint64_t iRandom{ 12345 };
+
+        for (size_t it = 0; it < random_values; ++it)
+        {
+            iRandom = iRandom * 6364136223846793005 + 1442695040888963407;
+            const auto dMantissa{ 1.0 + static_cast<double>(iRandom >> 12) / 4503599627370496.0 };
+            values.push_back(std::ldexp(it % 2 ? -dMantissa : dMantissa,
+                static_cast<int>(iRandom % 1200) - 600));
+        }
+
+        MathParser mp{ true };
+        size_t unused{}, err_pos{};
+        bool fPassed{ true };
+
+        for (const auto dPower : rgdPowers)
+            for (size_t it = 0; it < special_values; ++it)
+                if (!SameValue(MathLexeme::mypow(values[it], dPower), pow(values[it], dPower)))
+                {
+                    printf("mypow(%g, %g) is not pow\n", values[it], dPower);
+                    fPassed = false;
+                }
+
+        mp.CheckAndInsertVar(L"x", 0, unused);
+
+        for (size_t iFormula = 0; iFormula < 3; ++iFormula)
+        {
+            mp.InsertString(rgszPowers[iFormula], 0, unused);
+
+            vector<double> evaluated(values.size());
+            vector<MathParser::ErrorCodes> errors(values.size());
+
+            for (size_t it = 0; it < values.size(); ++it)
+            {
+                errors[it] = mp.Evaluate(err_pos, { values[it] }, evaluated[it], 0);
+
+                if (it < special_values && errors[it] == MathParser::OK &&
+                    !SameValue(evaluated[it], pow(values[it], rgdPowers[iFormula])))
+                {
+                    printf("%ls for x = %g: Evaluate is not pow\n", rgszPowers[iFormula], values[it]);
+                    fPassed = false;
+                }
+            }
+
+            for (int iNative = 0; iNative < 2; ++iNative)
+            {
+                if (mp.Compile(err_pos, 0) != MathParser::OK ||
+                    (iNative && !mp.CompileNative(0))) continue;
+
+                for (size_t it = 0; it < values.size(); ++it)
+                {
+                    double dExecuted{};
+                    const auto iExecuted{ mp.Execute(err_pos, { values[it] }, dExecuted, 0) };
+
+                    if (errors[it] != iExecuted ||
+                        (iExecuted == MathParser::OK && !SameValue(evaluated[it], dExecuted)))
+                    {
+                        printf("%ls for x = %a: Execute%s differs from Evaluate\n",
+                            rgszPowers[iFormula], values[it], iNative ? " (native)" : "");
+                        fPassed = false;
+                    }
+                }
+            }
+        }
+
+        return fPassed;
+    }
+
+    // With fast math, a power or a product of sums is not expanded into
+    // a polynomial, whose coefficients would cancel near a root: Execute,
+    // the native code and ExecuteBatch must stay within a relative 1e-9 of
+    // Evaluate there
+
+    bool PolynomialsNearRoots()
+    {
+        const double rgdValues[]{ -2.69, -2.7, -2.718, -2.7182818, 2.72 };
+        const wchar_t* const rgszFormulas[]{
+            L"(t + e)^9", L"t / ((t + 0) + e)^9", L"(t + e) * (t - e) * t^2", L"-(t + e)^3 * 2" };
+
+        MathParser mp{ true };
+        size_t unused{}, err_pos{}, err_row{};
+        bool fPassed{ true };
+
+        mp.SetFastMath(true);
+        mp.CheckAndInsertVar(L"t", 0, unused);
+
+        auto Close = [](double dValue, double dReference)
+        {
+            return std::fabs(dValue - dReference) <= 1e-9 * std::fabs(dReference);
+        };
+
+        for (const auto szFormula : rgszFormulas)
+        {
+            mp.InsertString(szFormula, 0, unused);
+
+            for (int iNative = 0; iNative < 2; ++iNative)
+            {
+                if (mp.Compile(err_pos, 0) != MathParser::OK ||
+                    (iNative && !mp.CompileNative(0))) continue;
+
+                double rgdBatch[sizeof(rgdValues) / sizeof(rgdValues[0])]{};
+                const vector<const double*> columns{ rgdValues };
+
+                mp.ExecuteBatch(err_pos, err_row, columns, rgdBatch,
+                    sizeof(rgdValues) / sizeof(rgdValues[0]), 0);
+
+                for (size_t it = 0; it < sizeof(rgdValues) / sizeof(rgdValues[0]); ++it)
+                {
+                    const vector<double> args{ rgdValues[it] };
+                    double dEvaluated{}, dExecuted{};
+
+                    mp.Evaluate(err_pos, args, dEvaluated, 0);
+                    mp.Execute(err_pos, args, dExecuted, 0);
+
+                    if (!Close(dExecuted, dEvaluated) || (!iNative && !Close(rgdBatch[it], dEvaluated)))
+                    {
+                        printf("%ls for t = %g: %.17g (Execute%s), %.17g (ExecuteBatch), %.17g (Evaluate)\n",
+                            szFormula, rgdValues[it], dExecuted, iNative ? ", native" : "",
+                            rgdBatch[it], dEvaluated);
+                        fPassed = false;
+                    }
+                }
+            }
+        }
+
+        return fPassed;
+    }
+
+    // With fast math, ExecuteBatch computes exp, ln, lg, sin, cos and tan by the
+    // approximations of the vector kernels: within 4 ulp of Evaluate, which calls
+    // the C runtime, and with the same errors for the arguments out of their domain
+
+    bool FastFunctions()
+    {
+        constexpr size_t random_values{ 1000 }, copies{ 16 };
+        const wchar_t* const rgszFormulas[]{
+            L"exp(t)", L"ln(t)", L"lg(t)", L"sin(t)", L"cos(t)", L"tan(t)", L"sin(t) * cos(t)" };
+
+        vector<double> values{ 0.0, -0.0, HUGE_VAL, -HUGE_VAL, NAN, 1e300, -1e300, 5e-324,
+            -1, 1, 10, 1000, 1e5, -1e5, 700, -700, 710, -750 };
+        uint64_t iRandom{ 12345 };
+
+        for (size_t it = 0; it < random_values; ++it)
+        {
+            iRandom = iRandom * 6364136223846793005 + 1442695040888963407;
+            const auto dMantissa{ 1.0 + static_cast<double>(iRandom >> 12) / 4503599627370496.0 };
+            values.push_back(std::ldexp(it % 2 ? -dMantissa : dMantissa,
+                static_cast<int>(iRandom % 48) - 32));
+        }
+
+        MathParser mp{ true };
+        size_t unused{}, err_pos{}, err_row{};
+        bool fPassed{ true };
+
+        mp.SetFastMath(true);
+        mp.CheckAndInsertVar(L"t", 0, unused);
+
+        for (const auto szFormula : rgszFormulas)
+        {
+            mp.InsertString(szFormula, 0, unused);
+            if (mp.Compile(err_pos, 0) != MathParser::OK) continue;
+
+            vector<double> arguments, evaluated;
+
+            for (const auto dValue : values)
+            {
+                double dEvaluated{};
+                const auto iEvaluated{ mp.Evaluate(err_pos, { dValue }, dEvaluated, 0) };
+
+                if (iEvaluated == MathParser::OK)
+                {
+                    arguments.push_back(dValue);
+                    evaluated.push_back(dEvaluated);
+                    continue;
+                }
+
+                // a column of the argument, so that the vectors meet it too
+
+                const vector<double> column(copies, dValue);
+                vector<double> batch(copies);
+
+                if (mp.ExecuteBatch(err_pos, err_row, { column.data() }, batch.data(), copies, 0) != iEvaluated ||
+                    err_row != 0)
+                {
+                    printf("%ls for t = %g: ExecuteBatch does not give the error of Evaluate\n",
+                        szFormula, dValue);
+                    fPassed = false;
+                }
+            }
+
+            vector<double> batch(arguments.size());
+
+            if (mp.ExecuteBatch(err_pos, err_row, { arguments.data() }, batch.data(),
+                arguments.size(), 0) != MathParser::OK)
+            {
+                printf("%ls: ExecuteBatch fails at t = %g\n", szFormula, arguments[err_row]);
+                fPassed = false;
+                continue;
+            }
+
+            for (size_t it = 0; it < arguments.size(); ++it)
+                if (!(std::fabs(batch[it] - evaluated[it]) <= 4 * DBL_EPSILON * std::fabs(evaluated[it])))
+                {
+                    printf("%ls for t = %.17g: %.17g (ExecuteBatch), %.17g (Evaluate)\n",
+                        szFormula, arguments[it], batch[it], evaluated[it]);
+                    fPassed = false;
+                }
+        }
+
+        return fPassed;
+    }
+
+    void ParallelBatch()
+    {
+        constexpr size_t rows{ size_t{ 1 } << 22 };
+
+        MathParser mp{ true };
+        size_t unused{}, err_pos{}, err_row{};
+
+        mp.CheckAndInsertVar(L"x", 0, unused);
+        mp.CheckAndInsertVar(L"y", 1, unused);
+        mp.CheckAndInsertVar(L"z", 2, unused);
+
+        vector<double> x(rows), y(rows), z(rows), values(rows), reference(rows);
+
+        for (size_t it = 0; it < rows; ++it)
+        {
+            x[it] = 0.5 + static_cast<double>(it % 1000) / 1000;
+            y[it] = 1.5 - static_cast<double>(it % 777) / 1000;
+            z[it] = 2.0 + static_cast<double>(it % 333) / 100;
+        }
+
+        const vector<const double*> args{ x.data(), y.data(), z.data() };
+        const auto iMaxThreads{ MathParser::MaxThreads() };
+
+        printf("ExecuteBatchParallel, %zu rows, up to %zu threads\n", rows, iMaxThreads);
+
+        for (const auto szFormula : rgszFormulas)
+        {
+            mp.InsertString(szFormula, 0, unused);
+
+            if (mp.Compile(err_pos, 0) != MathParser::OK) continue;
+
+            printf("\n%ls\n%8s %14s %9s\n", szFormula, "threads", "Mrows/s", "speedup");
+
+            mp.ExecuteBatch(err_pos, err_row, args, reference.data(), rows, 0);
+
+            double dSingle{};
+
+            for (size_t iThreads = 1; iThreads <= iMaxThreads;
+                iThreads = iThreads < iMaxThreads && iThreads * 2 > iMaxThreads ? iMaxThreads : iThreads * 2)
+            {
+                const auto dTime{ Measure([&] {
+                    mp.ExecuteBatchParallel(err_pos, err_row, args, values.data(), rows, 0, iThreads); }) };
+
+                if (iThreads == 1) dSingle = dTime;
+
+                const auto fSame{ memcmp(values.data(), reference.data(), rows * sizeof(double)) == 0 };
+
+                printf("%8zu %14.1f %8.2fx%s\n", iThreads, rows / dTime * 1e-6, dSingle / dTime,
+                    fSame ? "" : "  (results differ)");
+            }
+
+            mp.RemoveString(0);
+        }
+    }
+
+    // Numbers of the kinds found in generated formulas: small integers, short
+    // decimals, doubles printed with all their 17 digits and exponents
+
+    void ParseNumbers()
+    {
+        constexpr size_t terms{ 50000 };
+        const wchar_t* const rgszSigns[]{ L" + ", L" - ", L" * ", L" / " };
+
+        wstring formula{ L"1" };
+        uint64_t iRandom{ 12345 };
+        wchar_t szNumber[64]{};
+
+        for (size_t it = 0; it < terms; ++it)
+        {
+            iRandom = iRandom * 6364136223846793005 + 1442695040888963407;
+            const auto iBits{ static_cast<unsigned>(iRandom >> 33) };
+            const auto dValue{ 1.0 + static_cast<double>(iBits % 1000000) / 1000 };
+
+            switch (it % 4)
+            {
+            case 0: swprintf(szNumber, 64, L"%u", iBits % 1000); break;
+            case 1: swprintf(szNumber, 64, L"%.2f", dValue); break;
+            case 2: swprintf(szNumber, 64, L"%.17g", dValue * 0.987654321); break;
+            default: swprintf(szNumber, 64, L"%.6e", dValue * 1e-7); break;
+            }
+
+            formula += rgszSigns[it % 4];
+            formula += szNumber;
+        }
+
+        MathParser mp{ true };
+        size_t unused{}, err_pos{};
+        double dValue{};
+
+        mp.InsertString(formula.c_str(), 0, unused);
+
+        printf("\nParse/Evaluate/Compile, %zu numbers, %zu characters\n%8s %14s\n",
+            terms + 1, formula.size(), "", "Mchars/s");
+
+        auto Report = [&](const char* szName, double dTime)
+        {
+            printf("%8s %14.1f\n", szName, formula.size() / dTime * 1e-6);
+        };
+
+        Report("Parse", Measure([&] { mp.Parse(err_pos, 0); }));
+        Report("Evaluate", Measure([&] { mp.Evaluate(err_pos, {}, dValue, 0); }));
+        Report("Compile", Measure([&] { mp.Compile(err_pos, 0); }));
+    }
+
+    // Each call sets only the arguments listed by UsedVars, as a caller
+    // assembling its inputs would
+
+    void ManyVariables()
+    {
+        constexpr size_t variables{ 100000 }, calls{ 1000000 };
+        const wchar_t* const rgszSmallFormulas[]{
+            L"f17 * f50000 + f99999",
+            L"sin(f3)^2 + cos(f70000)^2 * f42"
+        };
+
+        MathParser mp{ true };
+        size_t unused{}, err_pos{};
+        double dValue{}, dSum{};
+
+        for (size_t it = 0; it < variables; ++it)
+            mp.CheckAndInsertVar(L"f" + std::to_wstring(it), it, unused);
+
+        vector<double> args(variables);
+
+        printf("\nExecute, %zu variables\n%-34s %9s %12s\n", variables, "", "variables", "Mcalls/s");
+
+        for (const auto szFormula : rgszSmallFormulas)
+        {
+            mp.InsertString(szFormula, 0, unused);
+
+            if (mp.Compile(err_pos, 0) != MathParser::OK) continue;
+
+            const auto& used{ mp.UsedVars(0) };
+
+            const auto dTime{ Measure([&] {
+                for (size_t iCall = 0; iCall < calls; ++iCall)
+                {
+                    for (const auto iVar : used) args[iVar] = 1.0 + static_cast<double>(iCall % 100) / 100;
+
+                    mp.Execute(err_pos, args, dValue, 0);
+                    dSum += dValue;
+                }
+            }) };
+
+            printf("%-34ls %9zu %12.1f\n", szFormula, used.size(), calls / dTime * 1e-6);
+
+            mp.RemoveString(0);
+        }
+
+        if (!std::isfinite(dSum)) printf("(non-finite results)\n");
+    }
+
+    // The state of a simulation kept in its own structs: copying the fields into
+    // the arguments of Execute at each call, against reading them through bindings
+
+    struct Particle {
+
+        double  x, y, z;
+        double  mass;
+    };
+
+    void BoundState()
+    {
+        constexpr size_t particles{ 1000 }, rounds{ 1000 };
+
+        vector<Particle> state(particles);
+
+        for (size_t it = 0; it < particles; ++it)
+            state[it] = Particle{ 0.5 + static_cast<double>(it % 100) / 100,
+                1.5 - static_cast<double>(it % 77) / 100, 2.0 + static_cast<double>(it % 33) / 10, 1.0 };
+
+        MathParser mp{ true };
+        size_t unused{}, err_pos{};
+        double dValue{}, dSum{};
+
+        mp.CheckAndInsertVar(L"x", 0, unused);
+        mp.CheckAndInsertVar(L"y", 1, unused);
+        mp.CheckAndInsertVar(L"z", 2, unused);
+
+        mp.BindVar(0, state.data(), offsetof(Particle, x), sizeof(Particle));
+        mp.BindVar(1, state.data(), offsetof(Particle, y), sizeof(Particle));
+        mp.BindVar(2, state.data(), offsetof(Particle, z), sizeof(Particle));
+
+        vector<double> args(3);
+
+        auto Copied = [&]
+        {
+            for (size_t iRound = 0; iRound < rounds; ++iRound)
+                for (const auto& Current : state)
+                {
+                    args[0] = Current.x; args[1] = Current.y; args[2] = Current.z;
+                    mp.Execute(err_pos, args, dValue, 0);
+                    dSum += dValue;
+                }
+        };
+
+        auto Bound = [&]
+        {
+            for (size_t iRound = 0; iRound < rounds; ++iRound)
+                for (size_t iRecord = 0; iRecord < particles; ++iRecord)
+                {
+                    mp.ExecuteBound(err_pos, dValue, 0, iRecord);
+                    dSum += dValue;
+                }
+        };
+
+        printf("\nExecute/ExecuteBound, %zu structs\n%-54s %8s %8s %9s %9s\n", particles,
+            "Mcalls/s", "copy", "bound", "nat copy", "nat bound");
+
+        for (const auto szFormula : rgszFormulas)
+        {
+            mp.InsertString(szFormula, 0, unused);
+
+            if (mp.Compile(err_pos, 0) != MathParser::OK) continue;
+
+            const auto dCopied{ Measure(Copied) }, dBound{ Measure(Bound) };
+
+            if (!mp.CompileNative(0))
+            {
+                printf("%-54ls %8.1f %8.1f\n", szFormula,
+                    particles * rounds / dCopied * 1e-6, particles * rounds / dBound * 1e-6);
+            }
+            else
+            {
+                const auto dNativeCopied{ Measure(Copied) }, dNativeBound{ Measure(Bound) };
+
+                printf("%-54ls %8.1f %8.1f %9.1f %9.1f\n", szFormula,
+                    particles * rounds / dCopied * 1e-6, particles * rounds / dBound * 1e-6,
+                    particles * rounds / dNativeCopied * 1e-6, particles * rounds / dNativeBound * 1e-6);
+            }
+
+            mp.RemoveString(0);
+        }
+
+        if (!std::isfinite(dSum)) printf("(non-finite results)\n");
+    }
+}
+
+int main()
+{
+    if (!PowerEdgeCases() || !PolynomialsNearRoots() || !FastFunctions()) return 1;
+
+    ParallelBatch();
+    ParseNumbers();
+    ManyVariables();
+    BoundState();
+    return 0;
+}
@@ -0,0 +1,641 @@
+#include <cmath>
+#include <cstring>
+#include "mp.hpp"
+#include "mp_jit.hpp"
+
+#ifdef MATH_PARSER_JIT_X64
+
+#ifdef _WIN32
+#include <windows.h>
+#else //_WIN32
+#include <sys/mman.h>
+#endif //_WIN32
+
+namespace {
+
+    // Executable memory is first allocated writable, and made executable
+    // (and read-only) once the code has been copied there
+
+    void* AllocateCode(size_t iSize)
+    {
+#ifdef _WIN32
+        return VirtualAlloc(nullptr, iSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else //_WIN32
+        const auto pMem{ mmap(nullptr, iSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) };
+        return pMem == MAP_FAILED ? nullptr : pMem;
+#endif //_WIN32
+    }
+
+    bool ProtectCode(void* pMem, size_t iSize)
+    {
+#ifdef _WIN32
+        DWORD iOldProtect{};
+        return VirtualProtect(pMem, iSize, PAGE_EXECUTE_READ, &iOldProtect) &&
+            FlushInstructionCache(GetCurrentProcess(), pMem, iSize);
+#else //_WIN32
+        return mprotect(pMem, iSize, PROT_READ | PROT_EXEC) == 0;
+#endif //_WIN32
+    }
+
+    void FreeCode(void* pMem, size_t iSize)
+    {
+#ifdef _WIN32
+        (void)iSize;
+        VirtualFree(pMem, 0, MEM_RELEASE);
+#else //_WIN32
+        munmap(pMem, iSize);
+#endif //_WIN32
+    }
+
+    // General purpose registers
+
+    enum Reg : uint8_t { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSI = 6, RDI = 7,
+        R8 = 8, R9 = 9, R12 = 12, R13 = 13, R14 = 14 };
+
+    // Registers holding the arguments of the generated function during its run
+
+    constexpr Reg ArgsBase{ RBX }, TempsBase{ R12 }, ConstsBase{ R13 }, ValuePtr{ R14 };
+
+    // Registers the arguments are passed in
+
+#ifdef _WIN32
+    constexpr Reg rgArgRegs[4]{ RCX, RDX, R8, R9 };
+#else //_WIN32
+    constexpr Reg rgArgRegs[4]{ RDI, RSI, RDX, RCX };
+#endif //_WIN32
+
+    // The first pointer argument following a double: Windows counts the
+    // arguments of both kinds together
+
+#ifdef _WIN32
+    constexpr size_t first_pointer_after_double{ 1 };
+#else //_WIN32
+    constexpr size_t first_pointer_after_double{ 0 };
+#endif //_WIN32
+
+    // SSE2 scalar double instructions: prefix, 0x0F, opcode
+
+    struct SSE { uint8_t iPrefix, iOpCode; };
+
+    constexpr SSE MOVSD_LOAD{ 0xF2, 0x10 }, MOVSD_STORE{ 0xF2, 0x11 }, MOVAPD{ 0x66, 0x28 },
+        UCOMISD{ 0x66, 0x2E }, ADDSD{ 0xF2, 0x58 }, MULSD{ 0xF2, 0x59 },
+        SUBSD{ 0xF2, 0x5C }, DIVSD{ 0xF2, 0x5E }, SQRTSD{ 0xF2, 0x51 }, ANDPD{ 0x66, 0x54 },
+        PCMPEQD{ 0x66, 0x76 };
+
+    // Arithmetic instructions in the order of MathLexeme::MathLexBiItem
+    // (there is no instruction for power)
+
+    constexpr SSE rgArithmetic[4]{ ADDSD, SUBSD, MULSD, DIVSD };
+
+    // Machine code being emitted for the address pBase
+
+    class Assembler {
+
+    public:
+
+        explicit Assembler(const uint8_t* pBase) : pBase{ pBase } {}
+
+        vector<uint8_t> code;
+
+        size_t Position() const { return code.size(); }
+
+        void Byte(uint8_t iByte) { code.push_back(iByte); }
+
+        void Dword(uint32_t iDword)
+        {
+            for (int it = 0; it < 4; ++it) Byte(static_cast<uint8_t>(iDword >> (8 * it)));
+        }
+
+        void Qword(uint64_t iQword)
+        {
+            Dword(static_cast<uint32_t>(iQword)); Dword(static_cast<uint32_t>(iQword >> 32));
+        }
+
+        void Push(Reg iReg) { if (iReg >= 8) Byte(0x41); Byte(0x50 + (iReg & 7)); }
+        void Pop(Reg iReg) { if (iReg >= 8) Byte(0x41); Byte(0x58 + (iReg & 7)); }
+
+        // mov iDest, iSrc (64 bit)
+        void Mov(Reg iDest, Reg iSrc)
+        {
+            Byte(0x48 | ((iSrc >> 3) << 2) | (iDest >> 3));
+            Byte(0x89);
+            Byte(0xC0 | ((iSrc & 7) << 3) | (iDest & 7));
+        }
+
+        // lea iDest, [iBase + iDisp]
+        void Lea(Reg iDest, Reg iBase, uint32_t iDisp)
+        {
+            Byte(0x48 | ((iDest >> 3) << 2) | (iBase >> 3));
+            Byte(0x8D);
+            Byte(0x80 | ((iDest & 7) << 3) | (iBase & 7));
+            if ((iBase & 7) == 4) Byte(0x24);
+            Dword(iDisp);
+        }
+
+        // sub rsp, iBytes / add rsp, iBytes
+        void SubRsp(uint8_t iBytes) { Byte(0x48); Byte(0x83); Byte(0xEC); Byte(iBytes); }
+        void AddRsp(uint8_t iBytes) { Byte(0x48); Byte(0x83); Byte(0xC4); Byte(iBytes); }
+
+        // mov eax, iValue
+        void MovEax(uint32_t iValue) { Byte(0xB8); Dword(iValue); }
+
+        // xmm, [iBase + iDisp]
+        void Sse(SSE Instr, int iXmm, Reg iBase, uint32_t iDisp)
+        {
+            Byte(Instr.iPrefix);
+            if (iBase >= 8) Byte(0x41);
+            Byte(0x0F);
+            Byte(Instr.iOpCode);
+            Byte(0x80 | (iXmm << 3) | (iBase & 7)); // [base + disp32]
+            if ((iBase & 7) == 4) Byte(0x24);       // SIB for rsp/r12
+            Dword(iDisp);
+        }
+
+        // xmm, xmm
+        void Sse(SSE Instr, int iXmmDest, int iXmmSrc)
+        {
+            Byte(Instr.iPrefix);
+            Byte(0x0F);
+            Byte(Instr.iOpCode);
+            Byte(0xC0 | (iXmmDest << 3) | iXmmSrc);
+        }
+
+        // psrlq xmm, iBits
+        void PsrlqXmm(int iXmm, uint8_t iBits)
+        {
+            Byte(0x66); Byte(0x0F); Byte(0x73); Byte(0xD0 | iXmm); Byte(iBits);
+        }
+
+        // Direct call if the target is within reach of rel32, otherwise through rax
+        void Call(const void* pTarget)
+        {
+            const auto iNext{ reinterpret_cast<intptr_t>(pBase + Position() + 5) };
+            const auto iRel{ reinterpret_cast<intptr_t>(pTarget) - iNext };
+
+            if (iRel >= INT32_MIN && iRel <= INT32_MAX)
+            {
+                Byte(0xE8);
+                Dword(static_cast<uint32_t>(iRel));
+            }
+            else
+            {
+                Byte(0x48); Byte(0xB8); Qword(reinterpret_cast<uint64_t>(pTarget));
+                Byte(0xFF); Byte(0xD0);
+            }
+        }
+
+        // jp rel32 / jmp rel32 with the target to be patched in; returns the position of rel32
+        size_t Jp() { Byte(0x0F); Byte(0x8A); Dword(0); return Position() - 4; }
+        size_t Jmp() { Byte(0xE9); Dword(0); return Position() - 4; }
+
+        // Make the rel32 at iFixup jump to iTarget
+        void Patch(size_t iFixup, size_t iTarget)
+        {
+            const auto iRel{ static_cast<uint32_t>(iTarget - (iFixup + 4)) };
+            for (int it = 0; it < 4; ++it) code[iFixup + it] = static_cast<uint8_t>(iRel >> (8 * it));
+        }
+
+    private:
+
+        const uint8_t* pBase;
+    };
+
+} // namespace
+
+#endif //MATH_PARSER_JIT_X64
+
+NativeCode::~NativeCode()
+{
+    Free();
+}
+
+NativeCode::NativeCode(NativeCode&& Other) noexcept :
+    pFunction{ Other.pFunction }, iSize{ Other.iSize }
+{
+    Other.pFunction = nullptr;
+    Other.iSize = 0;
+}
+
+NativeCode& NativeCode::operator = (NativeCode&& Other) noexcept
+{
+    if (this != &Other)
+    {
+        Free();
+        pFunction = Other.pFunction;
+        iSize = Other.iSize;
+        Other.pFunction = nullptr;
+        Other.iSize = 0;
+    }
+
+    return *this;
+}
+
+void NativeCode::Free()
+{
+#ifdef MATH_PARSER_JIT_X64
+    if (pFunction) FreeCode(reinterpret_cast<void*>(pFunction), iSize);
+#endif //MATH_PARSER_JIT_X64
+    pFunction = nullptr;
+    iSize = 0;
+}
+
+// The generated function:
+//
+//     uint32_t f(const double* rgdArgs, double* rgdTemps, const double* rgdConsts, double* pValue)
+//
+// keeps its arguments in callee-saved registers for the whole run and computes
+// every command in xmm0. The result of a command is stored to its memory index,
+// but is not loaded back if the next command uses it as the first operand, so
+// a chain of commands runs in xmm0. A superinstruction stores only its second
+// result. With the check for floating point errors, a result that is not finite
+// makes the function return 1 + the index of the command, through a stub placed
+// after the function body. With deferred checks, only the CheckMem commands
+// check their value, the same way.
+//
+NativeCode NativeCode::Translate(const CompiledProgram& Program)
+{
+    NativeCode Native;
+
+#ifdef MATH_PARSER_JIT_X64
+
+    const auto& code{ Program.code };
+    const auto iVars{ Program.variables.size() };
+
+    // Memory and constant offsets should fit in disp32
+    constexpr size_t max_index{ 0x0FFFFFFF };
+    if (Program.iMemorySize > max_index || Program.constants.size() > max_index) return Native;
+
+    if (code.empty() || code.front().iOpCode == CompiledCommand::Error) return Native;
+
+    // No command takes more than 80 bytes including its error stub, except
+    // PolynomialMem, which takes up to 14 more per degree (mulsd xmm, xmm and
+    // addsd xmm, [base + disp32])
+
+    constexpr size_t prologue_size{ 64 }, command_size{ 80 }, polynomial_term_size{ 14 };
+    auto iCapacity{ prologue_size + command_size * code.size() };
+
+    for (const auto& Cmd : code)
+        if (Cmd.iOpCode == CompiledCommand::PolynomialMem)
+            iCapacity += polynomial_term_size *
+                static_cast<size_t>(Program.constants[Cmd.iSecondOperand]);
+
+    const auto pMem{ static_cast<uint8_t*>(AllocateCode(iCapacity)) };
+    if (!pMem) return Native;
+
+    Assembler Asm{ pMem };
+    Asm.code.reserve(iCapacity);
+
+    // Prologue: save the callee-saved registers, keep rsp 16-byte aligned at calls
+    // and reserve the 32-byte shadow space required by the Windows x64 ABI
+
+    constexpr uint8_t frame_size{ 40 };
+
+    Asm.Push(RBX); Asm.Push(R12); Asm.Push(R13); Asm.Push(R14);
+    Asm.SubRsp(frame_size);
+    Asm.Mov(ArgsBase, rgArgRegs[0]);
+    Asm.Mov(TempsBase, rgArgRegs[1]);
+    Asm.Mov(ConstsBase, rgArgRegs[2]);
+    Asm.Mov(ValuePtr, rgArgRegs[3]);
+
+    auto Mem = [iVars](uint32_t iIndex, Reg& iBase) -> uint32_t
+    {
+        if (iIndex < iVars)
+        {
+            iBase = ArgsBase;
+            return static_cast<uint32_t>(sizeof(double) * iIndex);
+        }
+
+        iBase = TempsBase;
+        return static_cast<uint32_t>(sizeof(double) * (iIndex - iVars));
+    };
+
+    // Load memory index / constant into xmm, or use it as the operand of Instr
+
+    auto OpMem = [&Asm, &Mem](SSE Instr, int iXmm, uint32_t iIndex)
+    {
+        Reg iBase{};
+        const auto iDisp{ Mem(iIndex, iBase) };
+        Asm.Sse(Instr, iXmm, iBase, iDisp);
+    };
+
+    auto OpConst = [&Asm](SSE Instr, int iXmm, uint32_t iIndex)
+    {
+        Asm.Sse(Instr, iXmm, ConstsBase, static_cast<uint32_t>(sizeof(double) * iIndex));
+    };
+
+    constexpr uint32_t none{ UINT32_MAX };
+    uint32_t iInXmm0{ none }; // memory index whose value is in xmm0
+
+    auto LoadMem = [&](uint32_t iIndex)
+    {
+        if (iIndex != iInXmm0) OpMem(MOVSD_LOAD, 0, iIndex);
+    };
+
+    // x + y etc. in xmm0
+
+    auto Arithmetic = [&](const CompiledCommand& Cmd, CompiledCommand::OpCodes iOpCode)
+    {
+        const auto iOp{ iOpCode % 5 };        // MathLexeme::MathLexBiItem
+        const auto iKind{ iOpCode - iOp };    // PlusMemMem, PlusMemConst or PlusConstMem
+
+        // x + y with y in xmm0 is computed as y + x
+
+        const bool fSwap{ iKind == CompiledCommand::PlusMemMem &&
+            (iOp == MathLexeme::Plus || iOp == MathLexeme::Multiply) &&
+            Cmd.iSecondOperand == iInXmm0 && Cmd.iFirstOperand != iInXmm0 };
+
+        const auto iSecond{ fSwap ? Cmd.iFirstOperand : Cmd.iSecondOperand };
+
+        // xmm0 = first operand
+
+        if (iKind == CompiledCommand::PlusConstMem)
+            OpConst(MOVSD_LOAD, 0, Cmd.iFirstOperand);
+        else
+            if (!fSwap) LoadMem(Cmd.iFirstOperand);
+
+        if (iOp == MathLexeme::Power)
+        {
+            if (iKind == CompiledCommand::PlusMemConst)
+                OpConst(MOVSD_LOAD, 1, iSecond);
+            else
+                OpMem(MOVSD_LOAD, 1, iSecond);
+
+            Asm.Call(reinterpret_cast<const void*>(MathLexeme::mypow));
+        }
+        else
+        {
+            if (iKind == CompiledCommand::PlusMemConst)
+                OpConst(rgArithmetic[iOp], 0, iSecond);
+            else
+                OpMem(rgArithmetic[iOp], 0, iSecond);
+        }
+    };
+
+    // Load the second operand of Cmd, memory or constant, into xmm / use it in Instr
+
+    auto OpSecond = [&](SSE Instr, int iXmm, const CompiledCommand& Cmd)
+    {
+        if (Cmd.IsSecondOperandMem())
+            OpMem(Instr, iXmm, Cmd.iSecondOperand);
+        else
+            OpConst(Instr, iXmm, Cmd.iSecondOperand);
+    };
+
+    // the jp to patch, the command whose result is checked, and for a
+    // superinstruction the memory index of its first result, kept in xmm2
+
+    struct ErrorFixup {
+        size_t      iJump;
+        uint32_t    iCommand;
+        uint32_t    iFirstResult;
+    };
+
+    vector<ErrorFixup> error_fixups;
+
+    for (size_t it = 0; it < code.size(); ++it)
+    {
+        const auto& Cmd{ code[it] };
+        const auto iOpCode{ Cmd.iOpCode };
+        auto iFirstResult{ none };
+
+        if (iOpCode == CompiledCommand::EndMem || iOpCode == CompiledCommand::EndConst)
+        {
+            if (iOpCode == CompiledCommand::EndMem)
+                LoadMem(Cmd.iFirstOperand);
+            else
+                OpConst(MOVSD_LOAD, 0, Cmd.iFirstOperand);
+
+            Asm.Sse(MOVSD_STORE, 0, ValuePtr, 0);
+            break;
+        }
+
+        if (iOpCode == CompiledCommand::CheckMem)
+        {
+            // the test done after every command without deferred checks, below
+
+            if (Cmd.iFirstOperand == iInXmm0)
+                Asm.Sse(MOVAPD, 1, 0);
+            else
+                OpMem(MOVSD_LOAD, 1, Cmd.iFirstOperand);
+
+            Asm.Sse(SUBSD, 1, 1);
+            Asm.Sse(UCOMISD, 1, 1);
+            error_fixups.push_back({ Asm.Jp(), static_cast<uint32_t>(it), none });
+            continue;
+        }
+
+        if (iOpCode == CompiledCommand::CallFunction)
+        {
+            LoadMem(Cmd.iFirstOperand);
+            Asm.Call(reinterpret_cast<const void*>(
+                MathLexeme::FunctionAddress[Cmd.iSecondOperand]));
+        }
+        else if (iOpCode == CompiledCommand::SqrtMem)
+        {
+            LoadMem(Cmd.iFirstOperand);
+            Asm.Sse(SQRTSD, 0, 0);
+        }
+        else if (iOpCode == CompiledCommand::AbsMem)
+        {
+            // clear the sign bit with the mask 0x7FF...F, all ones shifted right
+
+            LoadMem(Cmd.iFirstOperand);
+            Asm.Sse(PCMPEQD, 1, 1);
+            Asm.PsrlqXmm(1, 1);
+            Asm.Sse(ANDPD, 0, 1);
+        }
+        else if (iOpCode == CompiledCommand::FloorMem)
+        {
+            // no rounding instruction in SSE2, but no need for myint either
+
+            LoadMem(Cmd.iFirstOperand);
+            Asm.Call(reinterpret_cast<const void*>(static_cast<double (*)(double)>(floor)));
+        }
+        else if (iOpCode == CompiledCommand::PowerMemInt)
+        {
+            // the multiplications of MathLexeme::myintpow, x in xmm0, the result in xmm1
+
+            LoadMem(Cmd.iFirstOperand);
+
+            auto iPower{ Cmd.iSecondOperand };
+
+            for (; iPower % 2 == 0; iPower /= 2) Asm.Sse(MULSD, 0, 0);
+
+            Asm.Sse(MOVAPD, 1, 0);
+
+            while (iPower /= 2)
+            {
+                Asm.Sse(MULSD, 0, 0);
+                if (iPower % 2) Asm.Sse(MULSD, 1, 0);
+            }
+
+            Asm.Sse(MOVAPD, 0, 1);
+        }
+        else if (iOpCode == CompiledCommand::PolynomialMem)
+        {
+            // the operations of MathLexeme::mypolynomial, x in xmm1
+
+            LoadMem(Cmd.iFirstOperand);
+            Asm.Sse(MOVAPD, 1, 0);
+
+            const auto iDegree{ static_cast<uint32_t>(Program.constants[Cmd.iSecondOperand]) };
+            OpConst(MOVSD_LOAD, 0, Cmd.iSecondOperand + 1);
+
+            for (uint32_t iPower = 1; iPower <= iDegree; ++iPower)
+            {
+                Asm.Sse(MULSD, 0, 1);
+                OpConst(ADDSD, 0, Cmd.iSecondOperand + iPower + 1);
+            }
+        }
+        else if (Cmd.IsFunctionPair())
+        {
+            // the helper stores both results; the sine is then kept in xmm2
+            // for the error stub, as the first result of a superinstruction
+
+            const auto& Second{ code[++it] };
+            iFirstResult = Cmd.iResult;
+
+            LoadMem(Cmd.iFirstOperand);
+
+            auto LeaMem = [&](Reg iDest, uint32_t iIndex)
+            {
+                Reg iBase{};
+                const auto iDisp{ Mem(iIndex, iBase) };
+                Asm.Lea(iDest, iBase, iDisp);
+            };
+
+            LeaMem(rgArgRegs[first_pointer_after_double], Cmd.iResult);
+            LeaMem(rgArgRegs[first_pointer_after_double + 1], Second.iResult);
+
+            Asm.Call(reinterpret_cast<const void*>(iOpCode == CompiledCommand::SinCosMem ?
+                MathLexeme::mysincos : MathLexeme::mysinhcosh));
+
+            OpMem(MOVSD_LOAD, 2, Cmd.iResult);
+            OpMem(MOVSD_LOAD, 0, Second.iResult);
+        }
+        else if (Cmd.IsFused())
+        {
+            // The result of the first operation is not stored: it stays in xmm0
+            // for the second one, and a copy in xmm2 for the error stub
+
+            const auto& Second{ code[++it] };
+            iFirstResult = Cmd.iResult;
+
+            if (iOpCode >= CompiledCommand::FusedMultiplyAddMemMemMem &&
+                iOpCode <= CompiledCommand::FusedMultiplyAddMemConstConst)
+            {
+                LoadMem(Cmd.iFirstOperand);
+                OpSecond(MOVSD_LOAD, 1, Cmd);
+                OpSecond(MOVSD_LOAD, 2, Second);
+
+                Asm.Call(reinterpret_cast<const void*>(
+                    static_cast<double (*)(double, double, double)>(fma)));
+
+                OpMem(MOVSD_LOAD, 2, Cmd.iFirstOperand);
+                OpSecond(MULSD, 2, Cmd);
+            }
+            else
+            {
+                Arithmetic(Cmd, Cmd.FirstOperation());
+                Asm.Sse(MOVAPD, 2, 0);
+
+                iInXmm0 = Cmd.iResult;
+                Arithmetic(Second, static_cast<CompiledCommand::OpCodes>(Second.iOpCode));
+            }
+        }
+        else
+            Arithmetic(Cmd, static_cast<CompiledCommand::OpCodes>(iOpCode));
+
+        OpMem(MOVSD_STORE, 0, code[it].iResult);
+        iInXmm0 = code[it].iResult;
+
+#if defined(MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS) && !defined(MATH_PARSER_DEFER_FLOATING_POINT_CHECKS)
+
+        // x - x is NaN (unordered) only if x is inf or NaN; no check if
+        // AnalyzeRanges has proved the result finite
+
+        if (!(code[it].iFlags & CompiledCommand::Finite))
+        {
+            Asm.Sse(MOVAPD, 1, 0);
+            Asm.Sse(SUBSD, 1, 1);
+            Asm.Sse(UCOMISD, 1, 1);
+            error_fixups.push_back({ Asm.Jp(), static_cast<uint32_t>(it), iFirstResult });
+        }
+
+#else //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS && !MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+
+        (void)iFirstResult;
+
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS && !MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+    }
+
+    // Epilogue: return 0, or the value of eax set by an error stub
+
+    Asm.Byte(0x31); Asm.Byte(0xC0); // xor eax, eax
+    const auto iEpilogue{ Asm.Position() };
+
+    Asm.AddRsp(frame_size);
+    Asm.Pop(R14); Asm.Pop(R13); Asm.Pop(R12); Asm.Pop(RBX);
+    Asm.Byte(0xC3); // ret
+
+    for (const auto& Fixup : error_fixups)
+    {
+        Asm.Patch(Fixup.iJump, Asm.Position());
+
+        if (Fixup.iFirstResult != none)
+        {
+            // the first operation of a superinstruction has failed if its
+            // result is not finite: store it and report the first command
+
+            Asm.Sse(MOVAPD, 1, 2);
+            Asm.Sse(SUBSD, 1, 1);
+            Asm.Sse(UCOMISD, 1, 1);
+            const auto iFirstFailed{ Asm.Jp() };
+
+            Asm.MovEax(Fixup.iCommand + 1);
+            Asm.Patch(Asm.Jmp(), iEpilogue);
+
+            Asm.Patch(iFirstFailed, Asm.Position());
+            OpMem(MOVSD_STORE, 2, Fixup.iFirstResult);
+            Asm.MovEax(Fixup.iCommand);
+            Asm.Patch(Asm.Jmp(), iEpilogue);
+            continue;
+        }
+
+        Asm.MovEax(Fixup.iCommand + 1);
+        Asm.Patch(Asm.Jmp(), iEpilogue);
+    }
+
+    if (Asm.code.size() > iCapacity)
+    {
+        FreeCode(pMem, iCapacity);
+        return Native;
+    }
+
+    memcpy(pMem, Asm.code.data(), Asm.code.size());
+
+    if (!ProtectCode(pMem, iCapacity))
+    {
+        FreeCode(pMem, iCapacity);
+        return Native;
+    }
+
+    Native.pFunction = reinterpret_cast<Function>(pMem);
+    Native.iSize = iCapacity;
+
+#else //MATH_PARSER_JIT_X64
+
+    (void)Program;
+
+#endif //MATH_PARSER_JIT_X64
+
+    return Native;
+}
+
+bool MathParser::CompileNative(size_t iIndex)
+{
+    auto& Program{ compiled_code[iIndex] };
+
+    Program.native = NativeCode::Translate(Program);
+    return static_cast<bool>(Program.native);
+}
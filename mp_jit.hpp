@@ -0,0 +1,68 @@
+//
+// Native code produced from the compiled code by MathParser::CompileNative
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define MATH_PARSER_JIT_X64
+#endif //x86-64
+
+struct CompiledProgram;
+
+// Owns a piece of executable memory holding the translation of a CompiledProgram.
+// Empty if the program has not been translated, or the platform is not supported.
+//
+class NativeCode {
+
+public:
+
+    NativeCode() = default;
+    ~NativeCode();
+
+    NativeCode(const NativeCode&) = delete;
+    NativeCode& operator = (const NativeCode&) = delete;
+    NativeCode(NativeCode&&) noexcept;
+    NativeCode& operator = (NativeCode&&) noexcept;
+
+    // Translate Program, whose first memory indices are the user variables listed
+    // in Program.variables. Returns an empty object if the translation is not possible.
+    //
+    static NativeCode Translate(const CompiledProgram& Program);
+
+    explicit operator bool() const;
+
+    // Run the code: the values of the user variables listed in Program.variables
+    // are read from rgdArgs in that order, intermediate values are stored in
+    // rgdTemps (the first index after the variables is rgdTemps[0]), constants are
+    // read from rgdConsts. Returns 0 and stores the result in dValue on success.
+    // Otherwise returns 1 + the index of the command whose result is not finite
+    // (only when checking for floating point errors), its result being stored
+    // in rgdTemps anyway.
+    //
+    uint32_t Run(
+        const double* rgdArgs, double* rgdTemps, const double* rgdConsts, double& dValue) const;
+
+private:
+
+    using Function = uint32_t (*)(const double*, double*, const double*, double*);
+
+    void Free();
+
+    Function    pFunction{ nullptr };
+    size_t      iSize{};
+};
+
+inline NativeCode::operator bool() const
+{
+    return pFunction != nullptr;
+}
+
+inline uint32_t NativeCode::Run(
+    const double* rgdArgs, double* rgdTemps, const double* rgdConsts, double& dValue) const
+{
+    return pFunction(rgdArgs, rgdTemps, rgdConsts, &dValue);
+}
@@ -1,295 +1,320 @@
-#include <cmath>
-#include "mp_mystack.hpp"
-
-// MathLexeme static members
-
-// Priority [BinaryOp1][BinaryOp2]==true
-// if BinaryOp1 has higher priority than BinaryOp2 in this context:
-// <X> <BinaryOp1> <Y> <BinaryOp2> <Z>
-//
-constexpr bool MathLexeme::IsPriorityHigher[5][5] =
-{
-    {true,  true, false, false, false},
-    {true,  true, false, false, false},
-    {true,  true,  true,  true, false},
-    {true,  true,  true,  true, false},
-    {true,  true,  true,  true, false}
-};
-
-const wchar_t *const MathLexeme::FunctionID[MathLexNumberOfFunctions] =
-{
-    L"sqrt", L"exp", L"ln", L"lg", L"log",
-    L"sin", L"cos", L"sec", L"csc", L"tg", L"ctg", L"tan", L"cot",
-    L"arcsin", L"arccos", L"arcsec", L"arccsc", L"arctg", L"arcctg", L"arctan", L"arccot",
-    L"sech", L"csch", L"sh", L"ch", L"th", L"cth", L"sinh", L"cosh", L"tanh", L"coth",
-    L"arsh", L"arch", L"arth", L"arcth", L"arsech", L"arcsch",
-    L"arcsinh", L"arccosh", L"arctanh", L"arccoth", L"arcsech", L"arccsch",
-    L"abs", L"int"
-};
-
-constexpr bool MathLexeme::IsFunctionAllowed[MathLexNumberOfFunctions] =
-{
-    true, true, true, true, true, 
-    true, true, true, true, true, true, true, true, 
-    true, true, true, true, true, true, true, true, 
-    true, true, true, true, true, true, true, true, true, true, 
-    true, true, true, true, true, true, 
-    true, true, true, true, true, true, 
-    true, true        
-};
-
-constexpr double(*const MathLexeme::FunctionAddress[MathLexNumberOfFunctions])(double) =
-{
-    MathLexeme::mysqrt, MathLexeme::myexp, MathLexeme::myln, MathLexeme::mylg, 
-    MathLexeme::mylog, MathLexeme::mysin, MathLexeme::mycos, MathLexeme::mysec,
-    MathLexeme::mycsc, MathLexeme::mytg, MathLexeme::myctg, MathLexeme::mytan,
-    MathLexeme::mycot, MathLexeme::myarcsin, MathLexeme::myarccos, MathLexeme::myarcsec,
-    MathLexeme::myarccsc, MathLexeme::myarctg, MathLexeme::myarcctg, MathLexeme::myarctan,
-    MathLexeme::myarccot, MathLexeme::mysech, MathLexeme::mycsch, MathLexeme::mysh,
-    MathLexeme::mych, MathLexeme::myth, MathLexeme::mycth, MathLexeme::mysinh,
-    MathLexeme::mycosh, MathLexeme::mytanh, MathLexeme::mycoth, MathLexeme::myarsh,
-    MathLexeme::myarch, MathLexeme::myarth, MathLexeme::myarcth, MathLexeme::myarsech,
-    MathLexeme::myarcsch, MathLexeme::myarcsinh, MathLexeme::myarccosh, MathLexeme::myarctanh,
-    MathLexeme::myarccoth, MathLexeme::myarcsech, MathLexeme::myarccsch, MathLexeme::myabs,
-    MathLexeme::myint
-};
-
-const wchar_t *const MathLexeme::ConstantID[MathLexNumberOfConstants]=
-{
-    L"pi", L"e"
-};
-
-constexpr bool MathLexeme::IsConstantAllowed[MathLexNumberOfConstants]=
-{
-    true, true
-};
-
-constexpr double MathLexeme::ConstantValue[MathLexNumberOfConstants]=
-{
-    3.14159265358979323846, 2.7182818284590452354
-};
-
-double MathLexeme::mysqrt (double x)
-{
-    return sqrt(x);
-}
-
-double MathLexeme::myexp (double x)
-{
-    return exp(x);
-}
-
-double MathLexeme::myln (double x)
-{
-    return log(x);
-}
-
-double MathLexeme::mylg (double x)
-{
-    return log10(x);
-}
-
-double MathLexeme::mylog (double x)
-{
-    return log10(x);
-}
-
-double MathLexeme::mysin (double x)
-{
-    return sin(x);
-}
-
-double MathLexeme::mycos (double x)
-{
-    return cos(x);
-}
-
-double MathLexeme::mysec (double x)
-{
-    return 1.0/cos(x);
-}
-
-double MathLexeme::mycsc (double x)
-{
-    return 1.0/sin(x);
-}
-
-double MathLexeme::mytg (double x)
-{
-    return tan(x);
-}
-
-double MathLexeme::myctg (double x)
-{
-    return 1.0/tan(x);
-}
-
-double MathLexeme::mytan (double x)
-{
-    return tan(x);
-}
-
-double MathLexeme::mycot (double x)
-{
-    return 1.0/tan(x);
-}
-
-double MathLexeme::myarcsin (double x)
-{
-    return asin(x);
-}
-
-double MathLexeme::myarccos (double x)
-{
-    return acos(x);
-}
-
-double MathLexeme::myarcsec (double x)
-{
-    return acos(1.0/x);
-}
-
-double MathLexeme::myarccsc (double x)
-{
-    return asin(1.0/x);
-}
-
-double MathLexeme::myarctg (double x)
-{
-    return asin(x/sqrt(1.0 + x*x));
-}
-
-double MathLexeme::myarcctg (double x)
-{
-    return acos(x/sqrt(1.0 + x*x));
-}
-
-double MathLexeme::myarctan (double x)
-{
-    return asin(x/sqrt(1.0 + x*x));
-}
-
-double MathLexeme::myarccot (double x)
-{
-    return acos(x/sqrt(1.0 + x*x));
-}
-
-double MathLexeme::mysech (double x)
-{
-    return 1.0/cosh(x);
-}
-
-double MathLexeme::mycsch (double x)
-{
-    return 1.0/sinh(x);
-}
-
-double MathLexeme::mysh (double x)
-{
-    return sinh(x);
-}
-
-double MathLexeme::mych (double x)
-{
-    return cosh(x);
-}
-
-double MathLexeme::myth (double x)
-{
-    return tanh(x);
-}
-
-double MathLexeme::mycth (double x)
-{
-    return 1.0/tanh(x);
-}
-
-double MathLexeme::mysinh (double x)
-{
-    return sinh(x);
-}
-
-double MathLexeme::mycosh (double x)
-{
-    return cosh(x);
-}
-
-double MathLexeme::mytanh (double x)
-{
-    return tanh(x);
-}
-
-double MathLexeme::mycoth (double x)
-{
-    return 1.0/tanh(x);
-}
-
-double MathLexeme::myarsh (double x)
-{
-    return log(x + sqrt(x*x + 1.0));
-}
-
-double MathLexeme::myarch (double x)
-{
-    return log(x + sqrt(x*x - 1.0));
-}
-
-double MathLexeme::myarth (double x)
-{
-    return log((1.0 + x)/(1.0 - x))/2.0;
-}
-
-double MathLexeme::myarcth (double x)
-{
-    return log((x + 1.0)/(x - 1.0))/2.0;
-}
-
-double MathLexeme::myarsech (double x)
-{
-    return log(1.0/x + sqrt(1.0/(x*x) - 1.0));
-}
-
-double MathLexeme::myarcsch (double x)
-{
-    return log(1.0/x + sqrt(1.0/(x*x) + 1.0));
-}
-
-double MathLexeme::myarcsinh (double x)
-{
-    return log(x + sqrt(x*x + 1.0));
-}
-
-double MathLexeme::myarccosh (double x)
-{
-    return log(x + sqrt(x*x - 1.0));
-}
-
-double MathLexeme::myarctanh (double x)
-{
-    return log((1.0 + x)/(1.0 - x))/2.0;
-}
-
-double MathLexeme::myarccoth (double x)
-{
-    return log((x + 1.0)/(x - 1.0))/2.0;
-}
-
-double MathLexeme::myarcsech (double x)
-{
-    return log(1.0/x + sqrt(1.0/(x*x) - 1.0));
-}
-
-double MathLexeme::myarccsch (double x)
-{
-    return log(1.0/x + sqrt(1.0/(x*x) + 1.0));
-}
-
-double MathLexeme::myabs (double x)
-{
-    return fabs(x);
-}
-
-double MathLexeme::myint (double x)
-{
-    return floor(x);
-}
+#include <cmath>
+#include "mp_mystack.hpp"
+#include "mp_simd.hpp"
+
+// MathLexeme static members
+// (the tables used by the parser are defined in the class)
+
+constexpr void (*const MathLexeme::FunctionArrayAddress[MathLexNumberOfFunctions])(
+    double*, const double*, size_t) =
+{
+    MathLexeme::arraysqrt, MathLexeme::ArrayOf<myexp>, MathLexeme::ArrayOf<myln>,
+    MathLexeme::ArrayOf<mylg>, MathLexeme::ArrayOf<mylog>, MathLexeme::ArrayOf<mysin>,
+    MathLexeme::ArrayOf<mycos>, MathLexeme::ArrayOf<mysec>, MathLexeme::ArrayOf<mycsc>,
+    MathLexeme::ArrayOf<mytg>, MathLexeme::ArrayOf<myctg>, MathLexeme::ArrayOf<mytan>,
+    MathLexeme::ArrayOf<mycot>, MathLexeme::ArrayOf<myarcsin>, MathLexeme::ArrayOf<myarccos>,
+    MathLexeme::ArrayOf<myarcsec>, MathLexeme::ArrayOf<myarccsc>, MathLexeme::ArrayOf<myarctg>,
+    MathLexeme::ArrayOf<myarcctg>, MathLexeme::ArrayOf<myarctan>, MathLexeme::ArrayOf<myarccot>,
+    MathLexeme::ArrayOf<mysech>, MathLexeme::ArrayOf<mycsch>, MathLexeme::ArrayOf<mysh>,
+    MathLexeme::ArrayOf<mych>, MathLexeme::ArrayOf<myth>, MathLexeme::ArrayOf<mycth>,
+    MathLexeme::ArrayOf<mysinh>, MathLexeme::ArrayOf<mycosh>, MathLexeme::ArrayOf<mytanh>,
+    MathLexeme::ArrayOf<mycoth>, MathLexeme::ArrayOf<myarsh>, MathLexeme::ArrayOf<myarch>,
+    MathLexeme::ArrayOf<myarth>, MathLexeme::ArrayOf<myarcth>, MathLexeme::ArrayOf<myarsech>,
+    MathLexeme::ArrayOf<myarcsch>, MathLexeme::ArrayOf<myarcsinh>, MathLexeme::ArrayOf<myarccosh>,
+    MathLexeme::ArrayOf<myarctanh>, MathLexeme::ArrayOf<myarccoth>, MathLexeme::ArrayOf<myarcsech>,
+    MathLexeme::ArrayOf<myarccsch>, MathLexeme::arrayabs, MathLexeme::arrayint
+};
+
+double MathLexeme::mysqrt (double x)
+{
+    return sqrt(x);
+}
+
+double MathLexeme::myexp (double x)
+{
+    return exp(x);
+}
+
+double MathLexeme::myln (double x)
+{
+    return log(x);
+}
+
+double MathLexeme::mylg (double x)
+{
+    return log10(x);
+}
+
+double MathLexeme::mylog (double x)
+{
+    return log10(x);
+}
+
+double MathLexeme::mysin (double x)
+{
+    return sin(x);
+}
+
+double MathLexeme::mycos (double x)
+{
+    return cos(x);
+}
+
+double MathLexeme::mysec (double x)
+{
+    return 1.0/cos(x);
+}
+
+double MathLexeme::mycsc (double x)
+{
+    return 1.0/sin(x);
+}
+
+double MathLexeme::mytg (double x)
+{
+    return tan(x);
+}
+
+double MathLexeme::myctg (double x)
+{
+    return 1.0/tan(x);
+}
+
+double MathLexeme::mytan (double x)
+{
+    return tan(x);
+}
+
+double MathLexeme::mycot (double x)
+{
+    return 1.0/tan(x);
+}
+
+double MathLexeme::myarcsin (double x)
+{
+    return asin(x);
+}
+
+double MathLexeme::myarccos (double x)
+{
+    return acos(x);
+}
+
+double MathLexeme::myarcsec (double x)
+{
+    return acos(1.0/x);
+}
+
+double MathLexeme::myarccsc (double x)
+{
+    return asin(1.0/x);
+}
+
+double MathLexeme::myarctg (double x)
+{
+    return asin(x/sqrt(1.0 + x*x));
+}
+
+double MathLexeme::myarcctg (double x)
+{
+    return acos(x/sqrt(1.0 + x*x));
+}
+
+double MathLexeme::myarctan (double x)
+{
+    return asin(x/sqrt(1.0 + x*x));
+}
+
+double MathLexeme::myarccot (double x)
+{
+    return acos(x/sqrt(1.0 + x*x));
+}
+
+double MathLexeme::mysech (double x)
+{
+    return 1.0/cosh(x);
+}
+
+double MathLexeme::mycsch (double x)
+{
+    return 1.0/sinh(x);
+}
+
+double MathLexeme::mysh (double x)
+{
+    return sinh(x);
+}
+
+double MathLexeme::mych (double x)
+{
+    return cosh(x);
+}
+
+double MathLexeme::myth (double x)
+{
+    return tanh(x);
+}
+
+double MathLexeme::mycth (double x)
+{
+    return 1.0/tanh(x);
+}
+
+double MathLexeme::mysinh (double x)
+{
+    return sinh(x);
+}
+
+double MathLexeme::mycosh (double x)
+{
+    return cosh(x);
+}
+
+double MathLexeme::mytanh (double x)
+{
+    return tanh(x);
+}
+
+double MathLexeme::mycoth (double x)
+{
+    return 1.0/tanh(x);
+}
+
+double MathLexeme::myarsh (double x)
+{
+    return log(x + sqrt(x*x + 1.0));
+}
+
+double MathLexeme::myarch (double x)
+{
+    return log(x + sqrt(x*x - 1.0));
+}
+
+double MathLexeme::myarth (double x)
+{
+    return log((1.0 + x)/(1.0 - x))/2.0;
+}
+
+double MathLexeme::myarcth (double x)
+{
+    return log((x + 1.0)/(x - 1.0))/2.0;
+}
+
+double MathLexeme::myarsech (double x)
+{
+    return log(1.0/x + sqrt(1.0/(x*x) - 1.0));
+}
+
+double MathLexeme::myarcsch (double x)
+{
+    return log(1.0/x + sqrt(1.0/(x*x) + 1.0));
+}
+
+double MathLexeme::myarcsinh (double x)
+{
+    return log(x + sqrt(x*x + 1.0));
+}
+
+double MathLexeme::myarccosh (double x)
+{
+    return log(x + sqrt(x*x - 1.0));
+}
+
+double MathLexeme::myarctanh (double x)
+{
+    return log((1.0 + x)/(1.0 - x))/2.0;
+}
+
+double MathLexeme::myarccoth (double x)
+{
+    return log((x + 1.0)/(x - 1.0))/2.0;
+}
+
+double MathLexeme::myarcsech (double x)
+{
+    return log(1.0/x + sqrt(1.0/(x*x) - 1.0));
+}
+
+double MathLexeme::myarccsch (double x)
+{
+    return log(1.0/x + sqrt(1.0/(x*x) + 1.0));
+}
+
+double MathLexeme::myabs (double x)
+{
+    return fabs(x);
+}
+
+double MathLexeme::myint (double x)
+{
+    return floor(x);
+}
+
+template<double (*Function)(double)>
+void MathLexeme::ArrayOf(double* pResult, const double* pOp, size_t iRows)
+{
+    for (size_t it = 0; it < iRows; ++it)
+        pResult[it] = Function(pOp[it]);
+}
+
+void MathLexeme::arraysqrt(double* pResult, const double* pOp, size_t iRows)
+{
+    MathKernels::Selected().Sqrt(pResult, pOp, iRows);
+}
+
+void MathLexeme::arrayabs(double* pResult, const double* pOp, size_t iRows)
+{
+    MathKernels::Selected().Abs(pResult, pOp, iRows);
+}
+
+void MathLexeme::arrayint(double* pResult, const double* pOp, size_t iRows)
+{
+    MathKernels::Selected().Floor(pResult, pOp, iRows);
+}
+
+// glibc's sincos shares the range reduction, and gives the values of sin and cos
+//
+void MathLexeme::mysincos(double x, double* pSin, double* pCos)
+{
+#ifdef __GLIBC__
+    sincos(x, pSin, pCos);
+#else //__GLIBC__
+    *pSin = sin(x);
+    *pCos = cos(x);
+#endif //__GLIBC__
+}
+
+// With u = e^|x| - 1, sinh |x| = (u + u / e^|x|) / 2, accurate near 0 too, and
+// cosh x = (e^|x| + 1 / e^|x|) / 2. The library functions take over where
+// e^|x| overflows while sinh and cosh may not yet, and for NaN.
+//
+void MathLexeme::mysinhcosh(double x, double* pSinh, double* pCosh)
+{
+    if (fabs(x) < 709)
+    {
+        const auto u{ expm1(fabs(x)) };
+        const auto e{ u + 1 }, r{ 1 / e };
+
+        *pSinh = copysign(0.5 * (u + u * r), x);
+        *pCosh = 0.5 * (e + r);
+    }
+    else
+    {
+        *pSinh = sinh(x);
+        *pCosh = cosh(x);
+    }
+}
+
+// pOp may be the same array as pSin or pCos
+
+void MathLexeme::arraysincos(double* pSin, double* pCos, const double* pOp, size_t iRows)
+{
+    for (size_t it = 0; it < iRows; ++it)
+        mysincos(pOp[it], pSin + it, pCos + it);
+}
+
+void MathLexeme::arraysinhcosh(double* pSinh, double* pCosh, const double* pOp, size_t iRows)
+{
+    for (size_t it = 0; it < iRows; ++it)
+        mysinhcosh(pOp[it], pSinh + it, pCosh + it);
+}
@@ -1,187 +1,440 @@
-//
-// Stack of lexemes used by MathParser
-//
-
-#pragma once
-
-#include <math.h>
-
-class MathLexeme {
-    
-    friend class MyStack;
-    friend class MathParser;
-
-    enum MathLexType {
-
-        Begin       = 0,
-        End         = 1,
-        Number      = 2,
-        Function    = 3,
-        Unary       = 4,
-        Binary      = 5,
-        LeftPar     = 6,
-        RightPar    = 7
-    };
-
-    enum MathLexNumItem { Constant, Variable };
-    enum MathLexBiItem { Plus = 0, Minus = 1, Multiply = 2, Divide = 3, Power = 4 };
-
-    MathLexeme() = default;
-    explicit MathLexeme(MathLexType iType);
-    MathLexeme(MathLexType iType, int iItem);
-    MathLexeme(MathLexType iType, int iItem, double dValue);
-
-    MathLexType iType{};                // type of lexeme
-    int         iItem{ 0 };             // sub-type
-    double      dValue{ 0.0 };          // value of a variable (for Number/Constant)
-    double      (*pFunction)(double) { nullptr };  // pointer to a function (for Function)
-    size_t      iPosition{ 0 };         // position in the string (for error reporting)
-    size_t      iRunTimeIndex{ 0 };     // index of value stored in RunTimeMemory
-
-    static constexpr size_t MathLexNumberOfFunctions{ 45 };
-    static constexpr size_t MathLexNumberOfConstants{ 2 };
-
-    static const bool IsPriorityHigher[5][5];
-
-    static double (*const BinaryOpAddress[5])(double, double);
-
-    static const wchar_t *const FunctionID[MathLexNumberOfFunctions];
-    static const bool IsFunctionAllowed[MathLexNumberOfFunctions];
-    static double (*const FunctionAddress[MathLexNumberOfFunctions])(double);
-
-    static const wchar_t *const ConstantID[MathLexNumberOfConstants];
-    static const bool IsConstantAllowed[MathLexNumberOfConstants];
-    static const double ConstantValue[MathLexNumberOfConstants];
-
-    static double mysqrt(double);
-    static double myexp(double);
-    static double myln(double);
-    static double mylg(double);
-    static double mylog(double);
-    static double mysin(double);
-    static double mycos(double);
-    static double mysec(double);
-    static double mycsc(double);
-    static double mytg(double);
-    static double myctg(double);
-    static double mytan(double);
-    static double mycot(double);
-    static double myarcsin(double);
-    static double myarccos(double);
-    static double myarcsec(double);
-    static double myarccsc(double);
-    static double myarctg(double);
-    static double myarcctg(double);
-    static double myarctan(double);
-    static double myarccot(double);
-    static double mysech(double);
-    static double mycsch(double);
-    static double mysh(double);
-    static double mych(double);
-    static double myth(double);
-    static double mycth(double);
-    static double mysinh(double);
-    static double mycosh(double);
-    static double mytanh(double);
-    static double mycoth(double);
-    static double myarsh(double);
-    static double myarch(double);
-    static double myarth(double);
-    static double myarcth(double);
-    static double myarsech(double);
-    static double myarcsch(double);
-    static double myarcsinh(double);
-    static double myarccosh(double);
-    static double myarctanh(double);
-    static double myarccoth(double);
-    static double myarcsech(double);
-    static double myarccsch(double);
-    static double myabs(double);
-    static double myint(double);
-};
-
-inline MathLexeme::MathLexeme(MathLexType iType) : iType(iType)
-{
-}
-
-inline MathLexeme::MathLexeme(MathLexType iType, int iItem)
-    : iType(iType), iItem(iItem)
-{
-}
-
-inline MathLexeme::MathLexeme(MathLexType iType, int iItem, double dValue)
-    : iType(iType), iItem(iItem), dValue(dValue)
-{
-}
-
-class MyStack { // unsafe but fast
-    
-    friend class MathParser;
-
-    MyStack() noexcept;
-    ~MyStack();
-    void Resize(size_t iNewSize);
-    operator MathLexeme* () const;
-    void Push(const MathLexeme& Lexeme);
-    void Pop();
-    void Pop(MathLexeme& Lexeme);
-    MathLexeme Top();
-    MathLexeme SecondFromTop();
-    void Reset();
-
-    MathLexeme* pMemory;
-    size_t      iTopOfStack;
-    size_t      iCurrentStackSize;
-};
-
-inline MyStack::MyStack() noexcept
-    : pMemory{ nullptr }, iTopOfStack{ 0 }, iCurrentStackSize{ 0 }
-{
-}
-
-inline MyStack::~MyStack()
-{
-    delete *this;
-}
-
-inline void MyStack::Resize(size_t iNewSize)
-{
-    delete *this;
-    pMemory = new MathLexeme[iNewSize * sizeof(MathLexeme)]{};
-    iCurrentStackSize = iNewSize;
-}
-
-inline MyStack::operator MathLexeme* () const
-{
-    return pMemory;
-}
-
-inline void MyStack::Push(const MathLexeme& Lexeme)
-{
-    pMemory[iTopOfStack++] = Lexeme;    
-}
-
-inline void MyStack::Pop()
-{
-    --iTopOfStack;
-}
-
-inline void MyStack::Pop(MathLexeme& Lexeme)
-{
-    Lexeme = pMemory[--iTopOfStack];
-}
-
-inline MathLexeme MyStack::Top()
-{
-    return pMemory[iTopOfStack - 1];
-}
-
-inline MathLexeme MyStack::SecondFromTop()
-{
-    return pMemory[iTopOfStack - 2];
-}
-
-inline void MyStack::Reset()
-{
-    iTopOfStack = 0;
+//
+// Stack of lexemes used by MathParser
+//
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+class MathLexeme {
+    
+    friend class MyStack;
+    friend class MathParser;
+    friend class NativeCode;
+    friend class StaticMathParser;
+
+    enum MathLexType {
+
+        Begin       = 0,
+        End         = 1,
+        Number      = 2,
+        Function    = 3,
+        Unary       = 4,
+        Binary      = 5,
+        LeftPar     = 6,
+        RightPar    = 7
+    };
+
+    enum MathLexNumItem { Constant, Variable };
+    enum MathLexBiItem { Plus = 0, Minus = 1, Multiply = 2, Divide = 3, Power = 4 };
+
+    // Indices of the functions that Compile treats specially (Simplify,
+    // AnalyzeRanges), as in FunctionID
+    enum MathLexFunctionItem {
+        Sqrt = 0, Exp = 1, Ln = 2, Lg = 3, Log = 4, Sin = 5, Cos = 6, Sec = 7, Csc = 8,
+        Tg = 9, Ctg = 10, Tan = 11, Cot = 12, Arctg = 17, Arcctg = 18, Arctan = 19,
+        Arccot = 20, Sh = 23, Ch = 24, Th = 25, Cth = 26, Sinh = 27, Cosh = 28, Tanh = 29,
+        Coth = 30, Abs = 43, Int = 44
+    };
+
+    MathLexeme() = default;
+    explicit MathLexeme(MathLexType iType);
+    MathLexeme(MathLexType iType, int iItem);
+    MathLexeme(MathLexType iType, int iItem, double dValue);
+
+    MathLexType iType{};                // type of lexeme
+    int         iItem{ 0 };             // sub-type
+    double      dValue{ 0.0 };          // value of a variable (for Number/Constant)
+    double      (*pFunction)(double) { nullptr };  // pointer to a function (for Function)
+                                        // (iItem is the index of the function)
+    size_t      iPosition{ 0 };         // position in the string (for error reporting)
+    size_t      iRunTimeIndex{ 0 };     // index of value stored in RunTimeMemory
+
+    static constexpr size_t MathLexNumberOfFunctions{ 45 };
+    static constexpr size_t MathLexNumberOfConstants{ 2 };
+
+    // Priority [BinaryOp1][BinaryOp2]==true
+    // if BinaryOp1 has higher priority than BinaryOp2 in this context:
+    // <X> <BinaryOp1> <Y> <BinaryOp2> <Z>
+    //
+    static constexpr bool IsPriorityHigher[5][5]
+    {
+        {true,  true, false, false, false},
+        {true,  true, false, false, false},
+        {true,  true,  true,  true, false},
+        {true,  true,  true,  true, false},
+        {true,  true,  true,  true, false}
+    };
+
+    static double (*const BinaryOpAddress[5])(double, double);
+
+    static constexpr const wchar_t* FunctionID[MathLexNumberOfFunctions]
+    {
+        L"sqrt", L"exp", L"ln", L"lg", L"log",
+        L"sin", L"cos", L"sec", L"csc", L"tg", L"ctg", L"tan", L"cot",
+        L"arcsin", L"arccos", L"arcsec", L"arccsc", L"arctg", L"arcctg", L"arctan", L"arccot",
+        L"sech", L"csch", L"sh", L"ch", L"th", L"cth", L"sinh", L"cosh", L"tanh", L"coth",
+        L"arsh", L"arch", L"arth", L"arcth", L"arsech", L"arcsch",
+        L"arcsinh", L"arccosh", L"arctanh", L"arccoth", L"arcsech", L"arccsch",
+        L"abs", L"int"
+    };
+
+    static constexpr bool IsFunctionAllowed[MathLexNumberOfFunctions]
+    {
+        true, true, true, true, true, 
+        true, true, true, true, true, true, true, true, 
+        true, true, true, true, true, true, true, true, 
+        true, true, true, true, true, true, true, true, true, true, 
+        true, true, true, true, true, true, 
+        true, true, true, true, true, true, 
+        true, true        
+    };
+
+    // Array versions of the functions: pResult[n] = f(pOp[n]) for n < iRows.
+    // They are called once per block of rows by ExecuteBatch.
+    static void (*const FunctionArrayAddress[MathLexNumberOfFunctions])(
+        double* pResult, const double* pOp, size_t iRows);
+
+    static constexpr const wchar_t* ConstantID[MathLexNumberOfConstants]
+    {
+        L"pi", L"e"
+    };
+
+    static constexpr bool IsConstantAllowed[MathLexNumberOfConstants]
+    {
+        true, true
+    };
+
+    static constexpr double ConstantValue[MathLexNumberOfConstants]
+    {
+        3.14159265358979323846, 2.7182818284590452354
+    };
+
+    // Compare the name of iLength characters with zero-terminated pID
+    static constexpr bool IsNameEqual(
+        const wchar_t* pName, size_t iLength, const wchar_t* pID, bool case_sensitive);
+
+    // FNV-1a hash of the name of iLength characters, the same in any case
+    static constexpr uint32_t NameHash(const wchar_t* pName, size_t iLength);
+
+    // Perfect hash of the names of the functions and the constants, built at
+    // compile time: the multiplier puts each name in its own slot, and an entry
+    // is the index of a function, MathLexNumberOfFunctions + the index of
+    // a constant, or -1 if the slot is empty. A name is looked up in any case,
+    // the caller compares it with the name found.
+    static constexpr unsigned NameTableBits{ 8 };
+
+    struct NameTable {
+        uint32_t    iMultiplier;
+        signed char rgiEntry[size_t{ 1 } << NameTableBits];
+    };
+
+    static constexpr size_t NameSlot(uint32_t iHash, uint32_t iMultiplier);
+    static constexpr NameTable BuildNameTable();
+    static const NameTable BuiltinNames;
+
+    static double mysqrt(double);
+    static double myexp(double);
+    static double myln(double);
+    static double mylg(double);
+    static double mylog(double);
+    static double mysin(double);
+    static double mycos(double);
+    static double mysec(double);
+    static double mycsc(double);
+    static double mytg(double);
+    static double myctg(double);
+    static double mytan(double);
+    static double mycot(double);
+    static double myarcsin(double);
+    static double myarccos(double);
+    static double myarcsec(double);
+    static double myarccsc(double);
+    static double myarctg(double);
+    static double myarcctg(double);
+    static double myarctan(double);
+    static double myarccot(double);
+    static double mysech(double);
+    static double mycsch(double);
+    static double mysh(double);
+    static double mych(double);
+    static double myth(double);
+    static double mycth(double);
+    static double mysinh(double);
+    static double mycosh(double);
+    static double mytanh(double);
+    static double mycoth(double);
+    static double myarsh(double);
+    static double myarch(double);
+    static double myarth(double);
+    static double myarcth(double);
+    static double myarsech(double);
+    static double myarcsch(double);
+    static double myarcsinh(double);
+    static double myarccosh(double);
+    static double myarctanh(double);
+    static double myarccoth(double);
+    static double myarcsech(double);
+    static double myarccsch(double);
+    static double myabs(double);
+    static double myint(double);
+
+    // A loop calling the scalar function for each value, so that the results are
+    // those of Evaluate and Execute; it only saves the indirect call per value
+    template<double (*Function)(double)>
+    static void ArrayOf(double*, const double*, size_t);
+
+    // sqrt, abs and int have exact vector instructions
+    static void arraysqrt(double*, const double*, size_t);
+    static void arrayabs(double*, const double*, size_t);
+    static void arrayint(double*, const double*, size_t);
+
+    // sin x and cos x by one call, the same values as sin and cos give
+    static void mysincos(double x, double* pSin, double* pCos);
+    static void arraysincos(double* pSin, double* pCos, const double* pOp, size_t iRows);
+
+    // sinh x and cosh x from one exponential, not rounded as sinh and cosh (fast math)
+    static void mysinhcosh(double x, double* pSinh, double* pCosh);
+    static void arraysinhcosh(double* pSinh, double* pCosh, const double* pOp, size_t iRows);
+
+    // Addresses of the functions above, indexed as FunctionID
+    static constexpr double (*const FunctionAddress[MathLexNumberOfFunctions])(double)
+    {
+        MathLexeme::mysqrt, MathLexeme::myexp, MathLexeme::myln, MathLexeme::mylg, 
+        MathLexeme::mylog, MathLexeme::mysin, MathLexeme::mycos, MathLexeme::mysec,
+        MathLexeme::mycsc, MathLexeme::mytg, MathLexeme::myctg, MathLexeme::mytan,
+        MathLexeme::mycot, MathLexeme::myarcsin, MathLexeme::myarccos, MathLexeme::myarcsec,
+        MathLexeme::myarccsc, MathLexeme::myarctg, MathLexeme::myarcctg, MathLexeme::myarctan,
+        MathLexeme::myarccot, MathLexeme::mysech, MathLexeme::mycsch, MathLexeme::mysh,
+        MathLexeme::mych, MathLexeme::myth, MathLexeme::mycth, MathLexeme::mysinh,
+        MathLexeme::mycosh, MathLexeme::mytanh, MathLexeme::mycoth, MathLexeme::myarsh,
+        MathLexeme::myarch, MathLexeme::myarth, MathLexeme::myarcth, MathLexeme::myarsech,
+        MathLexeme::myarcsch, MathLexeme::myarcsinh, MathLexeme::myarccosh, MathLexeme::myarctanh,
+        MathLexeme::myarccoth, MathLexeme::myarcsech, MathLexeme::myarccsch, MathLexeme::myabs,
+        MathLexeme::myint
+    };
+
+public:
+
+    // x ^ y, the power operator. x ^ 2, x ^ -1 and x ^ 0.5 are x * x, 1 / x and
+    // sqrt(x), with the values of pow for -0 and -inf: these are correctly
+    // rounded, so they may differ in the last bit from the pow of the C runtime,
+    // which is not always. Compile replaces x ^ 2 and x ^ -1 by the same
+    // commands. Also used by the kernels of ExecuteBatch.
+    static double mypow(double x, double y);
+
+    // x ^ n for 2 <= n <= MathLexMaxIntegerPower by squaring and multiplying,
+    // which Compile uses in place of pow with fast math on
+    static double myintpow(double x, unsigned n);
+
+    // The polynomial pTable of x by Horner's scheme: pTable[0] is its degree n,
+    // followed by the n + 1 coefficients from x ^ n down
+    static double mypolynomial(double x, const double* pTable);
+
+    static constexpr unsigned MathLexMaxIntegerPower{ 8 };
+};
+
+inline MathLexeme::MathLexeme(MathLexType iType) : iType(iType)
+{
+}
+
+inline MathLexeme::MathLexeme(MathLexType iType, int iItem)
+    : iType(iType), iItem(iItem)
+{
+}
+
+inline MathLexeme::MathLexeme(MathLexType iType, int iItem, double dValue)
+    : iType(iType), iItem(iItem), dValue(dValue)
+{
+}
+
+constexpr bool MathLexeme::IsNameEqual(
+    const wchar_t* pName, size_t iLength, const wchar_t* pID, bool case_sensitive)
+{
+    auto Lower = [](wchar_t c) { return c >= 'A' && c <= 'Z' ? static_cast<wchar_t>(c - 'A' + 'a') : c; };
+
+    for (size_t it = 0; it < iLength; ++it)
+    {
+        if (pID[it] == '\0') return false;
+
+        if (case_sensitive ? pName[it] != pID[it] : Lower(pName[it]) != Lower(pID[it]))
+            return false;
+    }
+
+    return pID[iLength] == '\0';
+}
+
+constexpr uint32_t MathLexeme::NameHash(const wchar_t* pName, size_t iLength)
+{
+    auto Lower = [](wchar_t c) { return c >= 'A' && c <= 'Z' ? static_cast<wchar_t>(c - 'A' + 'a') : c; };
+
+    uint32_t iHash{ 2166136261u };
+
+    for (size_t it = 0; it < iLength; ++it)
+        iHash = (iHash ^ static_cast<uint32_t>(Lower(pName[it]))) * 16777619u;
+
+    return iHash;
+}
+
+constexpr size_t MathLexeme::NameSlot(uint32_t iHash, uint32_t iMultiplier)
+{
+    return static_cast<uint32_t>(iHash * iMultiplier) >> (32 - NameTableBits);
+}
+
+// Try the odd multipliers from the golden ratio one until no two names share
+// a slot (a few dozen tries with 47 names in 256 slots)
+//
+constexpr MathLexeme::NameTable MathLexeme::BuildNameTable()
+{
+    constexpr size_t iNames{ MathLexNumberOfFunctions + MathLexNumberOfConstants };
+    uint32_t rgiHash[iNames]{};
+
+    for (size_t it = 0; it < iNames; ++it)
+    {
+        const auto (*const pName) { it < MathLexNumberOfFunctions ?
+            FunctionID[it] : ConstantID[it - MathLexNumberOfFunctions] };
+        size_t iLength{ 0 };
+
+        while (pName[iLength] != '\0') ++iLength;
+
+        rgiHash[it] = NameHash(pName, iLength);
+    }
+
+    for (uint32_t iMultiplier = 0x9E3779B1u; ; iMultiplier += 2)
+    {
+        NameTable Table{ iMultiplier, {} };
+        auto fPerfect{ true };
+
+        for (auto& iEntry : Table.rgiEntry) iEntry = -1;
+
+        for (size_t it = 0; it < iNames && fPerfect; ++it)
+        {
+            auto& iEntry{ Table.rgiEntry[NameSlot(rgiHash[it], iMultiplier)] };
+            fPerfect = iEntry < 0;
+            iEntry = static_cast<signed char>(it);
+        }
+
+        if (fPerfect) return Table;
+    }
+}
+
+inline constexpr MathLexeme::NameTable MathLexeme::BuiltinNames{ BuildNameTable() };
+
+inline double MathLexeme::mypow(double x, double y)
+{
+    if (y == 2) return x * x;
+    if (y == -1) return 1 / x;
+
+    // pow(-0, 0.5) is +0 and pow(-inf, 0.5) is +inf, unlike sqrt
+
+    if (y == 0.5) return x == 0 || x == -HUGE_VAL ? fabs(x) : sqrt(x);
+
+    return pow(x, y);
+}
+
+// x ^ n = (x ^ 2) ^ (n / 2) * x ^ (n % 2), going through the bits of n from
+// the lowest one. NativeCode does the same multiplications in the same order.
+//
+inline double MathLexeme::myintpow(double x, unsigned n)
+{
+    for (; n % 2 == 0; n /= 2) x *= x;
+
+    auto dResult{ x };
+
+    while (n /= 2)
+    {
+        x *= x;
+        if (n % 2) dResult *= x;
+    }
+
+    return dResult;
+}
+
+// ((c[n] * x + c[n - 1]) * x + ...) * x + c[0], rounded after each operation.
+// The kernels of ExecuteBatch and NativeCode do the same operations.
+//
+inline double MathLexeme::mypolynomial(double x, const double* pTable)
+{
+    const auto iDegree{ static_cast<size_t>(pTable[0]) };
+    auto dResult{ pTable[1] };
+
+    for (size_t it = 1; it <= iDegree; ++it)
+        dResult = dResult * x + pTable[it + 1];
+
+    return dResult;
+}
+
+class MyStack { // unsafe but fast
+    
+    friend class MathParser;
+    friend class ExecutionContext;
+
+    MyStack() noexcept;
+    ~MyStack();
+    void Resize(size_t iNewSize);
+    operator MathLexeme* () const;
+    void Push(const MathLexeme& Lexeme);
+    void Pop();
+    void Pop(MathLexeme& Lexeme);
+    MathLexeme Top();
+    MathLexeme SecondFromTop();
+    void Reset();
+
+    MathLexeme* pMemory;
+    size_t      iTopOfStack;
+    size_t      iCurrentStackSize;
+};
+
+inline MyStack::MyStack() noexcept
+    : pMemory{ nullptr }, iTopOfStack{ 0 }, iCurrentStackSize{ 0 }
+{
+}
+
+inline MyStack::~MyStack()
+{
+    delete *this;
+}
+
+inline void MyStack::Resize(size_t iNewSize)
+{
+    delete *this;
+    pMemory = new MathLexeme[iNewSize * sizeof(MathLexeme)]{};
+    iCurrentStackSize = iNewSize;
+}
+
+inline MyStack::operator MathLexeme* () const
+{
+    return pMemory;
+}
+
+inline void MyStack::Push(const MathLexeme& Lexeme)
+{
+    pMemory[iTopOfStack++] = Lexeme;    
+}
+
+inline void MyStack::Pop()
+{
+    --iTopOfStack;
+}
+
+inline void MyStack::Pop(MathLexeme& Lexeme)
+{
+    Lexeme = pMemory[--iTopOfStack];
+}
+
+inline MathLexeme MyStack::Top()
+{
+    return pMemory[iTopOfStack - 1];
+}
+
+inline MathLexeme MyStack::SecondFromTop()
+{
+    return pMemory[iTopOfStack - 2];
+}
+
+inline void MyStack::Reset()
+{
+    iTopOfStack = 0;
 }
\ No newline at end of file
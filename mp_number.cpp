@@ -0,0 +1,76 @@
+//
+// Compile-time checks of DecimalNumber::Read (mp_number.hpp), by which
+// MathParser and StaticMathParser read the numbers in the strings
+//
+
+#include <limits>
+#include "mp_number.hpp"
+
+namespace {
+
+    // The numbers whose rounding is the hardest: the largest and the smallest
+    // doubles, and values exactly or almost halfway between two doubles
+
+    template<size_t N>
+    constexpr double ReadLiteral(const wchar_t (&szNumber)[N])
+    {
+        double dValue{};
+        DecimalNumber::Read(szNumber, N - 1, dValue);
+        return dValue;
+    }
+
+    // 2^-1075, halfway between 0 and the smallest denormal, and the same with
+    // a digit 1 appended
+
+    constexpr wchar_t szHalfDenormal[]{
+        L"2.4703282292062327208828439643411068618252990130716238221279284125033775"
+        L"363510437593264991818081799618989828234772285886546332835517796989819938"
+        L"739800539093906315035659515570226392290858392449105184435931802849936536"
+        L"152500319370457678249219365623669863658480757001585769269903706311928279"
+        L"558551332927834338409351978015531246597263579574622766465272827220056374"
+        L"006485499977096599470454020828166226237857393450736339007967761930577506"
+        L"740176324673600968951340535537458516661134223766678604162159680461914467"
+        L"291840300530057530849048765391711386591646239524912623653881879636239373"
+        L"280423891018672348497668235089863388587925628302755995657524455507255189"
+        L"313690836254779186948667994968324049705821028513185451396213837722826145"
+        L"437693412532098591327667236328125"
+        L"e-324" };
+
+    constexpr wchar_t szAboveHalfDenormal[]{
+        L"2.4703282292062327208828439643411068618252990130716238221279284125033775"
+        L"363510437593264991818081799618989828234772285886546332835517796989819938"
+        L"739800539093906315035659515570226392290858392449105184435931802849936536"
+        L"152500319370457678249219365623669863658480757001585769269903706311928279"
+        L"558551332927834338409351978015531246597263579574622766465272827220056374"
+        L"006485499977096599470454020828166226237857393450736339007967761930577506"
+        L"740176324673600968951340535537458516661134223766678604162159680461914467"
+        L"291840300530057530849048765391711386591646239524912623653881879636239373"
+        L"280423891018672348497668235089863388587925628302755995657524455507255189"
+        L"313690836254779186948667994968324049705821028513185451396213837722826145"
+        L"437693412532098591327667236328125"
+        L"1e-324" };
+}
+
+static_assert(ReadLiteral(L"1.7976931348623157e308") == std::numeric_limits<double>::max(),
+    "the largest double");
+static_assert(ReadLiteral(L"1.7976931348623158e308") == std::numeric_limits<double>::max() &&
+    ReadLiteral(L"1.7976931348623159e308") == std::numeric_limits<double>::infinity(),
+    "the largest double or infinity, rounding from below or above the halfway value");
+static_assert(ReadLiteral(L"4.9406564584124654e-324") == std::numeric_limits<double>::denorm_min() &&
+    ReadLiteral(L"5e-324") == std::numeric_limits<double>::denorm_min(),
+    "the smallest denormal");
+static_assert(ReadLiteral(L"2.4703282292062327e-324") == 0.0 &&
+    ReadLiteral(L"2.4703282292062328e-324") == std::numeric_limits<double>::denorm_min(),
+    "0 or the smallest denormal, rounding from below or above the halfway value");
+static_assert(ReadLiteral(szHalfDenormal) == 0.0 &&
+    ReadLiteral(szAboveHalfDenormal) == std::numeric_limits<double>::denorm_min(),
+    "exactly halfway between 0 and the smallest denormal, and just above");
+static_assert(ReadLiteral(L"9007199254740993") == 9007199254740992.0 &&
+    ReadLiteral(L"9007199254740995") == 9007199254740996.0,
+    "exactly halfway between two doubles, rounding to even");
+static_assert(ReadLiteral(L"9007199254740993.00000000000000000001") == 9007199254740994.0 &&
+    ReadLiteral(L"9007199254740992.99999999999999999999") == 9007199254740992.0,
+    "just above and below halfway, with more than 19 digits");
+static_assert(ReadLiteral(L"1.602176634e-19") == 1.602176634e-19 &&
+    ReadLiteral(L"0.1") == 0.1 && ReadLiteral(L"123456789012345.6") == 123456789012345.6,
+    "common numbers");
@@ -0,0 +1,1591 @@
+//
+// Passes run by MathParser::Compile over the code it has produced,
+// and the fusion of compiled programs by MathParser::CompileFused
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <set>
+#include <tuple>
+#include "mp.hpp"
+
+// Simplify the code of the program being compiled, before the other passes,
+// while each value still has its own memory index. A command leaving its
+// operand unchanged (x * 1, x / 1, x ^ 1, x - 0) is dropped, and its result is
+// replaced by the operand; division by a power of 2 becomes multiplication by
+// its reciprocal, which is exact. x ^ 2 and x ^ -1 become x * x and 1 / x,
+// as MathLexeme::mypow computes them. With fast math, see SetFastMath.
+// The commands whose results are no longer used are removed in the end.
+//
+void MathParser::Simplify()
+{
+    auto& Program{ *pCompiledProgram };
+    auto& code{ Program.code };
+    const auto iVars{ Program.variables.size() };
+    constexpr auto none{ static_cast<size_t>(-1) };
+
+    // the memory index holding the value of each memory index,
+    // and the command computing it
+
+    vector<uint32_t> alias(iMemoryCounter);
+    vector<size_t> definition(iMemoryCounter, none);
+
+    for (size_t it = 0; it < iMemoryCounter; ++it)
+        alias[it] = static_cast<uint32_t>(it);
+
+    auto Definition = [&](uint32_t iIndex) -> const CompiledCommand*
+    {
+        return definition[iIndex] == none ? nullptr : &code[definition[iIndex]];
+    };
+
+    // When checking for floating point errors, the values computed by the code
+    // are finite, but the user variables are not checked: x * 1 is then kept
+    // if x is a user variable, since it is where an infinite x is caught,
+    // unless x is declared finite by SetVarRange
+
+    auto CanDrop = [&](uint32_t iOperand)
+    {
+#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+        return iOperand >= iVars || var_ranges[Program.variables[iOperand]].IsFinite();
+#else //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+        (void)iOperand;
+        (void)iVars;
+        return true;
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+    };
+
+    // Fast math: ln(exp(x)) = x, and exp(ln(x)) = x for x > 0. The latter is
+    // not done when checking for floating point errors, since ln(x) is where
+    // x <= 0 is caught.
+
+    auto Cancels = [](uint32_t iOuter, uint32_t iInner)
+    {
+        if (iOuter == MathLexeme::Ln) return iInner == MathLexeme::Exp;
+
+#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+        return false;
+#else //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+        return iOuter == MathLexeme::Exp && iInner == MathLexeme::Ln;
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+    };
+
+    auto IsZero = [](double dValue, bool fNegative)
+    {
+        return dValue == 0 && std::signbit(dValue) == fNegative;
+    };
+
+    // Fast math: value = iSign * operand + dAddend for +/- with a constant,
+    // value = dFactor * operand ^ iExponent for * and / with a constant
+
+    struct Linear {
+        bool        fAdditive;
+        int         iSign;      // or exponent
+        double      dConstant;  // addend or factor
+        uint32_t    iOperand;
+    };
+
+    auto AsLinear = [&](const CompiledCommand& Cmd, Linear& Form)
+    {
+        const auto& constants{ Program.constants };
+
+        switch (Cmd.iOpCode)
+        {
+        case CompiledCommand::PlusMemConst:
+            Form = { true, 1, constants[Cmd.iSecondOperand], Cmd.iFirstOperand };
+            return true;
+
+        case CompiledCommand::MinusMemConst:
+            Form = { true, 1, -constants[Cmd.iSecondOperand], Cmd.iFirstOperand };
+            return true;
+
+        case CompiledCommand::MinusConstMem:
+            Form = { true, -1, constants[Cmd.iFirstOperand], Cmd.iSecondOperand };
+            return true;
+
+        case CompiledCommand::MultiplyMemConst:
+            Form = { false, 1, constants[Cmd.iSecondOperand], Cmd.iFirstOperand };
+            return true;
+
+        case CompiledCommand::DivideMemConst:
+            Form = { false, 1, 1 / constants[Cmd.iSecondOperand], Cmd.iFirstOperand };
+            return isfinite(Form.dConstant) && Form.dConstant != 0;
+
+        case CompiledCommand::DivideConstMem:
+            Form = { false, -1, constants[Cmd.iFirstOperand], Cmd.iSecondOperand };
+            return true;
+
+        default:
+            return false;
+        }
+    };
+
+    for (size_t it = 0; it < code.size(); ++it)
+    {
+        auto& Cmd{ code[it] };
+
+        if (Cmd.IsFirstOperandMem()) Cmd.iFirstOperand = alias[Cmd.iFirstOperand];
+        if (Cmd.IsSecondOperandMem()) Cmd.iSecondOperand = alias[Cmd.iSecondOperand];
+
+        if (!Cmd.HasResult()) break;
+
+        // c + x and c * x as x + c and x * c
+
+        if (Cmd.iOpCode == CompiledCommand::PlusConstMem ||
+            Cmd.iOpCode == CompiledCommand::MultiplyConstMem)
+        {
+            Cmd.iOpCode -= CompiledCommand::PlusConstMem - CompiledCommand::PlusMemConst;
+            std::swap(Cmd.iFirstOperand, Cmd.iSecondOperand);
+        }
+
+        definition[Cmd.iResult] = it;
+
+        Linear Outer{}, Inner{};
+
+        if (fast_math && AsLinear(Cmd, Outer) && Outer.iOperand >= iVars &&
+            Definition(Outer.iOperand) && AsLinear(*Definition(Outer.iOperand), Inner) &&
+            Outer.fAdditive == Inner.fAdditive)
+        {
+            // (x + c1) + c2 = x + (c1 + c2), (c1 - x) + c2 = (c1 + c2) - x etc.
+            // (x * c1) * c2 = x * (c1 * c2), c2 / (c1 / x) = x * (c2 / c1) etc.
+
+            const auto dConstant{ Outer.fAdditive ?
+                Outer.iSign * Inner.dConstant + Outer.dConstant :
+                (Outer.iSign > 0 ? Outer.dConstant * Inner.dConstant : Outer.dConstant / Inner.dConstant) };
+            const auto iSign{ Outer.iSign * Inner.iSign };
+
+            if (isfinite(dConstant) && (Outer.fAdditive || dConstant != 0))
+            {
+                const auto iConstant{ EmitConstant(dConstant) };
+
+                if (iSign > 0)
+                    Cmd = CompiledCommand(Outer.fAdditive ?
+                        CompiledCommand::PlusMemConst : CompiledCommand::MultiplyMemConst,
+                        Cmd.iResult, Inner.iOperand, iConstant);
+                else
+                    Cmd = CompiledCommand(Outer.fAdditive ?
+                        CompiledCommand::MinusConstMem : CompiledCommand::DivideConstMem,
+                        Cmd.iResult, iConstant, Inner.iOperand);
+            }
+        }
+
+        if (fast_math && Cmd.iSecondOperand >= iVars && Cmd.IsSecondOperandMem() &&
+            (Cmd.iOpCode == CompiledCommand::PlusMemMem || Cmd.iOpCode == CompiledCommand::MinusMemMem))
+        {
+            // x + (0 - y) = x - y, x - (0 - y) = x + y
+
+            const auto pNegation{ Definition(Cmd.iSecondOperand) };
+
+            if (pNegation && pNegation->iOpCode == CompiledCommand::MinusConstMem &&
+                Program.constants[pNegation->iFirstOperand] == 0)
+            {
+                Cmd.iOpCode = Cmd.iOpCode == CompiledCommand::PlusMemMem ?
+                    CompiledCommand::MinusMemMem : CompiledCommand::PlusMemMem;
+                Cmd.iSecondOperand = pNegation->iSecondOperand;
+            }
+        }
+
+        if (fast_math && Cmd.iOpCode == CompiledCommand::CallFunction &&
+            Cmd.iFirstOperand >= iVars)
+        {
+            const auto pInner{ Definition(Cmd.iFirstOperand) };
+
+            if (pInner && pInner->iOpCode == CompiledCommand::CallFunction &&
+                Cancels(Cmd.iSecondOperand, pInner->iSecondOperand))
+            {
+                const auto iOperand{ pInner->iFirstOperand };
+
+                // x + (-0) is x, and is where an infinite user variable is caught
+
+                if (CanDrop(iOperand))
+                    alias[Cmd.iResult] = iOperand;
+                else
+                    Cmd = CompiledCommand(CompiledCommand::PlusMemConst,
+                        Cmd.iResult, iOperand, EmitConstant(-0.0));
+                continue;
+            }
+        }
+
+        if (Cmd.iOpCode < CompiledCommand::PlusMemConst ||
+            Cmd.iOpCode > CompiledCommand::PowerMemConst) continue;
+
+        const auto dConstant{ Program.constants[Cmd.iSecondOperand] };
+        bool fIdentity{ false };
+
+        switch (Cmd.iOpCode)
+        {
+        case CompiledCommand::PlusMemConst:
+            fIdentity = IsZero(dConstant, true) || (fast_math && dConstant == 0);
+            break;
+
+        case CompiledCommand::MinusMemConst:
+            fIdentity = IsZero(dConstant, false) || (fast_math && dConstant == 0);
+            break;
+
+        case CompiledCommand::PowerMemConst:
+
+            // the powers that MathLexeme::mypow computes without pow; the sqrt
+            // command differs from mypow for -0 and -inf, and myintpow from
+            // pow in the last bits, so these two are for fast math
+
+            if (dConstant == 2)
+                Cmd = CompiledCommand(CompiledCommand::MultiplyMemMem,
+                    Cmd.iResult, Cmd.iFirstOperand, Cmd.iFirstOperand);
+            else if (dConstant == -1)
+                Cmd = CompiledCommand(CompiledCommand::DivideConstMem,
+                    Cmd.iResult, EmitConstant(1.0), Cmd.iFirstOperand);
+            else if (fast_math && dConstant == 0.5)
+                Cmd = CompiledCommand(CompiledCommand::SqrtMem,
+                    Cmd.iResult, Cmd.iFirstOperand, MathLexeme::Sqrt);
+            else if (fast_math && dConstant >= 3 && dConstant <= MathLexeme::MathLexMaxIntegerPower &&
+                dConstant == static_cast<unsigned>(dConstant))
+                Cmd = CompiledCommand(CompiledCommand::PowerMemInt,
+                    Cmd.iResult, Cmd.iFirstOperand, static_cast<unsigned>(dConstant));
+            else
+                fIdentity = dConstant == 1;
+            break;
+
+        case CompiledCommand::DivideMemConst:
+        {
+            int iExponent{};
+            const auto dReciprocal{ 1 / dConstant };
+
+            if (dConstant != 1 && isnormal(dReciprocal) &&
+                (fast_math || fabs(frexp(dConstant, &iExponent)) == 0.5))
+            {
+                Cmd.iOpCode = CompiledCommand::MultiplyMemConst;
+                Cmd.iSecondOperand = static_cast<uint32_t>(EmitConstant(dReciprocal));
+                break;
+            }
+        }
+        [[fallthrough]];
+
+        default:
+        // case CompiledCommand::MultiplyMemConst:
+            fIdentity = dConstant == 1;
+        }
+
+        if (fIdentity && CanDrop(Cmd.iFirstOperand))
+            alias[Cmd.iResult] = Cmd.iFirstOperand;
+    }
+
+    RemoveUnusedCommands();
+}
+
+// Remove the commands whose results are not used from the program being compiled
+//
+void MathParser::RemoveUnusedCommands()
+{
+    auto& Program{ *pCompiledProgram };
+    auto& code{ Program.code };
+
+    vector<bool> used(iMemoryCounter, false);
+    vector<bool> keep(code.size(), false);
+
+    for (auto it = code.size(); it-- > 0;)
+    {
+        const auto& Cmd{ code[it] };
+
+        if (Cmd.HasResult() && !used[Cmd.iResult]) continue;
+
+        keep[it] = true;
+
+        if (Cmd.IsFirstOperandMem()) used[Cmd.iFirstOperand] = true;
+        if (Cmd.IsSecondOperandMem()) used[Cmd.iSecondOperand] = true;
+    }
+
+    size_t iKept{ 0 };
+
+    for (size_t it = 0; it < code.size(); ++it)
+        if (keep[it])
+        {
+            code[iKept] = code[it];
+            Program.error_positions[iKept] = Program.error_positions[it];
+            ++iKept;
+        }
+
+    code.resize(iKept);
+    Program.error_positions.resize(iKept);
+}
+
+// Fast math, after EliminateCommonSubexpressions: find the values that are
+// polynomials of degree 2 or more in one memory value x (a user variable or
+// a computed value), written as sums of terms c * x ^ k. Each of them is
+// computed by one PolynomialMem command by Horner's scheme, if it was made of
+// more commands than its degree: a0 + a1 * x + ... + a9 * x ^ 9 takes one
+// command doing 9 multiplications and 9 additions, instead of 26 commands.
+// A value is replaced only where it is used by something else than a larger
+// polynomial in the same x.
+//
+// Only like terms are summed; a product or a power of a sum, such as
+// (x + 1) ^ 9, is not expanded, since its expanded coefficients cancel each
+// other near its roots and the result could lose all its digits. Likewise
+// a sum is only scaled by a power of 2, which is exact.
+//
+void MathParser::SelectPolynomials()
+{
+    if (!fast_math) return;
+
+    auto& Program{ *pCompiledProgram };
+    auto& code{ Program.code };
+    const auto& constants{ Program.constants };
+    constexpr auto none{ static_cast<uint32_t>(-1) };
+    constexpr size_t max_degree{ 16 };
+
+    // the value of a memory index as a polynomial in mem[iVariable], with
+    // the coefficients from x ^ 0 up, computed by iCommands commands
+
+    struct Polynomial {
+        uint32_t        iVariable{ none };
+        vector<double>  coefficients{};
+        size_t          iCommands{ 0 };
+    };
+
+    vector<Polynomial> forms(iMemoryCounter);
+
+    // a value that is not a polynomial is the variable of one: 0 + 1 * x
+
+    auto Form = [&](uint32_t iIndex)
+    {
+        return forms[iIndex].iVariable != none ? forms[iIndex] : Polynomial{ iIndex, { 0, 1 }, 0 };
+    };
+
+    auto Sum = [](const Polynomial& P, const Polynomial& Q, double dSign)
+    {
+        auto Result{ P };
+
+        if (Result.coefficients.size() < Q.coefficients.size())
+            Result.coefficients.resize(Q.coefficients.size(), 0);
+
+        for (size_t it = 0; it < Q.coefficients.size(); ++it)
+            Result.coefficients[it] += dSign * Q.coefficients[it];
+
+        Result.iCommands += Q.iCommands + 1;
+        return Result;
+    };
+
+    auto IsTerm = [](const Polynomial& P)
+    {
+        size_t iTerms{ 0 };
+        for (const auto dCoefficient : P.coefficients) iTerms += dCoefficient != 0;
+
+        return iTerms <= 1;
+    };
+
+    auto IsExactFactor = [](double dFactor)
+    {
+        int iExponent{};
+        return std::fabs(std::frexp(dFactor, &iExponent)) == 0.5;
+    };
+
+    auto Product = [](const Polynomial& P, const Polynomial& Q)
+    {
+        Polynomial Result{ P.iVariable,
+            vector<double>(P.coefficients.size() + Q.coefficients.size() - 1, 0),
+            P.iCommands + Q.iCommands + 1 };
+
+        for (size_t iP = 0; iP < P.coefficients.size(); ++iP)
+            for (size_t iQ = 0; iQ < Q.coefficients.size(); ++iQ)
+                Result.coefficients[iP + iQ] += P.coefficients[iP] * Q.coefficients[iQ];
+
+        return Result;
+    };
+
+    auto Scale = [&](Polynomial P, double dFactor)
+    {
+        if (!IsTerm(P) && !IsExactFactor(dFactor)) return Polynomial{};
+
+        for (auto& dCoefficient : P.coefficients) dCoefficient *= dFactor;
+
+        ++P.iCommands;
+        return P;
+    };
+
+    auto Shift = [&](Polynomial P, double dAddend)
+    {
+        if (P.iVariable == none) return P;
+
+        P.coefficients[0] += dAddend;
+
+        ++P.iCommands;
+        return P;
+    };
+
+    auto Power = [&](const Polynomial& P, size_t iPower)
+    {
+        auto Result{ P };
+
+        if (!IsTerm(P) || (P.coefficients.size() - 1) * iPower > max_degree) return Polynomial{};
+
+        for (size_t it = 1; it < iPower; ++it) Result = Product(Result, P);
+
+        Result.iCommands = P.iCommands + 1;
+        return Result;
+    };
+
+    for (const auto& Cmd : code)
+    {
+        if (!Cmd.HasResult()) break;
+
+        Polynomial Result{};
+
+        switch (Cmd.iOpCode)
+        {
+        case CompiledCommand::PlusMemMem:
+        case CompiledCommand::MinusMemMem:
+        case CompiledCommand::MultiplyMemMem:
+        {
+            const auto P{ Form(Cmd.iFirstOperand) }, Q{ Form(Cmd.iSecondOperand) };
+
+            if (P.iVariable != Q.iVariable) break;
+
+            if (Cmd.iOpCode == CompiledCommand::MultiplyMemMem)
+            {
+                if (IsTerm(P) && IsTerm(Q) &&
+                    P.coefficients.size() + Q.coefficients.size() - 2 <= max_degree)
+                    Result = Product(P, Q);
+            }
+            else
+                Result = Sum(P, Q, Cmd.iOpCode == CompiledCommand::PlusMemMem ? 1 : -1);
+            break;
+        }
+
+        case CompiledCommand::PlusMemConst:
+            Result = Shift(Form(Cmd.iFirstOperand), constants[Cmd.iSecondOperand]);
+            break;
+
+        case CompiledCommand::MinusMemConst:
+            Result = Shift(Form(Cmd.iFirstOperand), -constants[Cmd.iSecondOperand]);
+            break;
+
+        case CompiledCommand::MinusConstMem:
+            Result = Shift(Scale(Form(Cmd.iSecondOperand), -1), constants[Cmd.iFirstOperand]);
+            if (Result.iVariable != none) --Result.iCommands;
+            break;
+
+        case CompiledCommand::MultiplyMemConst:
+            Result = Scale(Form(Cmd.iFirstOperand), constants[Cmd.iSecondOperand]);
+            break;
+
+        case CompiledCommand::DivideMemConst:
+            Result = Scale(Form(Cmd.iFirstOperand), 1 / constants[Cmd.iSecondOperand]);
+            break;
+
+        case CompiledCommand::PowerMemInt:
+            Result = Power(Form(Cmd.iFirstOperand), Cmd.iSecondOperand);
+            break;
+
+        case CompiledCommand::PowerMemConst:
+        {
+            const auto dPower{ constants[Cmd.iSecondOperand] };
+
+            if (dPower >= 2 && dPower <= max_degree && dPower == static_cast<size_t>(dPower))
+                Result = Power(Form(Cmd.iFirstOperand), static_cast<size_t>(dPower));
+            break;
+        }
+        }
+
+        auto& coefficients{ Result.coefficients };
+
+        if (Result.iVariable == none) continue;
+
+        bool fFinite{ true };
+        for (const auto dCoefficient : coefficients) fFinite = fFinite && isfinite(dCoefficient);
+        if (!fFinite) continue;
+
+        while (coefficients.size() > 1 && coefficients.back() == 0) coefficients.pop_back();
+
+        forms[Cmd.iResult] = std::move(Result);
+    }
+
+    // the values used by a command that does not make them part of a larger
+    // polynomial in the same variable, or by the End command
+
+    vector<bool> root(iMemoryCounter, false);
+
+    for (const auto& Cmd : code)
+    {
+        const auto iVariable{ Cmd.HasResult() ? forms[Cmd.iResult].iVariable : none };
+
+        auto Use = [&](uint32_t iIndex)
+        {
+            if (iVariable == none || Form(iIndex).iVariable != iVariable) root[iIndex] = true;
+        };
+
+        if (Cmd.IsFirstOperandMem()) Use(Cmd.iFirstOperand);
+        if (Cmd.IsSecondOperandMem()) Use(Cmd.iSecondOperand);
+    }
+
+    bool fChanged{ false };
+
+    for (auto& Cmd : code)
+    {
+        if (!Cmd.HasResult()) break;
+
+        const auto& Form{ forms[Cmd.iResult] };
+        const auto iDegree{ Form.coefficients.size() - 1 };
+
+        if (!root[Cmd.iResult] || Form.iVariable == none ||
+            iDegree < 2 || Form.iCommands <= iDegree) continue;
+
+        const auto iTable{ EmitConstant(static_cast<double>(iDegree)) };
+
+        for (auto it = Form.coefficients.crbegin(); it != Form.coefficients.crend(); ++it)
+            EmitConstant(*it);
+
+        Cmd = CompiledCommand(CompiledCommand::PolynomialMem, Cmd.iResult, Form.iVariable, iTable);
+        fChanged = true;
+    }
+
+    if (fChanged) RemoveUnusedCommands();
+}
+
+// Fast math, after EliminateCommonSubexpressions: where sin(x) or cos(x) is
+// computed, tan(x) becomes sin(x) / cos(x), so that the three share the call
+// made by a function pair (see SelectFunctionPairs), and likewise tanh(x) where
+// sinh(x) or cosh(x) is. The sine and the cosine computed again for the tangent
+// are merged with the existing ones by numbering the values once more.
+//
+void MathParser::ExpandTangents()
+{
+    if (!fast_math) return;
+
+    auto& Program{ *pCompiledProgram };
+    constexpr auto none{ static_cast<uint32_t>(-1) };
+
+    // the sine of the family of a function, the cosine being the next index
+
+    auto Sine = [](uint32_t iFunction)
+    {
+        switch (iFunction)
+        {
+        case MathLexeme::Sin:
+        case MathLexeme::Cos:
+        case MathLexeme::Tan:
+            return static_cast<uint32_t>(MathLexeme::Sin);
+
+        case MathLexeme::Sinh:
+        case MathLexeme::Cosh:
+        case MathLexeme::Tanh:
+            return static_cast<uint32_t>(MathLexeme::Sinh);
+
+        default:
+            return none;
+        }
+    };
+
+    auto IsTangent = [](const CompiledCommand& Cmd)
+    {
+        return Cmd.iSecondOperand == MathLexeme::Tan || Cmd.iSecondOperand == MathLexeme::Tanh;
+    };
+
+    // the operands of the sines and cosines, with their family
+
+    std::set<std::pair<uint32_t, uint32_t>> computed{};
+
+    for (const auto& Cmd : Program.code)
+        if (Cmd.iOpCode == CompiledCommand::CallFunction && !IsTangent(Cmd) &&
+            Sine(Cmd.iSecondOperand) != none)
+            computed.emplace(Sine(Cmd.iSecondOperand), Cmd.iFirstOperand);
+
+    if (computed.empty()) return;
+
+    vector<CompiledCommand> source{};
+    vector<size_t> error_positions{};
+
+    source.swap(Program.code);
+    error_positions.swap(Program.error_positions);
+
+    bool fChanged{ false };
+
+    for (size_t it = 0; it < source.size(); ++it)
+    {
+        const auto& Cmd{ source[it] };
+        const auto iSine{ Cmd.iOpCode == CompiledCommand::CallFunction && IsTangent(Cmd) ?
+            Sine(Cmd.iSecondOperand) : none };
+
+        if (iSine == none || computed.count(std::make_pair(iSine, Cmd.iFirstOperand)) == 0)
+        {
+            EmitCommand(Cmd.iOpCode, Cmd.iResult, Cmd.iFirstOperand, Cmd.iSecondOperand,
+                error_positions[it]);
+            continue;
+        }
+
+        const auto iSineResult{ iMemoryCounter++ }, iCosineResult{ iMemoryCounter++ };
+
+        EmitCommand(CompiledCommand::CallFunction, iSineResult, Cmd.iFirstOperand, iSine,
+            error_positions[it]);
+        EmitCommand(CompiledCommand::CallFunction, iCosineResult, Cmd.iFirstOperand, iSine + 1,
+            error_positions[it]);
+        EmitCommand(CompiledCommand::DivideMemMem, Cmd.iResult, iSineResult, iCosineResult,
+            error_positions[it]);
+        fChanged = true;
+    }
+
+    if (fChanged) EliminateCommonSubexpressions();
+}
+
+// Compute sin(x) and cos(x) by one call, before SelectSuperinstructions: the
+// later of the two commands is moved up next to the earlier one, the sine first,
+// which becomes a SinCosMem command. Its operand is computed before both, and
+// its result is used after both. Both fail exactly when x is not finite, so the
+// pair keeps the error position (and the string of a fused program) of the
+// earlier command, which reports the error first. With fast math, sinh(x) and
+// cosh(x) are paired the same way into SinhCoshMem.
+//
+void MathParser::SelectFunctionPairs(vector<size_t>* pErrorStrings)
+{
+    auto& Program{ *pCompiledProgram };
+    const auto& code{ Program.code };
+    constexpr auto none{ static_cast<size_t>(-1) };
+
+    // the opcode of the pair computing a function, or Error
+
+    auto Pairing = [&](const CompiledCommand& Cmd)
+    {
+        if (Cmd.iOpCode == CompiledCommand::CallFunction)
+            switch (Cmd.iSecondOperand)
+            {
+            case MathLexeme::Sin:
+            case MathLexeme::Cos:
+                return CompiledCommand::SinCosMem;
+
+            case MathLexeme::Sinh:
+            case MathLexeme::Cosh:
+                if (fast_math) return CompiledCommand::SinhCoshMem;
+                break;
+            }
+
+        return CompiledCommand::Error;
+    };
+
+    auto IsSine = [](const CompiledCommand& Cmd)
+    {
+        return Cmd.iSecondOperand == MathLexeme::Sin || Cmd.iSecondOperand == MathLexeme::Sinh;
+    };
+
+    // the later command paired with each command, from the earlier one waiting
+    // for its partner for each pair and operand
+
+    vector<size_t> partner(code.size(), none);
+    vector<bool> moved(code.size(), false);
+    std::map<std::pair<uint16_t, uint32_t>, size_t> waiting{};
+    bool fPaired{ false };
+
+    for (size_t it = 0; it < code.size(); ++it)
+    {
+        const auto iPairing{ Pairing(code[it]) };
+
+        if (iPairing == CompiledCommand::Error) continue;
+
+        const auto Key{ std::make_pair(static_cast<uint16_t>(iPairing), code[it].iFirstOperand) };
+        const auto Found{ waiting.find(Key) };
+
+        if (Found == waiting.end())
+            waiting.emplace(Key, it);
+        else if (IsSine(code[Found->second]) != IsSine(code[it]))
+        {
+            partner[Found->second] = it;
+            moved[it] = true;
+            waiting.erase(Found);
+            fPaired = true;
+        }
+    }
+
+    if (!fPaired) return;
+
+    vector<CompiledCommand> source{};
+    vector<size_t> error_positions{}, error_strings{};
+
+    source.swap(Program.code);
+    error_positions.swap(Program.error_positions);
+    if (pErrorStrings) error_strings.swap(*pErrorStrings);
+
+    auto Append = [&](const CompiledCommand& Cmd, size_t iSource)
+    {
+        Program.code.push_back(Cmd);
+        Program.error_positions.push_back(error_positions[iSource]);
+        if (pErrorStrings) pErrorStrings->push_back(error_strings[iSource]);
+    };
+
+    for (size_t it = 0; it < source.size(); ++it)
+    {
+        if (moved[it]) continue;
+
+        if (partner[it] == none)
+        {
+            Append(source[it], it);
+            continue;
+        }
+
+        auto First{ source[it] }, Second{ source[partner[it]] };
+        auto iSecondSource{ partner[it] };
+
+        if (!IsSine(First))
+        {
+            std::swap(First, Second);
+            iSecondSource = it;
+        }
+
+        First.iOpCode = Pairing(First);
+
+        Append(First, it);
+        Append(Second, iSecondSource);
+    }
+}
+
+// Turn pairs of commands into superinstructions, before AllocateMemory: a
+// multiplication followed by an addition of its result (a * b + c, a * k + c,
+// a * b + k, a * k1 + k2) and an addition followed by a multiplication of its
+// result by a constant ((a + b) * k, (a + k1) * k2). The result of the first
+// command should not be used anywhere else, including the outputs of a fused
+// program, since it is not stored. x - k is taken as x + (-k), which is exact.
+// With fast math, the multiply-adds are rounded once.
+//
+void MathParser::SelectSuperinstructions(const vector<CompiledCommand>* pOutputs)
+{
+    auto& Program{ *pCompiledProgram };
+    auto& code{ Program.code };
+
+    // the number of uses of each memory index
+
+    vector<size_t> uses(iMemoryCounter, 0);
+
+    for (const auto& Cmd : code)
+    {
+        if (Cmd.IsFirstOperandMem()) ++uses[Cmd.iFirstOperand];
+        if (Cmd.IsSecondOperandMem()) ++uses[Cmd.iSecondOperand];
+    }
+
+    if (pOutputs)
+        for (const auto& Output : *pOutputs)
+            if (Output.IsFirstOperandMem()) ++uses[Output.iFirstOperand];
+
+    auto Negate = [&](CompiledCommand& Cmd)
+    {
+        Cmd.iOpCode = CompiledCommand::PlusMemConst;
+        Cmd.iSecondOperand = static_cast<uint32_t>(EmitConstant(-Program.constants[Cmd.iSecondOperand]));
+    };
+
+    for (size_t it = 0; it + 1 < code.size(); ++it)
+    {
+        auto& First{ code[it] };
+        auto& Second{ code[it + 1] };
+
+        if (!First.HasResult() || uses[First.iResult] != 1 || !Second.HasResult()) continue;
+
+        // the result of First as the first operand of Second
+
+        if (Second.iOpCode == CompiledCommand::PlusMemMem && Second.iSecondOperand == First.iResult)
+            std::swap(Second.iFirstOperand, Second.iSecondOperand);
+
+        if (!Second.IsFirstOperandMem() || Second.iFirstOperand != First.iResult) continue;
+
+        uint16_t iFused{ CompiledCommand::Error };
+
+        switch (First.iOpCode)
+        {
+        case CompiledCommand::MultiplyMemMem:
+        case CompiledCommand::MultiplyMemConst:
+            if (Second.iOpCode == CompiledCommand::MinusMemConst) Negate(Second);
+
+            if (Second.iOpCode == CompiledCommand::PlusMemMem ||
+                Second.iOpCode == CompiledCommand::PlusMemConst)
+            {
+                iFused = fast_math ?
+                    CompiledCommand::FusedMultiplyAddMemMemMem : CompiledCommand::MultiplyAddMemMemMem;
+
+                if (First.iOpCode == CompiledCommand::MultiplyMemConst) iFused += 2;
+                if (Second.iOpCode == CompiledCommand::PlusMemConst) iFused += 1;
+            }
+            break;
+
+        case CompiledCommand::PlusMemMem:
+        case CompiledCommand::PlusMemConst:
+        case CompiledCommand::MinusMemConst:
+            if (Second.iOpCode == CompiledCommand::MultiplyMemConst)
+            {
+                if (First.iOpCode == CompiledCommand::MinusMemConst) Negate(First);
+
+                iFused = First.iOpCode == CompiledCommand::PlusMemMem ?
+                    CompiledCommand::PlusMultiplyMemMemConst : CompiledCommand::PlusMultiplyMemConstConst;
+            }
+            break;
+        }
+
+        if (iFused == CompiledCommand::Error) continue;
+
+        First.iOpCode = iFused;
+        ++it; // Second cannot start another superinstruction
+    }
+}
+
+namespace {
+
+    // Operations on ValueRange for AnalyzeRanges. A bound is computed by the same
+    // operation on the bounds of the operands, then widened a little to cover
+    // the rounding of the library functions, which are not monotonic to the last
+    // bit. A range containing infinities gives infinities or NaN where
+    // the operation does.
+
+    constexpr double range_slack{ 1e-12 };
+
+    const ValueRange unknown_range{ -HUGE_VAL, HUGE_VAL, true };
+
+    ValueRange Widen(ValueRange Range)
+    {
+        if (isfinite(Range.dMin)) Range.dMin -= fabs(Range.dMin) * range_slack;
+        if (isfinite(Range.dMax)) Range.dMax += fabs(Range.dMax) * range_slack;
+        return Range;
+    }
+
+    bool ContainsZero(const ValueRange& Range)
+    {
+        return Range.dMin <= 0 && Range.dMax >= 0;
+    }
+
+    bool ContainsInfinity(const ValueRange& Range)
+    {
+        return Range.dMin == -HUGE_VAL || Range.dMax == HUGE_VAL;
+    }
+
+    // The smallest and the largest of the values, NaN excepted (0 if all are NaN)
+
+    ValueRange Hull(const double* rgdValues, size_t iValues, bool fNaN)
+    {
+        ValueRange Range{ HUGE_VAL, -HUGE_VAL, fNaN };
+
+        for (size_t it = 0; it < iValues; ++it)
+        {
+            if (rgdValues[it] < Range.dMin) Range.dMin = rgdValues[it];
+            if (rgdValues[it] > Range.dMax) Range.dMax = rgdValues[it];
+        }
+
+        if (Range.dMin > Range.dMax) Range.dMin = Range.dMax = 0;
+
+        return Widen(Range);
+    }
+
+    // |x| for x in Range: from the smallest to the largest absolute value
+
+    ValueRange Magnitude(const ValueRange& Range)
+    {
+        const auto dMin{ ContainsZero(Range) ? 0 : fmin(fabs(Range.dMin), fabs(Range.dMax)) };
+        return ValueRange{ dMin, fmax(fabs(Range.dMin), fabs(Range.dMax)), Range.fNaN };
+    }
+
+    ValueRange Sum(const ValueRange& x, const ValueRange& y)
+    {
+        // inf + (-inf) is NaN
+
+        const auto fNaN{ x.fNaN || y.fNaN ||
+            (x.dMax == HUGE_VAL && y.dMin == -HUGE_VAL) || (x.dMin == -HUGE_VAL && y.dMax == HUGE_VAL) };
+
+        const double rgdBounds[]{ x.dMin + y.dMin, x.dMax + y.dMax };
+        auto Range{ Hull(rgdBounds, 2, fNaN) };
+
+        if (isnan(rgdBounds[0])) Range.dMin = -HUGE_VAL;
+        if (isnan(rgdBounds[1])) Range.dMax = HUGE_VAL;
+
+        return Range;
+    }
+
+    ValueRange Negation(const ValueRange& x)
+    {
+        return ValueRange{ -x.dMax, -x.dMin, x.fNaN };
+    }
+
+    ValueRange Product(const ValueRange& x, const ValueRange& y, bool fSquare)
+    {
+        if (fSquare)
+        {
+            const auto Abs{ Magnitude(x) };
+            const double rgdBounds[]{ Abs.dMin * Abs.dMin, Abs.dMax * Abs.dMax };
+            return Hull(rgdBounds, 2, x.fNaN);
+        }
+
+        // 0 * inf is NaN
+
+        const auto fNaN{ x.fNaN || y.fNaN ||
+            (ContainsZero(x) && ContainsInfinity(y)) || (ContainsZero(y) && ContainsInfinity(x)) };
+
+        const double rgdBounds[]{
+            x.dMin * y.dMin, x.dMin * y.dMax, x.dMax * y.dMin, x.dMax * y.dMax };
+
+        return Hull(rgdBounds, 4, fNaN);
+    }
+
+    ValueRange Quotient(const ValueRange& x, const ValueRange& y)
+    {
+        if (ContainsZero(y)) return unknown_range;
+
+        // inf / inf is NaN
+
+        const auto fNaN{ x.fNaN || y.fNaN || (ContainsInfinity(x) && ContainsInfinity(y)) };
+
+        const double rgdBounds[]{
+            x.dMin / y.dMin, x.dMin / y.dMax, x.dMax / y.dMin, x.dMax / y.dMax };
+
+        return Hull(rgdBounds, 4, fNaN);
+    }
+
+    ValueRange IntegerPower(const ValueRange& x, unsigned iPower)
+    {
+        const auto Base{ iPower % 2 ? x : Magnitude(x) };
+
+        const double rgdBounds[]{
+            MathLexeme::myintpow(Base.dMin, iPower), MathLexeme::myintpow(Base.dMax, iPower) };
+
+        return Hull(rgdBounds, 2, x.fNaN);
+    }
+
+    // f(x) for f increasing
+
+    ValueRange Increasing(double (*Function)(double), const ValueRange& x, bool fNaN)
+    {
+        const double rgdBounds[]{ Function(x.dMin), Function(x.dMax) };
+        return Hull(rgdBounds, 2, fNaN);
+    }
+}
+
+// Range analysis, before DeferFloatingPointChecks: bound the values of the
+// program being compiled from the constants and the ranges declared for the
+// user variables (see SetVarRange), and mark the commands whose result is always
+// finite as CompiledCommand::Finite. Such a result is not checked for floating
+// point errors. x * x is known to be non-negative, so that e.g. sqrt(x ^ 2 + 1)
+// needs no check if x is finite. For a superinstruction, the second command is
+// marked.
+//
+void MathParser::AnalyzeRanges()
+{
+#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+    auto& Program{ *pCompiledProgram };
+    const auto& constants{ Program.constants };
+
+    vector<ValueRange> ranges(iMemoryCounter, unknown_range);
+
+    for (size_t it = 0; it < Program.variables.size(); ++it)
+        ranges[it] = var_ranges[Program.variables[it]];
+
+    auto Operand = [&](bool fMem, uint32_t iIndex)
+    {
+        if (fMem) return ranges[iIndex];
+
+        const auto dValue{ constants[iIndex] };
+        return ValueRange{ dValue, dValue, isnan(dValue) };
+    };
+
+    auto FunctionRange = [](size_t iFunction, const ValueRange& x)
+    {
+        constexpr double half_pi{ 1.5707963267948966 };
+
+        switch (iFunction)
+        {
+        case MathLexeme::Sqrt:
+            return Increasing(MathLexeme::mysqrt,
+                ValueRange{ fmax(x.dMin, 0), fmax(x.dMax, 0), x.fNaN }, x.fNaN || x.dMin < 0);
+
+        case MathLexeme::Exp:
+            return Increasing(MathLexeme::myexp, x, x.fNaN);
+
+        case MathLexeme::Ln:
+        case MathLexeme::Lg:
+        case MathLexeme::Log:
+            return Increasing(MathLexeme::FunctionAddress[iFunction],
+                ValueRange{ fmax(x.dMin, 0), fmax(x.dMax, 0), x.fNaN }, x.fNaN || x.dMin < 0);
+
+        // NaN for an infinite argument
+
+        case MathLexeme::Sin:
+        case MathLexeme::Cos:
+            return Widen(ValueRange{ -1, 1, x.fNaN || ContainsInfinity(x) });
+
+        // asin or acos of x / sqrt(1 + x * x), which is inf / inf for an infinite x
+
+        case MathLexeme::Arctg:
+        case MathLexeme::Arctan:
+            return Widen(ValueRange{ -half_pi, half_pi, x.fNaN || ContainsInfinity(x) });
+
+        case MathLexeme::Arcctg:
+        case MathLexeme::Arccot:
+            return Widen(ValueRange{ 0, 2 * half_pi, x.fNaN || ContainsInfinity(x) });
+
+        case MathLexeme::Th:
+        case MathLexeme::Tanh:
+            return Widen(ValueRange{ -1, 1, x.fNaN });
+
+        case MathLexeme::Abs:
+            return Widen(Magnitude(x));
+
+        case MathLexeme::Int:
+            return Increasing(MathLexeme::myint, x, x.fNaN);
+
+        default:
+            return unknown_range;
+        }
+    };
+
+    for (auto& Cmd : Program.code)
+    {
+        Cmd.iFlags &= ~CompiledCommand::Finite;
+
+        if (!Cmd.HasResult()) continue;
+
+        const auto iOpCode{ Cmd.FirstOperation() };
+        auto Range{ unknown_range };
+
+        if (Cmd.IsFunction())
+            Range = FunctionRange(Cmd.iSecondOperand, ranges[Cmd.iFirstOperand]);
+        else if (iOpCode == CompiledCommand::PowerMemInt)
+            Range = IntegerPower(ranges[Cmd.iFirstOperand], Cmd.iSecondOperand);
+        else if (iOpCode < CompiledCommand::CallFunction)
+        {
+            const CompiledCommand Operation{ iOpCode, Cmd.iResult, Cmd.iFirstOperand, Cmd.iSecondOperand };
+            const auto x{ Operand(Operation.IsFirstOperandMem(), Cmd.iFirstOperand) };
+            const auto y{ Operand(Operation.IsSecondOperandMem(), Cmd.iSecondOperand) };
+
+            switch (iOpCode % 5) // MathLexeme::MathLexBiItem
+            {
+            case MathLexeme::Plus:
+                Range = Sum(x, y);
+                break;
+
+            case MathLexeme::Minus:
+                Range = Sum(x, Negation(y));
+                break;
+
+            case MathLexeme::Multiply:
+                Range = Product(x, y, iOpCode == CompiledCommand::MultiplyMemMem &&
+                    Cmd.iFirstOperand == Cmd.iSecondOperand);
+                break;
+
+            case MathLexeme::Divide:
+                Range = Quotient(x, y);
+                break;
+
+            default:
+            // case MathLexeme::Power:
+                break;
+            }
+        }
+
+        ranges[Cmd.iResult] = Range;
+
+        if (Range.IsFinite() && !Cmd.IsFused()) Cmd.iFlags |= CompiledCommand::Finite;
+    }
+
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+}
+
+// With deferred checks for floating point errors, before AllocateMemory: check
+// only the values through which an error could vanish. The result of + - * and
+// of sqrt, abs, int and ln is not finite if an operand is not, so an error in the operand
+// shows in the result. A value is checked by a CheckMem command following
+// the one computing it if it is a divisor, an operand of ^, the argument of
+// another function, an output, or if it is not used at all.
+//
+void MathParser::DeferFloatingPointChecks(
+    const vector<CompiledCommand>* pOutputs, vector<size_t>* pErrorStrings)
+{
+#ifdef MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+
+    auto& Program{ *pCompiledProgram };
+
+    vector<bool> check(iMemoryCounter, false), used(iMemoryCounter, false);
+
+    for (const auto& Cmd : Program.code)
+    {
+        if (Cmd.IsFirstOperandMem()) used[Cmd.iFirstOperand] = true;
+        if (Cmd.IsSecondOperandMem()) used[Cmd.iSecondOperand] = true;
+
+        switch (Cmd.iOpCode)
+        {
+        case CompiledCommand::DivideMemMem:
+        case CompiledCommand::DivideConstMem:
+        case CompiledCommand::PowerConstMem:
+            check[Cmd.iSecondOperand] = true;
+            break;
+
+        case CompiledCommand::PowerMemMem:
+            check[Cmd.iSecondOperand] = true;
+            check[Cmd.iFirstOperand] = true;
+            break;
+
+        case CompiledCommand::PowerMemConst:
+        case CompiledCommand::EndMem:
+            check[Cmd.iFirstOperand] = true;
+            break;
+
+        case CompiledCommand::CallFunction:
+        case CompiledCommand::SinCosMem:
+        case CompiledCommand::SinhCoshMem:
+            if (Cmd.iSecondOperand != MathLexeme::Ln)
+                check[Cmd.iFirstOperand] = true;
+            break;
+        }
+    }
+
+    if (pOutputs)
+        for (const auto& Output : *pOutputs)
+            if (Output.IsFirstOperandMem()) check[Output.iFirstOperand] = true;
+
+    vector<CompiledCommand> source{};
+    vector<size_t> error_positions{}, error_strings{};
+
+    source.swap(Program.code);
+    error_positions.swap(Program.error_positions);
+    if (pErrorStrings) error_strings.swap(*pErrorStrings);
+
+    // a CheckMem command has the error position of the command computing the value
+
+    auto Append = [&](const CompiledCommand& Cmd, size_t iSource)
+    {
+        Program.code.push_back(Cmd);
+        Program.error_positions.push_back(error_positions[iSource]);
+        if (pErrorStrings) pErrorStrings->push_back(error_strings[iSource]);
+    };
+
+    auto Check = [&](size_t iSource)
+    {
+        const auto& Cmd{ source[iSource] };
+
+        if (Cmd.HasResult() && !Cmd.IsFused() && !(Cmd.iFlags & CompiledCommand::Finite) &&
+            (check[Cmd.iResult] || !used[Cmd.iResult]))
+            Append(CompiledCommand{ CompiledCommand::CheckMem, 0, Cmd.iResult, 0 }, iSource);
+    };
+
+    for (size_t it = 0; it < source.size(); ++it)
+    {
+        Append(source[it], it);
+
+        // the commands of a function pair stay together, checked after both
+
+        if (source[it].IsFunctionPair())
+        {
+            Append(source[it + 1], it + 1);
+            Check(it);
+            ++it;
+        }
+
+        Check(it);
+    }
+
+#else //MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+
+    (void)pOutputs;
+    (void)pErrorStrings;
+
+#endif //MATH_PARSER_DEFER_FLOATING_POINT_CHECKS
+}
+
+// The lexer refers to a user variable by its index in user_vars, and gives
+// the intermediate values indices from NumberOfVars() on. Give the variables
+// read by the program being compiled the first memory indices instead, in
+// the order of user_vars, followed by the intermediate values, so that neither
+// the passes nor the runtime memory depend on the number of user variables.
+//
+void MathParser::SelectVariables()
+{
+    auto& Program{ *pCompiledProgram };
+    auto& variables{ Program.variables };
+    const auto iVars{ NumberOfVars() };
+
+    variables.clear();
+
+    for (const auto& Cmd : Program.code)
+    {
+        if (Cmd.IsFirstOperandMem() && Cmd.iFirstOperand < iVars)
+            variables.push_back(Cmd.iFirstOperand);
+
+        if (Cmd.IsSecondOperandMem() && Cmd.iSecondOperand < iVars)
+            variables.push_back(Cmd.iSecondOperand);
+    }
+
+    std::sort(variables.begin(), variables.end());
+    variables.erase(std::unique(variables.begin(), variables.end()), variables.end());
+
+    auto Renumber = [&](uint32_t& iIndex)
+    {
+        iIndex = static_cast<uint32_t>(iIndex < iVars ?
+            std::lower_bound(variables.begin(), variables.end(), iIndex) - variables.begin() :
+            iIndex - iVars + variables.size());
+    };
+
+    for (auto& Cmd : Program.code)
+    {
+        if (Cmd.HasResult()) Renumber(Cmd.iResult);
+        if (Cmd.IsFirstOperandMem()) Renumber(Cmd.iFirstOperand);
+        if (Cmd.IsSecondOperandMem()) Renumber(Cmd.iSecondOperand);
+    }
+
+    iMemoryCounter = iMemoryCounter - iVars + variables.size();
+}
+
+// Compile gives each intermediate value its own runtime memory index.
+// Reassign the indices so that the memory of a value is reused as soon as
+// the value has been used for the last time. The user variables still read
+// keep the first indices, and the ones the passes have left unread are dropped
+// from Program.variables.
+//
+void MathParser::AllocateMemory(vector<CompiledCommand>* pOutputs)
+{
+    auto& code{ pCompiledProgram->code };
+    auto& variables{ pCompiledProgram->variables };
+    const auto iVars{ variables.size() };
+    const auto iTemporaries{ iMemoryCounter - iVars };
+
+    // the variables read, renumbered first: they stay below iVars
+
+    vector<uint32_t> variable_index(iVars, static_cast<uint32_t>(iVars));
+
+    auto ReadVariable = [&](bool fMem, uint32_t iIndex)
+    {
+        if (fMem && iIndex < iVars) variable_index[iIndex] = 0;
+    };
+
+    for (const auto& Cmd : code)
+    {
+        ReadVariable(Cmd.IsFirstOperandMem(), Cmd.iFirstOperand);
+        ReadVariable(Cmd.IsSecondOperandMem(), Cmd.iSecondOperand);
+    }
+
+    if (pOutputs)
+        for (const auto& Output : *pOutputs)
+            ReadVariable(Output.IsFirstOperandMem(), Output.iFirstOperand);
+
+    size_t iRead{ 0 };
+
+    for (size_t it = 0; it < iVars; ++it)
+        if (variable_index[it] == 0)
+        {
+            variable_index[it] = static_cast<uint32_t>(iRead);
+            variables[iRead++] = variables[it];
+        }
+
+    variables.resize(iRead);
+
+    auto RenumberVariable = [&](bool fMem, uint32_t& iIndex)
+    {
+        if (fMem && iIndex < iVars) iIndex = variable_index[iIndex];
+    };
+
+    for (auto& Cmd : code)
+    {
+        RenumberVariable(Cmd.IsFirstOperandMem(), Cmd.iFirstOperand);
+        RenumberVariable(Cmd.IsSecondOperandMem(), Cmd.iSecondOperand);
+    }
+
+    if (pOutputs)
+        for (auto& Output : *pOutputs)
+            RenumberVariable(Output.IsFirstOperandMem(), Output.iFirstOperand);
+
+    // the last command using each intermediate value
+
+    vector<size_t> last_use(iTemporaries, 0);
+
+    for (size_t it = 0; it < code.size(); ++it)
+    {
+        const auto& Cmd{ code[it] };
+
+        if (Cmd.IsFirstOperandMem() && Cmd.iFirstOperand >= iVars)
+            last_use[Cmd.iFirstOperand - iVars] = it;
+
+        if (Cmd.IsSecondOperandMem() && Cmd.iSecondOperand >= iVars)
+            last_use[Cmd.iSecondOperand - iVars] = it;
+    }
+
+    // the outputs of a fused program stay in memory after the end
+
+    if (pOutputs)
+        for (const auto& Output : *pOutputs)
+            if (Output.IsFirstOperandMem() && Output.iFirstOperand >= iVars)
+                last_use[Output.iFirstOperand - iVars] = code.size();
+
+    // assign the indices in the order of the code
+
+    vector<uint32_t> new_index(iTemporaries, 0);
+    vector<uint32_t> free_indices{};
+    auto iNextIndex{ static_cast<uint32_t>(iRead) };
+
+    for (size_t it = 0; it < code.size(); ++it)
+    {
+        auto& Cmd{ code[it] };
+
+        if (Cmd.IsFirstOperandMem() && Cmd.iFirstOperand >= iVars)
+        {
+            const auto iOld{ Cmd.iFirstOperand - iVars };
+            Cmd.iFirstOperand = new_index[iOld];
+
+            if (last_use[iOld] == it) free_indices.push_back(Cmd.iFirstOperand);
+        }
+
+        if (Cmd.IsSecondOperandMem() && Cmd.iSecondOperand >= iVars)
+        {
+            const auto iOld{ Cmd.iSecondOperand - iVars };
+            const auto fSameAsFirst{
+                Cmd.IsFirstOperandMem() && Cmd.iFirstOperand == new_index[iOld] };
+
+            Cmd.iSecondOperand = new_index[iOld];
+
+            if (last_use[iOld] == it && !fSameAsFirst) free_indices.push_back(Cmd.iSecondOperand);
+        }
+
+        if (Cmd.HasResult())
+        {
+            const auto iOld{ Cmd.iResult - iVars };
+
+            if (free_indices.empty())
+                new_index[iOld] = iNextIndex++;
+            else
+            {
+                new_index[iOld] = free_indices.back();
+                free_indices.pop_back();
+            }
+
+            Cmd.iResult = new_index[iOld];
+
+            // a value never used keeps its memory only for this command
+            if (last_use[iOld] < it) free_indices.push_back(Cmd.iResult);
+        }
+    }
+
+    if (pOutputs)
+        for (auto& Output : *pOutputs)
+            if (Output.IsFirstOperandMem() && Output.iFirstOperand >= iVars)
+                Output.iFirstOperand = new_index[Output.iFirstOperand - iVars];
+
+    pCompiledProgram->iMemorySize = iNextIndex;
+}
+
+// The operations done so far by the program being compiled, and its constants
+//
+struct MathParser::ValueTable {
+
+    // (opcode, first operand, second operand) -> memory index of the result
+    std::map<std::tuple<uint16_t, uint32_t, uint32_t>, uint32_t> operations;
+
+    // bit pattern of the value -> index in the constant pool
+    std::map<uint64_t, uint32_t> constants;
+
+    // the table of a PolynomialMem command -> index of its first constant
+    std::map<vector<double>, uint32_t> tables;
+};
+
+// Append the commands of Source, except its End command, to the program being
+// compiled. A command doing the same operation on the same values as one
+// appended before is dropped, and its result replaced by the earlier one.
+// Each new value gets its own memory index from iMemoryCounter, so that
+// AllocateMemory should be called in the end. Returns the End command of Source
+// referring to the memory or the constants of the program being compiled.
+//
+CompiledCommand MathParser::AppendNumbered(const CompiledProgram& Source, ValueTable& Values)
+{
+    const auto& variables{ pCompiledProgram->variables };
+
+    // memory index of Source -> memory index of the program being compiled,
+    // whose variables include those of Source
+
+    vector<uint32_t> value(Source.iMemorySize);
+
+    for (size_t it = 0; it < Source.variables.size(); ++it)
+        value[it] = static_cast<uint32_t>(std::lower_bound(
+            variables.begin(), variables.end(), Source.variables[it]) - variables.begin());
+
+    auto Constant = [&](uint32_t iIndex) -> uint32_t
+    {
+        const auto dValue{ Source.constants[iIndex] };
+        uint64_t iBits{};
+        memcpy(&iBits, &dValue, sizeof(iBits));
+
+        const auto Found{ Values.constants.find(iBits) };
+
+        if (Found != Values.constants.end()) return Found->second;
+
+        const auto iNew{ static_cast<uint32_t>(EmitConstant(dValue)) };
+        Values.constants.emplace(iBits, iNew);
+        return iNew;
+    };
+
+    // the degree and the coefficients of a polynomial, kept together
+
+    auto Table = [&](uint32_t iIndex) -> uint32_t
+    {
+        const auto pTable{ Source.constants.data() + iIndex };
+        vector<double> table(pTable, pTable + static_cast<size_t>(pTable[0]) + 2);
+
+        const auto Found{ Values.tables.find(table) };
+
+        if (Found != Values.tables.end()) return Found->second;
+
+        const auto iNew{ static_cast<uint32_t>(pCompiledProgram->constants.size()) };
+        for (const auto dValue : table) EmitConstant(dValue);
+
+        Values.tables.emplace(std::move(table), iNew);
+        return iNew;
+    };
+
+    for (size_t it = 0; it < Source.code.size(); ++it)
+    {
+        auto Cmd{ Source.code[it] };
+
+        // the program being compiled will select its own superinstructions
+
+        Cmd.iOpCode = Cmd.FirstOperation();
+
+        // and place its own checks
+
+        if (Cmd.iOpCode == CompiledCommand::CheckMem) continue;
+
+        if (Cmd.iOpCode == CompiledCommand::EndMem)
+        {
+            Cmd.iFirstOperand = value[Cmd.iFirstOperand];
+            return Cmd;
+        }
+
+        if (Cmd.iOpCode == CompiledCommand::EndConst)
+        {
+            Cmd.iFirstOperand = Constant(Cmd.iFirstOperand);
+            return Cmd;
+        }
+
+        if (Cmd.IsFirstOperandMem())
+            Cmd.iFirstOperand = value[Cmd.iFirstOperand];
+        else
+            Cmd.iFirstOperand = Constant(Cmd.iFirstOperand);
+
+        if (Cmd.IsSecondOperandMem())
+            Cmd.iSecondOperand = value[Cmd.iSecondOperand];
+        else if (Cmd.iOpCode == CompiledCommand::PolynomialMem)
+            Cmd.iSecondOperand = Table(Cmd.iSecondOperand);
+        else if (!Cmd.IsFunction() && Cmd.iOpCode != CompiledCommand::PowerMemInt)
+            Cmd.iSecondOperand = Constant(Cmd.iSecondOperand);
+
+        // x + y and y + x, x * y and y * x are the same operation
+
+        switch (Cmd.iOpCode)
+        {
+        case CompiledCommand::PlusConstMem:
+        case CompiledCommand::MultiplyConstMem:
+            Cmd.iOpCode += CompiledCommand::PlusMemConst - CompiledCommand::PlusConstMem;
+            std::swap(Cmd.iFirstOperand, Cmd.iSecondOperand);
+            break;
+
+        case CompiledCommand::PlusMemMem:
+        case CompiledCommand::MultiplyMemMem:
+            if (Cmd.iFirstOperand > Cmd.iSecondOperand)
+                std::swap(Cmd.iFirstOperand, Cmd.iSecondOperand);
+            break;
+        }
+
+        const auto Key{ std::make_tuple(Cmd.iOpCode, Cmd.iFirstOperand, Cmd.iSecondOperand) };
+        const auto Found{ Values.operations.find(Key) };
+
+        if (Found != Values.operations.end())
+        {
+            value[Cmd.iResult] = Found->second;
+            continue;
+        }
+
+        const auto iNew{ static_cast<uint32_t>(iMemoryCounter++) };
+
+        value[Cmd.iResult] = iNew;
+        Values.operations.emplace(Key, iNew);
+
+        EmitCommand(Cmd.iOpCode, iNew, Cmd.iFirstOperand, Cmd.iSecondOperand,
+            Source.error_positions[it]);
+    }
+
+    return CompiledCommand{}; // never happens: the code ends with EndMem/EndConst
+}
+
+// Compile gives each operation its own command, so that e.g.
+// sin(ln(x1 + x2))^2 + cos(ln(x1 + x2))^2 computes ln(x1 + x2) twice.
+// Number the values of the program being compiled, before AllocateMemory,
+// keeping only the first command of each repeated operation.
+//
+void MathParser::EliminateCommonSubexpressions()
+{
+    auto& Program{ *pCompiledProgram };
+
+    CompiledProgram Source{};
+    Source.code.swap(Program.code);
+    Source.constants.swap(Program.constants);
+    Source.error_positions.swap(Program.error_positions);
+    Source.variables = Program.variables;
+    Source.iMemorySize = iMemoryCounter;
+
+    Program.code.reserve(Source.code.size());
+    Program.error_positions.reserve(Source.code.size());
+
+    iMemoryCounter = Program.variables.size();
+
+    ValueTable Values{};
+    const auto End{ AppendNumbered(Source, Values) };
+
+    EmitCommand(End.iOpCode, 0, End.iFirstOperand, 0, Source.error_positions.back());
+}
+
+MathParser::ErrorCodes MathParser::CompileFused(
+    size_t& iErrorPosition, size_t& iErrorString, const vector<size_t>& indices,
+    size_t& iFusedIndex)
+{
+    for (size_t iString = 0; iString < indices.size(); ++iString)
+    {
+        const auto err_code{ Compile(iErrorPosition, indices[iString]) };
+
+        if (err_code != OK)
+        {
+            iErrorString = iString;
+            return err_code;
+        }
+    }
+
+    // Append the programs one after another, numbering the values so that
+    // an operation already done by one of the previous programs is reused
+
+    FusedProgram Fused{};
+    ValueTable Values{};
+
+    // the variables read by any of the programs
+
+    auto& variables{ Fused.program.variables };
+
+    for (const auto iIndex : indices)
+        variables.insert(variables.end(),
+            compiled_code[iIndex].variables.begin(), compiled_code[iIndex].variables.end());
+
+    std::sort(variables.begin(), variables.end());
+    variables.erase(std::unique(variables.begin(), variables.end()), variables.end());
+
+    pCompiledProgram = &Fused.program;
+    pCompiledProgram->fFastMath = fast_math;
+    iMemoryCounter = variables.size();
+
+    for (size_t iString = 0; iString < indices.size(); ++iString)
+    {
+        Fused.outputs.push_back(AppendNumbered(compiled_code[indices[iString]], Values));
+        Fused.error_strings.resize(Fused.program.code.size(), iString);
+    }
+
+    if (Fused.outputs.empty())
+        Fused.outputs.emplace_back(CompiledCommand::EndConst, 0, EmitConstant(0.0), 0);
+
+    // the program ends with the last output, all of them being kept in memory
+
+    EmitCommand(Fused.outputs.back().iOpCode, 0, Fused.outputs.back().iFirstOperand, 0, 0);
+    Fused.error_strings.push_back(indices.empty() ? 0 : indices.size() - 1);
+
+    SelectFunctionPairs(&Fused.error_strings);
+    SelectSuperinstructions(&Fused.outputs);
+    AnalyzeRanges();
+    DeferFloatingPointChecks(&Fused.outputs, &Fused.error_strings);
+    AllocateMemory(&Fused.outputs);
+
+    iFusedIndex = fused_code.size();
+    fused_code.push_back(std::move(Fused));
+
+    return OK;
+}
+
@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <limits>
+#include "mp.hpp"
+#include "mp_pool.hpp"
+
+WorkStealingPool::WorkStealingPool(size_t iThreads) :
+    threads{}, queues{ new TaskQueue[iThreads + 1] }
+{
+    threads.reserve(iThreads);
+
+    for (size_t it = 0; it < iThreads; ++it)
+        threads.emplace_back(&WorkStealingPool::WorkerLoop, this, it + 1);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> Lock{ wake_lock };
+        fStop = true;
+    }
+    wake.notify_all();
+
+    for (auto& Thread : threads) Thread.join();
+}
+
+WorkStealingPool& WorkStealingPool::Shared()
+{
+    static WorkStealingPool Pool{ std::max<size_t>(std::thread::hardware_concurrency(), 1) - 1 };
+    return Pool;
+}
+
+void WorkStealingPool::RunErased(
+    size_t iTasks, size_t iWorkers, TaskThunk pNewThunk, const void* pNewTask)
+{
+    if (iTasks == 0) return;
+
+    std::lock_guard<std::mutex> RunLock{ run_lock };
+
+    if (iWorkers == 0 || iWorkers > NumberOfWorkers()) iWorkers = NumberOfWorkers();
+    if (iWorkers > iTasks) iWorkers = iTasks;
+
+    // no need to wake anybody up
+
+    if (iWorkers == 1)
+    {
+        for (size_t iTask = 0; iTask < iTasks; ++iTask) pNewThunk(pNewTask, iTask);
+        return;
+    }
+
+    pThunk = pNewThunk;
+    pTask = pNewTask;
+    iActiveWorkers = iWorkers;
+    iPendingTasks = iTasks;
+
+    for (size_t iWorker = 0; iWorker < iWorkers; ++iWorker)
+    {
+        auto& Queue{ queues[iWorker] };
+        std::lock_guard<std::mutex> Lock{ Queue.lock };
+
+        for (auto iTask = iTasks * iWorker / iWorkers;
+            iTask < iTasks * (iWorker + 1) / iWorkers; ++iTask)
+            Queue.tasks.push_back(iTask);
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock{ wake_lock };
+        ++iGeneration;
+    }
+    wake.notify_all();
+
+    while (RunOne(0));
+
+    std::unique_lock<std::mutex> Lock{ wake_lock };
+    done.wait(Lock, [this] { return iPendingTasks == 0; });
+
+    iActiveWorkers = 0;
+}
+
+// Run a task from the worker's own queue, or else steal one from another
+// worker. Returns false if there are no tasks left to take.
+//
+bool WorkStealingPool::RunOne(size_t iWorker)
+{
+    const auto iWorkers{ iActiveWorkers.load() };
+
+    if (iWorker >= iWorkers) return false;
+
+    size_t iTask{};
+    auto fFound{ false };
+
+    {
+        auto& Queue{ queues[iWorker] };
+        std::lock_guard<std::mutex> Lock{ Queue.lock };
+
+        if (!Queue.tasks.empty())
+        {
+            iTask = Queue.tasks.front();
+            Queue.tasks.pop_front();
+            fFound = true;
+        }
+    }
+
+    for (size_t it = 1; !fFound && it < iWorkers; ++it)
+    {
+        auto& Queue{ queues[(iWorker + it) % iWorkers] };
+        std::lock_guard<std::mutex> Lock{ Queue.lock };
+
+        if (!Queue.tasks.empty())
+        {
+            iTask = Queue.tasks.back();
+            Queue.tasks.pop_back();
+            fFound = true;
+        }
+    }
+
+    if (!fFound) return false;
+
+    pThunk(pTask, iTask);
+
+    if (--iPendingTasks == 0)
+    {
+        std::lock_guard<std::mutex> Lock{ wake_lock };
+        done.notify_all();
+    }
+
+    return true;
+}
+
+void WorkStealingPool::WorkerLoop(size_t iWorker)
+{
+    size_t iSeenGeneration{ 0 };
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> Lock{ wake_lock };
+            wake.wait(Lock, [&] { return fStop || iGeneration != iSeenGeneration; });
+
+            if (fStop) return;
+
+            iSeenGeneration = iGeneration;
+        }
+
+        while (RunOne(iWorker));
+    }
+}
+
+namespace {
+
+    // Scratch memory of each thread running chunks for ExecuteBatchJobs
+
+    thread_local ExecutionContext WorkerContext;
+}
+
+void MathParser::ExecuteBatchJobs(vector<BatchJob>& jobs, size_t iThreads) const
+{
+    // Split each job into chunks: enough of them to keep all the workers busy
+    // when they do not run equally fast, but not so short that the overhead
+    // of a task shows. A chunk is a multiple of 64 rows, so that two chunks
+    // do not write to the same cache line of the results.
+
+    constexpr size_t min_chunk_rows{ 2048 }, chunks_per_worker{ 8 }, row_granularity{ 64 };
+
+    auto& Pool{ WorkStealingPool::Shared() };
+    const auto iWorkers{ iThreads == 0 || iThreads > Pool.NumberOfWorkers() ?
+        Pool.NumberOfWorkers() : iThreads };
+
+    vector<size_t> chunk_rows(jobs.size()), first_chunk(jobs.size() + 1);
+
+    for (size_t iJob = 0; iJob < jobs.size(); ++iJob)
+    {
+        const auto iRows{ jobs[iJob].iRows };
+        auto iChunkRows{ (iRows + iWorkers * chunks_per_worker - 1) / (iWorkers * chunks_per_worker) };
+
+        if (iChunkRows < min_chunk_rows) iChunkRows = min_chunk_rows;
+        iChunkRows += row_granularity - 1;
+        iChunkRows -= iChunkRows % row_granularity;
+
+        chunk_rows[iJob] = iChunkRows;
+        first_chunk[iJob + 1] = first_chunk[iJob] + (iRows + iChunkRows - 1) / iChunkRows;
+
+        jobs[iJob].iErrorCode = OK;
+    }
+
+    // A failed chunk cancels the chunks following it in the same job:
+    // the first failed one is what ExecuteBatch would report
+
+    struct ChunkResult {
+        ErrorCodes  iErrorCode;
+        size_t      iErrorPosition;
+        size_t      iErrorRow;
+    };
+
+    const auto iChunks{ first_chunk.back() };
+    vector<ChunkResult> results(iChunks, ChunkResult{ OK, 0, 0 });
+    std::unique_ptr<std::atomic<size_t>[]> first_failed{ new std::atomic<size_t>[jobs.size()] };
+
+    for (size_t iJob = 0; iJob < jobs.size(); ++iJob)
+        first_failed[iJob] = std::numeric_limits<size_t>::max();
+
+    auto RunChunk = [&](size_t iChunk)
+    {
+        const auto iJob{ static_cast<size_t>(
+            std::upper_bound(first_chunk.begin(), first_chunk.end(), iChunk) - first_chunk.begin() - 1) };
+
+        if (first_failed[iJob] < iChunk) return;
+
+        const auto& Job{ jobs[iJob] };
+        const auto iFirstRow{ (iChunk - first_chunk[iJob]) * chunk_rows[iJob] };
+        const auto iRows{ std::min(chunk_rows[iJob], Job.iRows - iFirstRow) };
+
+        vector<const double*> args(Job.args);
+        for (auto& pColumn : args) pColumn += iFirstRow;
+
+        auto& Result{ results[iChunk] };
+
+        Result.iErrorCode = ExecuteBatch(WorkerContext,
+            Result.iErrorPosition, Result.iErrorRow, args,
+            Job.rgdValues + iFirstRow, iRows, Job.iIndex);
+
+        if (Result.iErrorCode != OK)
+        {
+            Result.iErrorRow += iFirstRow;
+
+            auto iFailed{ first_failed[iJob].load() };
+            while (iChunk < iFailed && !first_failed[iJob].compare_exchange_weak(iFailed, iChunk));
+        }
+    };
+
+    Pool.Run(iChunks, iWorkers, RunChunk);
+
+    for (size_t iJob = 0; iJob < jobs.size(); ++iJob)
+    {
+        const auto iFailed{ first_failed[iJob].load() };
+
+        if (iFailed == std::numeric_limits<size_t>::max()) continue;
+
+        auto& Job{ jobs[iJob] };
+        const auto& Result{ results[iFailed] };
+
+        Job.iErrorCode = Result.iErrorCode;
+        Job.iErrorPosition = Result.iErrorPosition;
+        Job.iErrorRow = Result.iErrorRow;
+    }
+}
+
+MathParser::ErrorCodes MathParser::ExecuteBatchParallel(
+    size_t& iErrorPosition, size_t& iErrorRow, const vector<const double*>& args,
+    double* rgdValues, size_t iRows, size_t iIndex, size_t iThreads) const
+{
+    vector<BatchJob> jobs(1);
+
+    jobs[0].iIndex = iIndex;
+    jobs[0].args = args;
+    jobs[0].rgdValues = rgdValues;
+    jobs[0].iRows = iRows;
+
+    ExecuteBatchJobs(jobs, iThreads);
+
+    iErrorPosition = jobs[0].iErrorPosition;
+    iErrorRow = jobs[0].iErrorRow;
+
+    return jobs[0].iErrorCode;
+}
+
+size_t MathParser::MaxThreads()
+{
+    return WorkStealingPool::Shared().NumberOfWorkers();
+}
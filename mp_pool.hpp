@@ -0,0 +1,89 @@
+//
+// Work-stealing thread pool used by MathParser::ExecuteBatchJobs
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+
+    friend class MathParser;
+
+    // Runs Task(iTask) for iTask in [0, iTasks) on the first iWorkers workers,
+    // worker 0 being the calling thread, and returns when all tasks are done.
+    // Each worker starts with a contiguous range of tasks in its own queue,
+    // taken from the front; an idle worker steals from the back of the queues
+    // of the others. Task must not throw. One Run at a time: concurrent calls
+    // wait for each other, and a task must not call Run.
+    //
+    template<typename TaskFunction>
+    void Run(size_t iTasks, size_t iWorkers, const TaskFunction& Task);
+
+    // The number of workers including the calling thread
+    //
+    size_t NumberOfWorkers() const;
+
+    // The pool shared by all MathParser objects, with a worker per hardware thread.
+    // The threads are created at the first call.
+    //
+    static WorkStealingPool& Shared();
+
+    explicit WorkStealingPool(size_t iThreads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator = (const WorkStealingPool&) = delete;
+
+    using TaskThunk = void (*)(const void*, size_t);
+
+    struct TaskQueue {
+        std::mutex          lock;
+        std::deque<size_t>  tasks;
+    };
+
+    void RunErased(size_t iTasks, size_t iWorkers, TaskThunk pThunk, const void* pTask);
+    bool RunOne(size_t iWorker);
+    void WorkerLoop(size_t iWorker);
+
+    std::vector<std::thread>        threads;
+    std::unique_ptr<TaskQueue[]>    queues;     // one per worker
+
+    std::mutex                      run_lock;   // serializes Run
+    std::mutex                      wake_lock;
+    std::condition_variable         wake;       // a new Run, or the destructor
+    std::condition_variable         done;       // the last task is done
+
+    // the current Run; pThunk/pTask are written before the tasks are queued
+    // and read after a task is dequeued, so the queue locks order them
+
+    TaskThunk                       pThunk{ nullptr };
+    const void*                     pTask{ nullptr };
+    std::atomic<size_t>             iActiveWorkers{ 0 };
+    std::atomic<size_t>             iPendingTasks{ 0 };
+    size_t                          iGeneration{ 0 };
+    bool                            fStop{ false };
+};
+
+template<typename TaskFunction>
+void WorkStealingPool::Run(size_t iTasks, size_t iWorkers, const TaskFunction& Task)
+{
+    auto Thunk = [](const void* pFunction, size_t iTask)
+    {
+        (*static_cast<const TaskFunction*>(pFunction))(iTask);
+    };
+
+    RunErased(iTasks, iWorkers, Thunk, &Task);
+}
+
+inline size_t WorkStealingPool::NumberOfWorkers() const
+{
+    return threads.size() + 1;
+}
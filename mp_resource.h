@@ -1,68 +1,68 @@
-//{{NO_DEPENDENCIES}}
-// Microsoft Visual C++ generated include file.
-// Used by mp_eng(16LE).rc
-//
-#define IDD_DIALOG_MAIN                 102
-#define IDD_DIALOG_OPTIONS              104
-#define IDD_DIALOG_NEWEDIT              105
-#define IDS_OK                          110
-#define IDS_InvalidNumber               111
-#define IDS_UnknownIdentifier           112
-#define IDS_InvalidCharacter            113
-#define IDS_EmptyString                 114
-#define IDS_ExpectedRealFunUnSignLeftPar 115
-#define IDS_ExpectedRealFunLeftPar      116
-#define IDS_ExpectedBiSignRightPar      117
-#define IDS_ExpectedBiSign              118
-#define IDS_ExpectedLeftPar             119
-#define IDS_ExpectedRightPar            120
-#define IDS_ExtraRightPar               121
-#define IDS_COPY                        122
-#define IDS_ID_IN_USE                   123
-#define IDS_CAPTION_ADD                 124
-#define IDS_CAPTION_EDIT                125
-#define IDS_FloatingPointErrorPosInf    126
-#define IDS_FloatingPointErrorNegInf    127
-#define IDS_FloatingPointErrorNaN       128
-#define IDS_ATPOS                       129
-#define IDS_CVAL                        130
-#define IDS_FE_COMMCTL                  131
-#define IDS_FATALERROR_CAP              132
-#define IDS_ID_2LONG                    133
-#define IDS_NUM_2LONG                   134
-#define IDS_ENT_VALID_NUM               210
-#define IDS_ENT_VALID_ID                211
-#define IDS_MB_SERROR                   212
-#define IDS_VAR                         213
-#define IDS_VAL                         214
-#define IDS_RESULT                      215
-#define IDPARSE                         1000
-#define IDEVALUATE                      1001
-#define IDC_EDIT_MAIN                   1003
-#define IDC_ENTER                       1004
-#define IDC_RESULT                      1005
-#define IDCOMPILE                       1006
-#define IDEXECUTE                       1007
-#define IDADD                           1015
-#define IDREMOVE                        1016
-#define IDC_LIST_VARS                   1017
-#define IDC_EDIT_VAR                    1018
-#define IDC_EDIT_EXPR                   1019
-#define IDC_IDENTIFIER                  1020
-#define IDC_VALUE                       1021
-#define IDC_SYSLINK_VARS                1022
-#define IDC_CHECK_CASE                  1023
-#define IDEDIT                          1024
-#define IDC_SYSLINK_RNDSTR              1025
-#define IDC_STATIC_DEBUG                -1
-
-// Next default values for new objects
-// 
-#ifdef APSTUDIO_INVOKED
-#ifndef APSTUDIO_READONLY_SYMBOLS
-#define _APS_NEXT_RESOURCE_VALUE        101
-#define _APS_NEXT_COMMAND_VALUE         40001
-#define _APS_NEXT_CONTROL_VALUE         1000
-#define _APS_NEXT_SYMED_VALUE           101
-#endif
-#endif
+//{{NO_DEPENDENCIES}}
+// Microsoft Visual C++ generated include file.
+// Used by mp_eng(16LE).rc
+//
+#define IDD_DIALOG_MAIN                 102
+#define IDD_DIALOG_OPTIONS              104
+#define IDD_DIALOG_NEWEDIT              105
+#define IDS_OK                          110
+#define IDS_InvalidNumber               111
+#define IDS_UnknownIdentifier           112
+#define IDS_InvalidCharacter            113
+#define IDS_EmptyString                 114
+#define IDS_ExpectedRealFunUnSignLeftPar 115
+#define IDS_ExpectedRealFunLeftPar      116
+#define IDS_ExpectedBiSignRightPar      117
+#define IDS_ExpectedBiSign              118
+#define IDS_ExpectedLeftPar             119
+#define IDS_ExpectedRightPar            120
+#define IDS_ExtraRightPar               121
+#define IDS_COPY                        122
+#define IDS_ID_IN_USE                   123
+#define IDS_CAPTION_ADD                 124
+#define IDS_CAPTION_EDIT                125
+#define IDS_FloatingPointErrorPosInf    126
+#define IDS_FloatingPointErrorNegInf    127
+#define IDS_FloatingPointErrorNaN       128
+#define IDS_ATPOS                       129
+#define IDS_CVAL                        130
+#define IDS_FE_COMMCTL                  131
+#define IDS_FATALERROR_CAP              132
+#define IDS_ID_2LONG                    133
+#define IDS_NUM_2LONG                   134
+#define IDS_ENT_VALID_NUM               210
+#define IDS_ENT_VALID_ID                211
+#define IDS_MB_SERROR                   212
+#define IDS_VAR                         213
+#define IDS_VAL                         214
+#define IDS_RESULT                      215
+#define IDPARSE                         1000
+#define IDEVALUATE                      1001
+#define IDC_EDIT_MAIN                   1003
+#define IDC_ENTER                       1004
+#define IDC_RESULT                      1005
+#define IDCOMPILE                       1006
+#define IDEXECUTE                       1007
+#define IDADD                           1015
+#define IDREMOVE                        1016
+#define IDC_LIST_VARS                   1017
+#define IDC_EDIT_VAR                    1018
+#define IDC_EDIT_EXPR                   1019
+#define IDC_IDENTIFIER                  1020
+#define IDC_VALUE                       1021
+#define IDC_SYSLINK_VARS                1022
+#define IDC_CHECK_CASE                  1023
+#define IDEDIT                          1024
+#define IDC_SYSLINK_RNDSTR              1025
+#define IDC_STATIC_DEBUG                -1
+
+// Next default values for new objects
+// 
+#ifdef APSTUDIO_INVOKED
+#ifndef APSTUDIO_READONLY_SYMBOLS
+#define _APS_NEXT_RESOURCE_VALUE        101
+#define _APS_NEXT_COMMAND_VALUE         40001
+#define _APS_NEXT_CONTROL_VALUE         1000
+#define _APS_NEXT_SYMED_VALUE           101
+#endif
+#endif
@@ -0,0 +1,306 @@
+#include <cmath>
+#include <cstring>
+#include "mp_mystack.hpp"
+#include "mp_simd.hpp"
+
+#ifdef MATH_KERNELS_X86
+
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else //_MSC_VER
+#include <cpuid.h>
+#endif //_MSC_VER
+
+#endif //MATH_KERNELS_X86
+
+// x * y + z must be rounded twice, like in the interpreter, unless a kernel
+// asks for Vec::Fma. GCC contracts it to one instruction where FMA is enabled.
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif //__GNUC__
+
+// Wrappers of the intrinsics for each instruction set.
+// MSVC accepts the intrinsics of any instruction set in any function; GCC and
+// Clang need them enabled for the functions that use them.
+// And, Or, Xor, the shifts and SubBits work on the bits of the doubles, as
+// 64-bit integers; AllLess(x, y) is true if x < y in every lane.
+
+namespace mp_scalar {
+
+    struct Vec {
+        using V = double;
+        static constexpr size_t Width{ 1 };
+        static V Load(const double* p) { return *p; }
+        static void Store(double* p, V x) { *p = x; }
+        static V Set(double x) { return x; }
+        static V Add(V x, V y) { return x + y; }
+        static V Sub(V x, V y) { return x - y; }
+        static V Mul(V x, V y) { return x * y; }
+        static V Div(V x, V y) { return x / y; }
+        static V Fma(V x, V y, V z) { return fma(x, y, z); }
+        static V Sqrt(V x) { return sqrt(x); }
+        static V Abs(V x) { return fabs(x); }
+        static V Floor(V x) { return floor(x); }
+        static double Sum(V x) { return x; }
+        static bool AllLess(V x, V y) { return x < y; }
+        static V SetBits(uint64_t i) { return FromBits(i); }
+        static V And(V x, V y) { return FromBits(Bits(x) & Bits(y)); }
+        static V Or(V x, V y) { return FromBits(Bits(x) | Bits(y)); }
+        static V Xor(V x, V y) { return FromBits(Bits(x) ^ Bits(y)); }
+        static V ShiftLeft(V x, int iBits) { return FromBits(Bits(x) << iBits); }
+        static V ShiftRight(V x, int iBits) { return FromBits(Bits(x) >> iBits); }
+        static V SubBits(V x, V y) { return FromBits(Bits(x) - Bits(y)); }
+
+        static uint64_t Bits(V x)
+        {
+            uint64_t i;
+            std::memcpy(&i, &x, sizeof(i));
+            return i;
+        }
+
+        static V FromBits(uint64_t i)
+        {
+            V x;
+            std::memcpy(&x, &i, sizeof(x));
+            return x;
+        }
+    };
+}
+
+#define MATH_KERNELS_NAMESPACE mp_scalar
+#define MATH_KERNELS_TABLE ScalarKernels
+#define MATH_KERNELS_NAME "Scalar"
+#include "mp_simd_kernels.inl"
+
+#ifdef MATH_KERNELS_X86
+
+#ifdef __GNUC__
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif //__GNUC__
+
+namespace mp_sse2 {
+
+    struct Vec {
+        using V = __m128d;
+        static constexpr size_t Width{ 2 };
+        static V Load(const double* p) { return _mm_loadu_pd(p); }
+        static void Store(double* p, V x) { _mm_storeu_pd(p, x); }
+        static V Set(double x) { return _mm_set1_pd(x); }
+        static V Add(V x, V y) { return _mm_add_pd(x, y); }
+        static V Sub(V x, V y) { return _mm_sub_pd(x, y); }
+        static V Mul(V x, V y) { return _mm_mul_pd(x, y); }
+        static V Div(V x, V y) { return _mm_div_pd(x, y); }
+        static V Fma(V x, V y, V z) // no FMA instructions before AVX2
+        {
+            const auto High = [](V v) { return _mm_cvtsd_f64(_mm_unpackhi_pd(v, v)); };
+            return _mm_set_pd(fma(High(x), High(y), High(z)),
+                fma(_mm_cvtsd_f64(x), _mm_cvtsd_f64(y), _mm_cvtsd_f64(z)));
+        }
+        static V Sqrt(V x) { return _mm_sqrt_pd(x); }
+        static V Abs(V x) { return _mm_andnot_pd(_mm_set1_pd(-0.0), x); }
+        static V Floor(V x) // no rounding instructions before SSE4.1
+        {
+            return _mm_set_pd(floor(_mm_cvtsd_f64(_mm_unpackhi_pd(x, x))), floor(_mm_cvtsd_f64(x)));
+        }
+        static double Sum(V x) { return _mm_cvtsd_f64(_mm_add_sd(x, _mm_unpackhi_pd(x, x))); }
+        static bool AllLess(V x, V y) { return _mm_movemask_pd(_mm_cmplt_pd(x, y)) == 0x3; }
+        static V SetBits(uint64_t i) { return _mm_castsi128_pd(_mm_set1_epi64x(static_cast<long long>(i))); }
+        static V And(V x, V y) { return _mm_and_pd(x, y); }
+        static V Or(V x, V y) { return _mm_or_pd(x, y); }
+        static V Xor(V x, V y) { return _mm_xor_pd(x, y); }
+        static V ShiftLeft(V x, int iBits) { return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(x), iBits)); }
+        static V ShiftRight(V x, int iBits) { return _mm_castsi128_pd(_mm_srli_epi64(_mm_castpd_si128(x), iBits)); }
+        static V SubBits(V x, V y)
+        {
+            return _mm_castsi128_pd(_mm_sub_epi64(_mm_castpd_si128(x), _mm_castpd_si128(y)));
+        }
+    };
+}
+
+#define MATH_KERNELS_NAMESPACE mp_sse2
+#define MATH_KERNELS_TABLE SSE2Kernels
+#define MATH_KERNELS_NAME "SSE2"
+#include "mp_simd_kernels.inl"
+
+#ifdef __GNUC__
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif //__GNUC__
+
+namespace mp_avx2 {
+
+    struct Vec {
+        using V = __m256d;
+        static constexpr size_t Width{ 4 };
+        static V Load(const double* p) { return _mm256_loadu_pd(p); }
+        static void Store(double* p, V x) { _mm256_storeu_pd(p, x); }
+        static V Set(double x) { return _mm256_set1_pd(x); }
+        static V Add(V x, V y) { return _mm256_add_pd(x, y); }
+        static V Sub(V x, V y) { return _mm256_sub_pd(x, y); }
+        static V Mul(V x, V y) { return _mm256_mul_pd(x, y); }
+        static V Div(V x, V y) { return _mm256_div_pd(x, y); }
+        static V Fma(V x, V y, V z) { return _mm256_fmadd_pd(x, y, z); }
+        static V Sqrt(V x) { return _mm256_sqrt_pd(x); }
+        static V Abs(V x) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x); }
+        static V Floor(V x) { return _mm256_floor_pd(x); }
+        static double Sum(V x)
+        {
+            const auto y{ _mm_add_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1)) };
+            return _mm_cvtsd_f64(_mm_add_sd(y, _mm_unpackhi_pd(y, y)));
+        }
+        static bool AllLess(V x, V y) { return _mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_LT_OQ)) == 0xF; }
+        static V SetBits(uint64_t i) { return _mm256_castsi256_pd(_mm256_set1_epi64x(static_cast<long long>(i))); }
+        static V And(V x, V y) { return _mm256_and_pd(x, y); }
+        static V Or(V x, V y) { return _mm256_or_pd(x, y); }
+        static V Xor(V x, V y) { return _mm256_xor_pd(x, y); }
+        static V ShiftLeft(V x, int iBits)
+        {
+            return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(x), iBits));
+        }
+        static V ShiftRight(V x, int iBits)
+        {
+            return _mm256_castsi256_pd(_mm256_srli_epi64(_mm256_castpd_si256(x), iBits));
+        }
+        static V SubBits(V x, V y)
+        {
+            return _mm256_castsi256_pd(_mm256_sub_epi64(_mm256_castpd_si256(x), _mm256_castpd_si256(y)));
+        }
+    };
+}
+
+#define MATH_KERNELS_NAMESPACE mp_avx2
+#define MATH_KERNELS_TABLE AVX2Kernels
+#define MATH_KERNELS_NAME "AVX2"
+#include "mp_simd_kernels.inl"
+
+#ifdef __GNUC__
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif //__GNUC__
+
+namespace mp_avx512 {
+
+    struct Vec {
+        using V = __m512d;
+        static constexpr size_t Width{ 8 };
+        static V Load(const double* p) { return _mm512_loadu_pd(p); }
+        static void Store(double* p, V x) { _mm512_storeu_pd(p, x); }
+        static V Set(double x) { return _mm512_set1_pd(x); }
+        static V Add(V x, V y) { return _mm512_add_pd(x, y); }
+        static V Sub(V x, V y) { return _mm512_sub_pd(x, y); }
+        static V Mul(V x, V y) { return _mm512_mul_pd(x, y); }
+        static V Div(V x, V y) { return _mm512_div_pd(x, y); }
+        static V Fma(V x, V y, V z) { return _mm512_fmadd_pd(x, y, z); }
+        static V Sqrt(V x) { return _mm512_sqrt_pd(x); }
+        static V Abs(V x) { return _mm512_abs_pd(x); }
+        static V Floor(V x) { return _mm512_roundscale_pd(x, _MM_FROUND_TO_NEG_INF); }
+        static double Sum(V x) { return _mm512_reduce_add_pd(x); }
+        static bool AllLess(V x, V y) { return _mm512_cmp_pd_mask(x, y, _CMP_LT_OQ) == 0xFF; }
+        static V SetBits(uint64_t i) { return _mm512_castsi512_pd(_mm512_set1_epi64(static_cast<long long>(i))); }
+
+        // the bitwise operations on doubles need AVX512DQ, those on integers do not
+
+        static V And(V x, V y)
+        {
+            return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(x), _mm512_castpd_si512(y)));
+        }
+        static V Or(V x, V y)
+        {
+            return _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(x), _mm512_castpd_si512(y)));
+        }
+        static V Xor(V x, V y)
+        {
+            return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(x), _mm512_castpd_si512(y)));
+        }
+        static V ShiftLeft(V x, int iBits)
+        {
+            return _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_castpd_si512(x), static_cast<unsigned>(iBits)));
+        }
+        static V ShiftRight(V x, int iBits)
+        {
+            return _mm512_castsi512_pd(_mm512_srli_epi64(_mm512_castpd_si512(x), static_cast<unsigned>(iBits)));
+        }
+        static V SubBits(V x, V y)
+        {
+            return _mm512_castsi512_pd(_mm512_sub_epi64(_mm512_castpd_si512(x), _mm512_castpd_si512(y)));
+        }
+    };
+}
+
+#define MATH_KERNELS_NAMESPACE mp_avx512
+#define MATH_KERNELS_TABLE AVX512Kernels
+#define MATH_KERNELS_NAME "AVX-512"
+#include "mp_simd_kernels.inl"
+
+#ifdef __GNUC__
+#pragma GCC pop_options
+#endif //__GNUC__
+
+#endif //MATH_KERNELS_X86
+
+// Pick the widest instruction set supported by both the CPU and the OS
+// (the OS should save the wider registers on context switches)
+//
+const MathKernels::KernelTable& MathKernels::Select()
+{
+#ifdef MATH_KERNELS_X86
+
+    unsigned int rgiRegs[4]{}; // eax, ebx, ecx, edx
+
+    auto CpuId = [&rgiRegs](unsigned int iLeaf)
+    {
+#ifdef _MSC_VER
+        __cpuidex(reinterpret_cast<int*>(rgiRegs), iLeaf, 0);
+#else //_MSC_VER
+        if (!__get_cpuid_count(iLeaf, 0, &rgiRegs[0], &rgiRegs[1], &rgiRegs[2], &rgiRegs[3]))
+            rgiRegs[0] = rgiRegs[1] = rgiRegs[2] = rgiRegs[3] = 0;
+#endif //_MSC_VER
+    };
+
+    CpuId(0);
+    const auto iMaxLeaf{ rgiRegs[0] };
+
+    CpuId(1);
+    const bool fSSE2{ (rgiRegs[3] & (1u << 26)) != 0 };
+    const bool fOSXSAVE{ (rgiRegs[2] & (1u << 27)) != 0 };
+    const bool fFMA{ (rgiRegs[2] & (1u << 12)) != 0 };
+    const bool fAVX{ (rgiRegs[2] & (1u << 28)) != 0 };
+
+    if (!fSSE2) return ScalarKernels;
+
+    if (!fOSXSAVE || !fAVX || iMaxLeaf < 7) return SSE2Kernels;
+
+#ifdef _MSC_VER
+    const auto iXCR0{ _xgetbv(0) };
+#else //_MSC_VER
+    unsigned int iXCR0Low{}, iXCR0High{};
+    __asm__ ("xgetbv" : "=a" (iXCR0Low), "=d" (iXCR0High) : "c" (0));
+    const auto iXCR0{ (static_cast<unsigned long long>(iXCR0High) << 32) | iXCR0Low };
+#endif //_MSC_VER
+
+    // XMM and YMM state; opmask and the upper halves of ZMM0-15, ZMM16-31
+
+    const bool fAVXState{ (iXCR0 & 0x06) == 0x06 };
+    const bool fAVX512State{ (iXCR0 & 0xE6) == 0xE6 };
+
+    CpuId(7);
+    const bool fAVX2{ (rgiRegs[1] & (1u << 5)) != 0 };
+    const bool fAVX512F{ (rgiRegs[1] & (1u << 16)) != 0 };
+
+    if (fAVX512F && fAVX512State) return AVX512Kernels;
+    if (fAVX2 && fFMA && fAVXState) return AVX2Kernels;
+
+    return SSE2Kernels;
+
+#else //MATH_KERNELS_X86
+
+    return ScalarKernels;
+
+#endif //MATH_KERNELS_X86
+}
@@ -0,0 +1,95 @@
+//
+// Vectorized kernels used by MathParser::ExecuteBatch
+//
+
+#pragma once
+
+#include <stddef.h>
+
+class MathKernels {
+
+    friend class MathParser;
+    friend class MathLexeme;
+
+    // Each kernel applies one operation to iRows elements:
+    //
+    // mem+mem:     pResult[n] = pOp1[n] <op> pOp2[n]
+    // mem+const:   pResult[n] = pOp1[n] <op> dOp2
+    // const+mem:   pResult[n] = dOp1 <op> pOp2[n]
+    //
+    // function:    pResult[n] = f(pOp1[n])
+    // int power:   pResult[n] = pOp1[n] ^ iPower, as MathLexeme::myintpow
+    // polynomial:  pResult[n] = the polynomial pTable of pOp1[n], as MathLexeme::mypolynomial
+    //
+    // fused:       pResult[n] = (pOp1[n] <op> op2) <op'> op3, op2 and op3 being
+    //              pOp2[n] or *pOp2, pOp3[n] or *pOp3 as the superinstruction says
+    // pair:        pResult[n] = f(pOp[n]), pResult2[n] = g(pOp[n])
+    //
+    // pResult may be the same array as an operand.
+
+    using MemMemKernel = void (*)(double*, const double*, const double*, size_t);
+    using MemConstKernel = void (*)(double*, const double*, double, size_t);
+    using ConstMemKernel = void (*)(double*, double, const double*, size_t);
+    using FunctionKernel = void (*)(double*, const double*, size_t);
+    using IntPowerKernel = void (*)(double*, const double*, unsigned, size_t);
+    using FusedKernel = void (*)(double*, const double*, const double*, const double*, size_t);
+    using PolynomialKernel = void (*)(double*, const double*, const double*, size_t);
+    using PairKernel = void (*)(double*, double*, const double*, size_t);
+
+    struct KernelTable {
+
+        const char*     szName;
+
+        // indexed by MathLexeme::MathLexBiItem
+        MemMemKernel    MemMem[5];
+        MemConstKernel  MemConst[5];
+        ConstMemKernel  ConstMem[5];
+        IntPowerKernel  PowerMemInt;
+        PolynomialKernel Polynomial;
+
+        // indexed by CompiledCommand::OpCodes - MultiplyAddMemMemMem
+        FusedKernel     Fused[10];
+
+        // the built-in functions having exact vector instructions
+        FunctionKernel  Sqrt;
+        FunctionKernel  Abs;
+        FunctionKernel  Floor;
+
+        // fast math: approximations of exp, ln, lg, sin, cos, tan and of the
+        // pair sin, cos (MathLexeme::arraysincos), which may differ in the last bits
+        FunctionKernel  Exp;
+        FunctionKernel  Ln;
+        FunctionKernel  Lg;
+        FunctionKernel  Sin;
+        FunctionKernel  Cos;
+        FunctionKernel  Tan;
+        PairKernel      SinCos;
+
+        // true if none of iRows elements is inf or NaN
+        bool            (*AllFinite)(const double*, size_t);
+    };
+
+    // The best kernels supported by the CPU and the OS, picked at the first call
+    //
+    static const KernelTable& Selected();
+
+    static const KernelTable& Select();
+
+    static const KernelTable ScalarKernels;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#define MATH_KERNELS_X86
+
+    static const KernelTable SSE2Kernels;
+    static const KernelTable AVX2Kernels;
+    static const KernelTable AVX512Kernels;
+
+#endif //x86
+};
+
+inline const MathKernels::KernelTable& MathKernels::Selected()
+{
+    static const KernelTable& Kernels{ Select() };
+    return Kernels;
+}
@@ -0,0 +1,531 @@
+//
+// Kernels for one instruction set, included by mp_simd.cpp once per instruction set.
+//
+// Before inclusion, the following should be defined:
+//     MATH_KERNELS_NAMESPACE   - namespace containing struct Vec, the wrapper of
+//                                the instruction set's intrinsics
+//     MATH_KERNELS_TABLE       - name of the MathKernels::KernelTable member
+//     MATH_KERNELS_NAME        - name of the instruction set (for diagnostics)
+//
+
+namespace MATH_KERNELS_NAMESPACE {
+
+    struct Plus {
+        static Vec::V Apply(Vec::V x, Vec::V y) { return Vec::Add(x, y); }
+        static double Apply1(double x, double y) { return x + y; }
+    };
+
+    struct Minus {
+        static Vec::V Apply(Vec::V x, Vec::V y) { return Vec::Sub(x, y); }
+        static double Apply1(double x, double y) { return x - y; }
+    };
+
+    struct Multiply {
+        static Vec::V Apply(Vec::V x, Vec::V y) { return Vec::Mul(x, y); }
+        static double Apply1(double x, double y) { return x * y; }
+    };
+
+    struct Divide {
+        static Vec::V Apply(Vec::V x, Vec::V y) { return Vec::Div(x, y); }
+        static double Apply1(double x, double y) { return x / y; }
+    };
+
+    template<typename Op>
+    void MemMem(double* pResult, const double* pOp1, const double* pOp2, size_t iRows)
+    {
+        size_t it{ 0 };
+
+        for (; it + Vec::Width <= iRows; it += Vec::Width)
+            Vec::Store(pResult + it, Op::Apply(Vec::Load(pOp1 + it), Vec::Load(pOp2 + it)));
+
+        for (; it < iRows; ++it)
+            pResult[it] = Op::Apply1(pOp1[it], pOp2[it]);
+    }
+
+    template<typename Op>
+    void MemConst(double* pResult, const double* pOp1, double dOp2, size_t iRows)
+    {
+        const auto vOp2{ Vec::Set(dOp2) };
+        size_t it{ 0 };
+
+        for (; it + Vec::Width <= iRows; it += Vec::Width)
+            Vec::Store(pResult + it, Op::Apply(Vec::Load(pOp1 + it), vOp2));
+
+        for (; it < iRows; ++it)
+            pResult[it] = Op::Apply1(pOp1[it], dOp2);
+    }
+
+    template<typename Op>
+    void ConstMem(double* pResult, double dOp1, const double* pOp2, size_t iRows)
+    {
+        const auto vOp1{ Vec::Set(dOp1) };
+        size_t it{ 0 };
+
+        for (; it + Vec::Width <= iRows; it += Vec::Width)
+            Vec::Store(pResult + it, Op::Apply(vOp1, Vec::Load(pOp2 + it)));
+
+        for (; it < iRows; ++it)
+            pResult[it] = Op::Apply1(dOp1, pOp2[it]);
+    }
+
+    // There are no vector instructions for pow, use the library function
+    // through MathLexeme::mypow
+
+    void PowerMemMem(double* pResult, const double* pOp1, const double* pOp2, size_t iRows)
+    {
+        for (size_t it = 0; it < iRows; ++it) pResult[it] = MathLexeme::mypow(pOp1[it], pOp2[it]);
+    }
+
+    void PowerMemConst(double* pResult, const double* pOp1, double dOp2, size_t iRows)
+    {
+        for (size_t it = 0; it < iRows; ++it) pResult[it] = MathLexeme::mypow(pOp1[it], dOp2);
+    }
+
+    void PowerConstMem(double* pResult, double dOp1, const double* pOp2, size_t iRows)
+    {
+        for (size_t it = 0; it < iRows; ++it) pResult[it] = MathLexeme::mypow(dOp1, pOp2[it]);
+    }
+
+    // The multiplications of MathLexeme::myintpow in the same order,
+    // so that the results are the same
+
+    template<typename T, T (*Mul)(T, T)>
+    T IntPower(T x, unsigned iPower)
+    {
+        for (; iPower % 2 == 0; iPower /= 2) x = Mul(x, x);
+
+        auto Result{ x };
+
+        while (iPower /= 2)
+        {
+            x = Mul(x, x);
+            if (iPower % 2) Result = Mul(Result, x);
+        }
+
+        return Result;
+    }
+
+    void PowerMemInt(double* pResult, const double* pOp1, unsigned iPower, size_t iRows)
+    {
+        size_t it{ 0 };
+
+        for (; it + Vec::Width <= iRows; it += Vec::Width)
+            Vec::Store(pResult + it,
+                IntPower<Vec::V, Multiply::Apply>(Vec::Load(pOp1 + it), iPower));
+
+        for (; it < iRows; ++it)
+            pResult[it] = IntPower<double, Multiply::Apply1>(pOp1[it], iPower);
+    }
+
+    // The operations of MathLexeme::mypolynomial, on Vec::Width rows at a time
+
+    void Polynomial(double* pResult, const double* pOp1, const double* pTable, size_t iRows)
+    {
+        const auto iDegree{ static_cast<size_t>(pTable[0]) };
+        size_t it{ 0 };
+
+        for (; it + Vec::Width <= iRows; it += Vec::Width)
+        {
+            const auto x{ Vec::Load(pOp1 + it) };
+            auto vResult{ Vec::Set(pTable[1]) };
+
+            for (size_t iPower = 1; iPower <= iDegree; ++iPower)
+                vResult = Vec::Add(Vec::Mul(vResult, x), Vec::Set(pTable[iPower + 1]));
+
+            Vec::Store(pResult + it, vResult);
+        }
+
+        for (; it < iRows; ++it)
+            pResult[it] = MathLexeme::mypolynomial(pOp1[it], pTable);
+    }
+
+    // Superinstructions: x * y + z, the same rounded once, and (x + y) * z
+
+    struct MultiplyAdd {
+        static Vec::V Apply(Vec::V x, Vec::V y, Vec::V z) { return Vec::Add(Vec::Mul(x, y), z); }
+        static double Apply1(double x, double y, double z) { return x * y + z; }
+    };
+
+    struct FusedMultiplyAdd {
+        static Vec::V Apply(Vec::V x, Vec::V y, Vec::V z) { return Vec::Fma(x, y, z); }
+        static double Apply1(double x, double y, double z) { return fma(x, y, z); }
+    };
+
+    struct PlusMultiply {
+        static Vec::V Apply(Vec::V x, Vec::V y, Vec::V z) { return Vec::Mul(Vec::Add(x, y), z); }
+        static double Apply1(double x, double y, double z) { return (x + y) * z; }
+    };
+
+    // The second and the third operands are columns if fMem2/fMem3,
+    // otherwise they point to a constant
+
+    template<typename Op, bool fMem2, bool fMem3>
+    void Fused(double* pResult, const double* pOp1, const double* pOp2, const double* pOp3, size_t iRows)
+    {
+        const auto vOp2{ Vec::Set(*pOp2) }, vOp3{ Vec::Set(*pOp3) };
+        size_t it{ 0 };
+
+        for (; it + Vec::Width <= iRows; it += Vec::Width)
+            Vec::Store(pResult + it, Op::Apply(Vec::Load(pOp1 + it),
+                fMem2 ? Vec::Load(pOp2 + it) : vOp2, fMem3 ? Vec::Load(pOp3 + it) : vOp3));
+
+        for (; it < iRows; ++it)
+            pResult[it] = Op::Apply1(pOp1[it], fMem2 ? pOp2[it] : *pOp2, fMem3 ? pOp3[it] : *pOp3);
+    }
+
+    struct Sqrt {
+        static Vec::V Apply(Vec::V x) { return Vec::Sqrt(x); }
+        static double Apply1(double x) { return sqrt(x); }
+    };
+
+    struct Abs {
+        static Vec::V Apply(Vec::V x) { return Vec::Abs(x); }
+        static double Apply1(double x) { return fabs(x); }
+    };
+
+    struct Floor {
+        static Vec::V Apply(Vec::V x) { return Vec::Floor(x); }
+        static double Apply1(double x) { return floor(x); }
+    };
+
+    template<typename Function>
+    void Mem(double* pResult, const double* pOp1, size_t iRows)
+    {
+        size_t it{ 0 };
+
+        for (; it + Vec::Width <= iRows; it += Vec::Width)
+            Vec::Store(pResult + it, Function::Apply(Vec::Load(pOp1 + it)));
+
+        for (; it < iRows; ++it)
+            pResult[it] = Function::Apply1(pOp1[it]);
+    }
+
+    // Fast math: exp, ln, lg, sin, cos and tan by the algorithms of fdlibm,
+    // within a few ulp of the C runtime. A kernel computes a row by the same
+    // operations whatever the instruction set and the place of the row in the
+    // block, so the values do not depend on them. Out of (dMin, dMax), i.e. for
+    // an infinity, a NaN, a subnormal or a huge argument, the C runtime does it
+    // (Exact), so that the floating point errors are those of Execute.
+
+    template<typename W>
+    using VecOf = typename W::V;
+
+    // x + shift - shift is x rounded to an integer for |x| < 2 ^ 51,
+    // x + shift holding this integer in its lowest bits
+
+    constexpr double shift{ 6755399441055744.0 }; // 1.5 * 2 ^ 52
+
+    template<typename W, size_t iCoefficients>
+    VecOf<W> Horner(VecOf<W> x, const double (&rgdCoefficients)[iCoefficients])
+    {
+        auto vResult{ W::Set(rgdCoefficients[0]) };
+
+        for (size_t it = 1; it < iCoefficients; ++it)
+            vResult = W::Add(W::Mul(vResult, x), W::Set(rgdCoefficients[it]));
+
+        return vResult;
+    }
+
+    // e ^ x for |x| < 708: x = k * ln 2 + r, |r| <= ln 2 / 2, and
+    // e ^ r = 1 + 2 * r / (2 - R(r)), R being a rational approximation
+
+    template<typename W>
+    VecOf<W> ExpOf(VecOf<W> x)
+    {
+        constexpr double rgdP[]{ 4.13813679705723846039e-08, -1.65339022054652515390e-06,
+            6.61375632143793436117e-05, -2.77777777770155933842e-03, 1.66666666666666019037e-01 };
+
+        const auto k{ W::Sub(W::Add(W::Mul(x, W::Set(1.44269504088896338700e+00)), W::Set(shift)), W::Set(shift)) };
+        const auto hi{ W::Sub(x, W::Mul(k, W::Set(6.93147180369123816490e-01))) };
+        const auto lo{ W::Mul(k, W::Set(1.90821492927058770002e-10)) };
+        const auto r{ W::Sub(hi, lo) }, t{ W::Mul(r, r) };
+        const auto c{ W::Sub(r, W::Mul(t, Horner<W>(t, rgdP))) };
+        const auto y{ W::Sub(W::Set(1.0), W::Sub(W::Sub(lo,
+            W::Div(W::Mul(r, c), W::Sub(W::Set(2.0), c))), hi)) };
+
+        // 2 ^ k, from the exponent k + 1023 in the lowest bits of k + shift + 1023
+
+        return W::Mul(y, W::ShiftLeft(W::Add(k, W::Set(shift + 1023)), 52));
+    }
+
+    // ln x for a normal positive x: x = 2 ^ k * (1 + f), sqrt(2) / 2 <= 1 + f < sqrt(2),
+    // and ln(1 + f) = f - hfsq + s * (hfsq + R(s)), s = f / (2 + f), hfsq = f * f / 2
+
+    template<typename W>
+    struct Logarithm {
+
+        VecOf<W> k, f, hfsq, sR;
+
+        explicit Logarithm(VecOf<W> x)
+        {
+            constexpr double rgdOdd[]{ 1.479819860511658591e-01, 1.818357216161805012e-01,
+                2.857142874366239149e-01, 6.666666666666735130e-01 };
+            constexpr double rgdEven[]{ 1.531383769920937332e-01, 2.222219843214978396e-01,
+                3.999999999940941908e-01 };
+
+            // the bits of x minus those of sqrt(2) / 2 hold k in the 12 highest;
+            // flipping the sign bit makes k + 2048 of them, a positive integer
+
+            const auto tmp{ W::SubBits(x, W::SetBits(0x3FE6A09E00000000)) };
+            const auto iBiased{ W::ShiftRight(W::Xor(tmp, W::SetBits(0x8000000000000000)), 52) };
+
+            k = W::Sub(W::Or(iBiased, W::SetBits(0x4330000000000000)), W::Set(4503599627370496.0 + 2048));
+            f = W::Sub(W::SubBits(x, W::And(tmp, W::SetBits(0xFFF0000000000000))), W::Set(1.0));
+
+            const auto s{ W::Div(f, W::Add(W::Set(2.0), f)) };
+            const auto z{ W::Mul(s, s) }, w{ W::Mul(z, z) };
+            const auto R{ W::Add(W::Mul(z, Horner<W>(w, rgdOdd)), W::Mul(w, Horner<W>(w, rgdEven))) };
+
+            hfsq = W::Mul(W::Set(0.5), W::Mul(f, f));
+            sR = W::Mul(s, W::Add(hfsq, R));
+        }
+
+        VecOf<W> Ln() const
+        {
+            return W::Sub(W::Mul(k, W::Set(6.93147180369123816490e-01)), W::Sub(W::Sub(hfsq,
+                W::Add(sR, W::Mul(k, W::Set(1.90821492927058770002e-10)))), f));
+        }
+
+        VecOf<W> Lg() const
+        {
+            const auto LnOfMantissa{ W::Sub(f, W::Sub(hfsq, sR)) };
+
+            return W::Add(W::Mul(k, W::Set(3.01029995663611771306e-01)),
+                W::Add(W::Mul(k, W::Set(3.69423907715893078616e-13)),
+                    W::Mul(LnOfMantissa, W::Set(4.34294481903251816668e-01))));
+        }
+    };
+
+    // sin x and cos x for |x| < 65536: x = n * pi / 2 + r, |r| <= pi / 4, pi / 2
+    // being split in 4 parts such that n times any of them is exact. Then
+    // the polynomials of sin r and cos r, and the quadrant n mod 4.
+
+    template<typename W>
+    void SinCosOf(VecOf<W> x, VecOf<W>& vSin, VecOf<W>& vCos)
+    {
+        constexpr double rgdSin[]{ 1.58969099521155010221e-10, -2.50507602534068634195e-08,
+            2.75573137070700676789e-06, -1.98412698298579493134e-04, 8.33333333332248946124e-03,
+            -1.66666666666666324348e-01 };
+        constexpr double rgdCos[]{ -1.13596475577881948265e-11, 2.08757232129817482790e-09,
+            -2.75573143513906633035e-07, 2.48015872894767294178e-05, -1.38888888888741095749e-03,
+            4.16666666666666019037e-02 };
+
+        const auto t{ W::Add(W::Mul(x, W::Set(6.36619772367581382433e-01)), W::Set(shift)) };
+        const auto n{ W::Sub(t, W::Set(shift)) };
+
+        auto r{ W::Sub(x, W::Mul(n, W::Set(1.57079632673412561417e+00))) };
+        r = W::Sub(r, W::Mul(n, W::Set(6.07710050630396597660e-11)));
+        r = W::Sub(r, W::Mul(n, W::Set(2.02226624871116645580e-21)));
+        r = W::Sub(r, W::Mul(n, W::Set(8.47842766036889956997e-32)));
+
+        const auto z{ W::Mul(r, r) };
+        const auto Sine{ W::Add(r, W::Mul(W::Mul(z, r), Horner<W>(z, rgdSin))) };
+        const auto hz{ W::Mul(W::Set(0.5), z) }, w{ W::Sub(W::Set(1.0), hz) };
+        const auto Cosine{ W::Add(w, W::Add(W::Sub(W::Sub(W::Set(1.0), w), hz),
+            W::Mul(W::Mul(z, z), Horner<W>(z, rgdCos)))) };
+
+        // odd n swaps the sine and the cosine; sin x is negated for n mod 4 = 2, 3,
+        // cos x for n mod 4 = 1, 2 (bit 1 of n + 1)
+
+        const auto Swap{ W::SubBits(W::SetBits(0), W::And(t, W::SetBits(1))) };
+        const auto Flip{ W::Xor(Sine, Cosine) };
+
+        vSin = W::Xor(W::Xor(Sine, W::And(Flip, Swap)),
+            W::ShiftLeft(W::And(t, W::SetBits(2)), 62));
+        vCos = W::Xor(W::Xor(Cosine, W::And(Flip, Swap)),
+            W::ShiftLeft(W::And(W::Add(t, W::Set(1.0)), W::SetBits(2)), 62));
+    }
+
+    struct ExpFunction {
+        static constexpr double dMin{ -708.0 }, dMax{ 708.0 };
+        template<typename W> static VecOf<W> Apply(VecOf<W> x) { return ExpOf<W>(x); }
+        static double Exact(double x) { return exp(x); }
+    };
+
+    struct LnFunction {
+        static constexpr double dMin{ 2.2250738585072014e-308 }, dMax{ HUGE_VAL };
+        template<typename W> static VecOf<W> Apply(VecOf<W> x) { return Logarithm<W>(x).Ln(); }
+        static double Exact(double x) { return log(x); }
+    };
+
+    struct LgFunction {
+        static constexpr double dMin{ 2.2250738585072014e-308 }, dMax{ HUGE_VAL };
+        template<typename W> static VecOf<W> Apply(VecOf<W> x) { return Logarithm<W>(x).Lg(); }
+        static double Exact(double x) { return log10(x); }
+    };
+
+    struct SinFunction {
+        static constexpr double dMin{ -65536.0 }, dMax{ 65536.0 };
+        template<typename W> static VecOf<W> Apply(VecOf<W> x)
+        {
+            VecOf<W> vSin, vCos;
+            SinCosOf<W>(x, vSin, vCos);
+            return vSin;
+        }
+        static double Exact(double x) { return sin(x); }
+    };
+
+    struct CosFunction {
+        static constexpr double dMin{ -65536.0 }, dMax{ 65536.0 };
+        template<typename W> static VecOf<W> Apply(VecOf<W> x)
+        {
+            VecOf<W> vSin, vCos;
+            SinCosOf<W>(x, vSin, vCos);
+            return vCos;
+        }
+        static double Exact(double x) { return cos(x); }
+    };
+
+    struct TanFunction {
+        static constexpr double dMin{ -65536.0 }, dMax{ 65536.0 };
+        template<typename W> static VecOf<W> Apply(VecOf<W> x)
+        {
+            VecOf<W> vSin, vCos;
+            SinCosOf<W>(x, vSin, vCos);
+            return W::Div(vSin, vCos);
+        }
+        static double Exact(double x) { return tan(x); }
+    };
+
+    template<typename Function>
+    double Approximate1(double x)
+    {
+        return Function::dMin < x && x < Function::dMax ?
+            Function::template Apply<mp_scalar::Vec>(x) : Function::Exact(x);
+    }
+
+    template<typename Function>
+    void Approximate(double* pResult, const double* pOp1, size_t iRows)
+    {
+        const auto vMin{ Vec::Set(Function::dMin) }, vMax{ Vec::Set(Function::dMax) };
+        size_t it{ 0 };
+
+        for (; it + Vec::Width <= iRows; it += Vec::Width)
+        {
+            const auto x{ Vec::Load(pOp1 + it) };
+
+            if (Vec::AllLess(vMin, x) && Vec::AllLess(x, vMax))
+                Vec::Store(pResult + it, Function::template Apply<Vec>(x));
+            else
+                for (size_t iLane = 0; iLane < Vec::Width; ++iLane)
+                    pResult[it + iLane] = Approximate1<Function>(pOp1[it + iLane]);
+        }
+
+        for (; it < iRows; ++it)
+            pResult[it] = Approximate1<Function>(pOp1[it]);
+    }
+
+    // pOp may be the same array as pSin or pCos
+
+    void SinCos1(double* pSin, double* pCos, double x)
+    {
+        if (SinFunction::dMin < x && x < SinFunction::dMax)
+            SinCosOf<mp_scalar::Vec>(x, *pSin, *pCos);
+        else
+        {
+            *pSin = sin(x);
+            *pCos = cos(x);
+        }
+    }
+
+    void SinCos(double* pSin, double* pCos, const double* pOp, size_t iRows)
+    {
+        const auto vMin{ Vec::Set(SinFunction::dMin) }, vMax{ Vec::Set(SinFunction::dMax) };
+        size_t it{ 0 };
+
+        for (; it + Vec::Width <= iRows; it += Vec::Width)
+        {
+            const auto x{ Vec::Load(pOp + it) };
+
+            if (Vec::AllLess(vMin, x) && Vec::AllLess(x, vMax))
+            {
+                Vec::V vSin, vCos;
+                SinCosOf<Vec>(x, vSin, vCos);
+                Vec::Store(pSin + it, vSin);
+                Vec::Store(pCos + it, vCos);
+            }
+            else
+                for (size_t iLane = 0; iLane < Vec::Width; ++iLane)
+                    SinCos1(pSin + it + iLane, pCos + it + iLane, pOp[it + iLane]);
+        }
+
+        for (; it < iRows; ++it)
+            SinCos1(pSin + it, pCos + it, pOp[it]);
+    }
+
+    // x * 0 is 0 for finite x, and NaN for inf or NaN. The sum of such products
+    // is NaN if any element is not finite, which is checked once in the end.
+
+    bool AllFinite(const double* pOp, size_t iRows)
+    {
+        const auto vZero{ Vec::Set(0.0) };
+        auto vSum{ vZero };
+        size_t it{ 0 };
+
+        for (; it + Vec::Width <= iRows; it += Vec::Width)
+            vSum = Vec::Add(vSum, Vec::Mul(Vec::Load(pOp + it), vZero));
+
+        auto dSum{ Vec::Sum(vSum) };
+
+        for (; it < iRows; ++it)
+            dSum += pOp[it] * 0.0;
+
+        return dSum == dSum;
+    }
+
+} // namespace MATH_KERNELS_NAMESPACE
+
+const MathKernels::KernelTable MathKernels::MATH_KERNELS_TABLE
+{
+    MATH_KERNELS_NAME,
+    {
+        MATH_KERNELS_NAMESPACE::MemMem<MATH_KERNELS_NAMESPACE::Plus>,
+        MATH_KERNELS_NAMESPACE::MemMem<MATH_KERNELS_NAMESPACE::Minus>,
+        MATH_KERNELS_NAMESPACE::MemMem<MATH_KERNELS_NAMESPACE::Multiply>,
+        MATH_KERNELS_NAMESPACE::MemMem<MATH_KERNELS_NAMESPACE::Divide>,
+        MATH_KERNELS_NAMESPACE::PowerMemMem
+    },
+    {
+        MATH_KERNELS_NAMESPACE::MemConst<MATH_KERNELS_NAMESPACE::Plus>,
+        MATH_KERNELS_NAMESPACE::MemConst<MATH_KERNELS_NAMESPACE::Minus>,
+        MATH_KERNELS_NAMESPACE::MemConst<MATH_KERNELS_NAMESPACE::Multiply>,
+        MATH_KERNELS_NAMESPACE::MemConst<MATH_KERNELS_NAMESPACE::Divide>,
+        MATH_KERNELS_NAMESPACE::PowerMemConst
+    },
+    {
+        MATH_KERNELS_NAMESPACE::ConstMem<MATH_KERNELS_NAMESPACE::Plus>,
+        MATH_KERNELS_NAMESPACE::ConstMem<MATH_KERNELS_NAMESPACE::Minus>,
+        MATH_KERNELS_NAMESPACE::ConstMem<MATH_KERNELS_NAMESPACE::Multiply>,
+        MATH_KERNELS_NAMESPACE::ConstMem<MATH_KERNELS_NAMESPACE::Divide>,
+        MATH_KERNELS_NAMESPACE::PowerConstMem
+    },
+    MATH_KERNELS_NAMESPACE::PowerMemInt,
+    MATH_KERNELS_NAMESPACE::Polynomial,
+    {
+        MATH_KERNELS_NAMESPACE::Fused<MATH_KERNELS_NAMESPACE::MultiplyAdd, true, true>,
+        MATH_KERNELS_NAMESPACE::Fused<MATH_KERNELS_NAMESPACE::MultiplyAdd, true, false>,
+        MATH_KERNELS_NAMESPACE::Fused<MATH_KERNELS_NAMESPACE::MultiplyAdd, false, true>,
+        MATH_KERNELS_NAMESPACE::Fused<MATH_KERNELS_NAMESPACE::MultiplyAdd, false, false>,
+        MATH_KERNELS_NAMESPACE::Fused<MATH_KERNELS_NAMESPACE::FusedMultiplyAdd, true, true>,
+        MATH_KERNELS_NAMESPACE::Fused<MATH_KERNELS_NAMESPACE::FusedMultiplyAdd, true, false>,
+        MATH_KERNELS_NAMESPACE::Fused<MATH_KERNELS_NAMESPACE::FusedMultiplyAdd, false, true>,
+        MATH_KERNELS_NAMESPACE::Fused<MATH_KERNELS_NAMESPACE::FusedMultiplyAdd, false, false>,
+        MATH_KERNELS_NAMESPACE::Fused<MATH_KERNELS_NAMESPACE::PlusMultiply, true, false>,
+        MATH_KERNELS_NAMESPACE::Fused<MATH_KERNELS_NAMESPACE::PlusMultiply, false, false>
+    },
+    MATH_KERNELS_NAMESPACE::Mem<MATH_KERNELS_NAMESPACE::Sqrt>,
+    MATH_KERNELS_NAMESPACE::Mem<MATH_KERNELS_NAMESPACE::Abs>,
+    MATH_KERNELS_NAMESPACE::Mem<MATH_KERNELS_NAMESPACE::Floor>,
+    MATH_KERNELS_NAMESPACE::Approximate<MATH_KERNELS_NAMESPACE::ExpFunction>,
+    MATH_KERNELS_NAMESPACE::Approximate<MATH_KERNELS_NAMESPACE::LnFunction>,
+    MATH_KERNELS_NAMESPACE::Approximate<MATH_KERNELS_NAMESPACE::LgFunction>,
+    MATH_KERNELS_NAMESPACE::Approximate<MATH_KERNELS_NAMESPACE::SinFunction>,
+    MATH_KERNELS_NAMESPACE::Approximate<MATH_KERNELS_NAMESPACE::CosFunction>,
+    MATH_KERNELS_NAMESPACE::Approximate<MATH_KERNELS_NAMESPACE::TanFunction>,
+    MATH_KERNELS_NAMESPACE::SinCos,
+    MATH_KERNELS_NAMESPACE::AllFinite
+};
+
+#undef MATH_KERNELS_NAMESPACE
+#undef MATH_KERNELS_TABLE
+#undef MATH_KERNELS_NAME
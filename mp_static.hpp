@@ -0,0 +1,546 @@
+//
+// Compilation of math expressions known at build time
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <initializer_list>
+#include <limits>
+#include "mp.hpp"
+#include "mp_number.hpp"
+
+//
+//
+// StaticMathParser compiles a string literal into C++ code while the program
+// itself is being compiled:
+//
+//     static constexpr auto Formula{
+//         StaticMathParser::Compile(L"sin(x1)^2 + cos(x2)^2", { L"x1", L"x2" }) };
+//
+//     err_code = StaticMathParser::Execute<Formula>(err_pos, args.data(), value);
+//
+// Compile follows the grammar of MathParser::Compile, a syntax error or an
+// unknown identifier in the string being a compile error. Execute<Formula>
+// is an expression tree instantiated as inline code, and returns the same
+// results and error codes as MathParser::Execute would (args holds the values
+// of the variables in the order they are listed in Compile).
+//
+// Unlike MathParser::Compile, operations on constants are not evaluated by
+// Compile; the C++ compiler folds them instead, and a floating point error
+// in them is returned by Execute.
+//
+//
+
+class StaticMathParser {
+
+public:
+
+    // Node of an expression tree
+    //
+    struct Node {
+
+        int     iType{};        // MathLexeme::Number, Function or Binary
+        int     iItem{};        // MathLexeme::Constant or Variable,
+                                // index of function, or MathLexeme::MathLexBiItem
+        double  dValue{};       // value of a constant
+        size_t  iVar{};         // index of a variable
+        size_t  iFirstOperand{};// index of the node of the first operand/function argument
+        size_t  iSecondOperand{};
+        size_t  iPosition{};    // position in the string, for error reporting
+    };
+
+    // Expression tree made by Compile (a string of N - 1 characters
+    // results in less than 2 * N + 2 nodes)
+    //
+    template<size_t MaxNodes>
+    struct Program {
+
+        Node    nodes[MaxNodes]{};
+        size_t  iNodes{};
+        size_t  iRoot{};
+    };
+
+    // Compile a string literal. vars are the names of the user-defined variables.
+    // To be evaluated at compile time (used to initialize a constexpr variable),
+    // otherwise errors are thrown as MathParser::ErrorCodes.
+    //
+    template<size_t N>
+    static constexpr Program<2 * N + 2> Compile(
+        const wchar_t (&wstr)[N],
+        std::initializer_list<const wchar_t*> vars = {},
+        bool case_sensitive = true);
+
+    // Execute the expression compiled into Formula, which should be a constexpr
+    // variable with static storage duration. The values of the variables
+    // need supplied in rgdArgs.
+    // On success returns OK and stores the result in dValue.
+    // Otherwise, returns FloatingPointError if this option is enabled.
+    //
+    template<const auto& Formula>
+    static MathParser::ErrorCodes Execute(
+        size_t& iErrorPosition, const double* rgdArgs, double& dValue);
+
+private:
+
+    // Lexeme on the stack of Compile
+    struct Item {
+
+        int     iType{};
+        int     iItem{};
+        size_t  iNode{};
+        size_t  iPosition{};
+    };
+
+    // The first result that is not finite
+    struct Failure {
+
+        bool    fFailed{ false };
+        size_t  iPosition{};
+        double  dValue{};
+    };
+
+    static constexpr void CheckConstant(double);
+
+    static double Check(double dValue, size_t iPosition, Failure& Failed);
+
+    template<const auto& Formula, size_t iNode>
+    static double EvaluateNode(const double* rgdArgs, Failure& Failed);
+};
+
+constexpr void StaticMathParser::CheckConstant(double dValue)
+{
+#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+    if (dValue == std::numeric_limits<double>::infinity())
+        throw MathParser::FloatingPointErrorPosInf;
+
+#else //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+    (void)dValue;
+
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+}
+
+// The lexer and the syntax checks follow MathParser::GetLexCheckSyntax,
+// the rest follows MathParser::Compile, building a tree instead of code
+//
+template<size_t N>
+constexpr StaticMathParser::Program<2 * N + 2> StaticMathParser::Compile(
+    const wchar_t (&wstr)[N], std::initializer_list<const wchar_t*> vars, bool case_sensitive)
+{
+    Program<2 * N + 2> Formula{};
+
+    Item Stack[2 * N + 2]{};
+    size_t iTopOfStack{ 0 };
+
+    auto Push = [&](const Item& It) { Stack[iTopOfStack++] = It; };
+
+    auto AddNode = [&](const Node& Nd)
+    {
+        Formula.nodes[Formula.iNodes] = Nd;
+        return Formula.iNodes++;
+    };
+
+    auto CompileBinaryOp = [&]()
+    {
+        const auto Op2{ Stack[--iTopOfStack] };
+        const auto Sign{ Stack[--iTopOfStack] };
+        const auto Op1{ Stack[--iTopOfStack] };
+
+        Push({ MathLexeme::Number, MathLexeme::Variable, AddNode({ MathLexeme::Binary,
+            Sign.iItem, 0.0, 0, Op1.iNode, Op2.iNode, Sign.iPosition }), Op1.iPosition });
+    };
+
+    const wchar_t* pString{ wstr };
+    size_t iCurrentPosition{ 0 };
+    long long int iParBalance{ 0 };
+    int iPreviousType{ MathLexeme::Begin };
+
+    Push({ MathLexeme::Begin });
+
+    for (; ; )
+    {
+        // skip blanks
+
+        while (pString[iCurrentPosition] == ' ' ||
+            pString[iCurrentPosition] == '\t') ++iCurrentPosition;
+
+        const auto iFirstSymbol{ iCurrentPosition };
+        auto cCurrentChar{ pString[iCurrentPosition] };
+        Item CurrentLexeme{};
+
+        switch (cCurrentChar)
+        {
+
+        // end of line
+
+        case '\0':
+            CurrentLexeme.iType = MathLexeme::End;
+
+            if (iPreviousType == MathLexeme::Begin)
+                Push({ MathLexeme::Number, MathLexeme::Constant,
+                    AddNode({ MathLexeme::Number, MathLexeme::Constant }) });
+            break;
+
+        // signs (assume now they are all binary; check for unary later)
+
+        case '+':
+            CurrentLexeme = { MathLexeme::Binary, MathLexeme::Plus, 0, iFirstSymbol };
+            break;
+
+        case '-':
+            CurrentLexeme = { MathLexeme::Binary, MathLexeme::Minus, 0, iFirstSymbol };
+            break;
+
+        case '*':
+            CurrentLexeme = { MathLexeme::Binary, MathLexeme::Multiply, 0, iFirstSymbol };
+
+#ifdef MATH_PARSER_DOUBLE_ASTERISK_ALLOWED
+
+            if (pString[++iCurrentPosition] == '*')
+                CurrentLexeme.iItem = MathLexeme::Power;
+            else --iCurrentPosition;
+
+#endif //MATH_PARSER_DOUBLE_ASTERISK_ALLOWED
+
+            break;
+
+        case '/':
+
+#ifdef MATH_PARSER_COLON_ALLOWED
+
+        case ':':
+
+#endif //MATH_PARSER_COLON_ALLOWED
+
+            CurrentLexeme = { MathLexeme::Binary, MathLexeme::Divide, 0, iFirstSymbol };
+            break;
+
+        case '^':
+            CurrentLexeme = { MathLexeme::Binary, MathLexeme::Power, 0, iFirstSymbol };
+            break;
+
+        // parentheses
+
+        case '(':
+            CurrentLexeme.iType = MathLexeme::LeftPar;
+            ++iParBalance;
+            break;
+
+        case ')':
+            // check balance
+            if (iParBalance <= 0) throw MathParser::ExtraRightPar;
+
+            CurrentLexeme.iType = MathLexeme::RightPar;
+            --iParBalance;
+            break;
+
+        // possibly number, variable or function
+
+        default:
+            if ((cCurrentChar >= '0' && cCurrentChar <= '9') || cCurrentChar == '.')
+            {
+                // possibly number
+
+                auto fExpFound{ false }, fPointFound{ false }, fSignFound{ false };
+                for (; ; )
+                {
+                    cCurrentChar = pString[iCurrentPosition];
+
+                    if (cCurrentChar >= '0' && cCurrentChar <= '9')
+                        ++iCurrentPosition;
+                    else
+                        if ((cCurrentChar == 'e' || cCurrentChar == 'E') && !fExpFound)
+                        {
+                            ++iCurrentPosition;
+                            fExpFound = true;
+                        }
+                        else
+                            if (cCurrentChar == '.' && !fPointFound)
+                            {
+                                ++iCurrentPosition;
+                                fPointFound = true;
+                            }
+                            else
+                                // +/- belongs to the exponent if right after it
+                                if ((cCurrentChar == '+' || cCurrentChar == '-') && !fSignFound &&
+                                    (pString[iCurrentPosition - 1] == 'e' ||
+                                    pString[iCurrentPosition - 1] == 'E'))
+                                {
+                                    ++iCurrentPosition;
+                                    fSignFound = true;
+                                }
+                                else
+                                {
+                                    --iCurrentPosition;
+                                    break;
+                                }
+                }
+
+                double dValue{};
+
+                if (!DecimalNumber::Read(pString + iFirstSymbol, iCurrentPosition + 1 - iFirstSymbol, dValue))
+                    throw MathParser::InvalidNumber;
+
+                CheckConstant(dValue);
+
+                CurrentLexeme = { MathLexeme::Number, MathLexeme::Constant,
+                    AddNode({ MathLexeme::Number, MathLexeme::Constant, dValue }), iFirstSymbol };
+
+            } // if
+
+            else // not a number, possibly function, constant or variable
+
+                if (MathParser::IsFirstChar(cCurrentChar))
+                {
+                    while (MathParser::IsNextChar(pString[iCurrentPosition])) ++iCurrentPosition;
+                    --iCurrentPosition;
+
+                    const auto (*const pName) { pString + iFirstSymbol };
+                    const auto iLength{ iCurrentPosition + 1 - iFirstSymbol };
+                    auto fFound{ false };
+
+                    // check for matching names (functions, constants, variables)
+
+                    for (size_t it = 0; it < MathLexeme::MathLexNumberOfFunctions && !fFound; ++it)
+                        if (MathLexeme::IsFunctionAllowed[it] &&
+                            MathLexeme::IsNameEqual(pName, iLength, MathLexeme::FunctionID[it], case_sensitive))
+                        {
+                            CurrentLexeme = { MathLexeme::Function, static_cast<int>(it), 0, iFirstSymbol };
+                            fFound = true;
+                        }
+
+                    for (size_t it = 0; it < MathLexeme::MathLexNumberOfConstants && !fFound; ++it)
+                        if (MathLexeme::IsConstantAllowed[it] &&
+                            MathLexeme::IsNameEqual(pName, iLength, MathLexeme::ConstantID[it], case_sensitive))
+                        {
+                            CurrentLexeme = { MathLexeme::Number, MathLexeme::Constant,
+                                AddNode({ MathLexeme::Number, MathLexeme::Constant,
+                                    MathLexeme::ConstantValue[it] }) };
+                            fFound = true;
+                        }
+
+                    size_t iVar{ 0 };
+                    for (auto it = vars.begin(); it != vars.end() && !fFound; ++it, ++iVar)
+                        if (MathLexeme::IsNameEqual(pName, iLength, *it, case_sensitive))
+                        {
+                            CurrentLexeme = { MathLexeme::Number, MathLexeme::Variable,
+                                AddNode({ MathLexeme::Number, MathLexeme::Variable, 0.0, iVar }) };
+                            fFound = true;
+                        }
+
+                    if (!fFound) throw MathParser::UnknownIdentifier; // no matches
+
+                } // if IsFirstChar
+
+                else // invalid character
+                    throw MathParser::InvalidCharacter;
+
+        } // switch (cCurrentChar)
+
+        ++iCurrentPosition;
+
+        // got a lexeme, now check syntax
+
+        // Check if a binary sign is actually unary
+
+        if (CurrentLexeme.iType == MathLexeme::Binary)
+            if (CurrentLexeme.iItem == MathLexeme::Plus ||
+                CurrentLexeme.iItem == MathLexeme::Minus)
+                if (MathParser::Expected[iPreviousType][MathLexeme::Unary])
+                    CurrentLexeme.iType = MathLexeme::Unary;
+
+        // Check syntax
+
+        if (!MathParser::Expected[iPreviousType][CurrentLexeme.iType])
+            switch (iPreviousType)
+            {
+            case MathLexeme::Begin:
+
+#ifndef MATH_PARSER_EMPTY_STRING_ALLOWED
+
+                if (CurrentLexeme.iType == MathLexeme::End)
+                    throw MathParser::EmptyString;
+                else
+
+#endif //MATH_PARSER_EMPTY_STRING_ALLOWED
+
+                    throw MathParser::ExpectedRealFunUnSignLeftPar;
+
+            case MathLexeme::LeftPar:
+                throw MathParser::ExpectedRealFunUnSignLeftPar;
+
+            case MathLexeme::Unary:
+            case MathLexeme::Binary:
+                throw MathParser::ExpectedRealFunLeftPar;
+
+            case MathLexeme::Number:
+            case MathLexeme::RightPar:
+                if (CurrentLexeme.iType == MathLexeme::LeftPar)
+                    throw iParBalance > 1 ?
+                        MathParser::ExpectedBiSignRightPar : MathParser::ExpectedBiSign;
+                else
+                    throw iParBalance > 0 ?
+                        MathParser::ExpectedBiSignRightPar : MathParser::ExpectedBiSign;
+
+            default:
+                // case MathLexeme::Function:
+                throw MathParser::ExpectedLeftPar;
+            }
+
+        // Check if there've been enough right parentheses
+
+        if (CurrentLexeme.iType == MathLexeme::End)
+            if (iParBalance > 0) throw MathParser::ExpectedRightPar;
+
+        // Now compile
+
+        switch (CurrentLexeme.iType)
+        {
+        case MathLexeme::Number:
+        case MathLexeme::LeftPar:
+        case MathLexeme::Function:
+            Push(CurrentLexeme);
+            break;
+
+        case MathLexeme::Binary:
+            // unwind stack
+            while (Stack[iTopOfStack - 2].iType == MathLexeme::Binary &&
+                MathLexeme::IsPriorityHigher[Stack[iTopOfStack - 2].iItem][CurrentLexeme.iItem])
+                CompileBinaryOp();
+
+            Push(CurrentLexeme);
+            break;
+
+        case MathLexeme::RightPar:
+        {
+            while (Stack[iTopOfStack - 2].iType == MathLexeme::Binary) CompileBinaryOp();
+
+            auto Tmp{ Stack[--iTopOfStack] };
+            --iTopOfStack; // remove '('
+
+            if (Stack[iTopOfStack - 1].iType == MathLexeme::Function)
+            {
+                const auto Function{ Stack[--iTopOfStack] };
+
+                Tmp.iNode = AddNode({ MathLexeme::Function, Function.iItem,
+                    0.0, 0, Tmp.iNode, 0, Function.iPosition });
+            }
+
+            Push(Tmp);
+        }
+            break;
+
+        case MathLexeme::End:
+            while (Stack[iTopOfStack - 2].iType == MathLexeme::Binary) CompileBinaryOp();
+            break;
+
+        default:
+            // case MathLexeme::Unary:
+            if (CurrentLexeme.iItem == MathLexeme::Minus)
+            {
+                Push({ MathLexeme::Number, MathLexeme::Constant,
+                    AddNode({ MathLexeme::Number, MathLexeme::Constant }) });
+                Push({ MathLexeme::Binary, MathLexeme::Minus });
+            }
+
+        } // switch
+
+        iPreviousType = CurrentLexeme.iType;
+
+        if (CurrentLexeme.iType == MathLexeme::End) break;
+    }
+
+    Formula.iRoot = Stack[iTopOfStack - 1].iNode;
+    return Formula;
+}
+
+inline double StaticMathParser::Check(double dValue, size_t iPosition, Failure& Failed)
+{
+#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+    if (!isfinite(dValue) && !Failed.fFailed)
+        Failed = { true, iPosition, dValue };
+
+#else //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+    (void)iPosition;
+    (void)Failed;
+
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+    return dValue;
+}
+
+// The operands are evaluated in the order of the commands MathParser::Compile
+// would emit, so the first result that is not finite is the same as Execute's
+//
+template<const auto& Formula, size_t iNode>
+inline double StaticMathParser::EvaluateNode(const double* rgdArgs, Failure& Failed)
+{
+    constexpr auto& Nd{ Formula.nodes[iNode] };
+
+    if constexpr (Nd.iType == MathLexeme::Number)
+    {
+        if constexpr (Nd.iItem == MathLexeme::Constant)
+            return Nd.dValue;
+        else
+            return rgdArgs[Nd.iVar];
+    }
+    else if constexpr (Nd.iType == MathLexeme::Function)
+    {
+        const auto dArg{ EvaluateNode<Formula, Nd.iFirstOperand>(rgdArgs, Failed) };
+
+        return Check(MathLexeme::FunctionAddress[Nd.iItem](dArg), Nd.iPosition, Failed);
+    }
+    else
+    {
+        const auto dOp1{ EvaluateNode<Formula, Nd.iFirstOperand>(rgdArgs, Failed) };
+        const auto dOp2{ EvaluateNode<Formula, Nd.iSecondOperand>(rgdArgs, Failed) };
+
+        if constexpr (Nd.iItem == MathLexeme::Plus)
+            return Check(dOp1 + dOp2, Nd.iPosition, Failed);
+        else if constexpr (Nd.iItem == MathLexeme::Minus)
+            return Check(dOp1 - dOp2, Nd.iPosition, Failed);
+        else if constexpr (Nd.iItem == MathLexeme::Multiply)
+            return Check(dOp1 * dOp2, Nd.iPosition, Failed);
+        else if constexpr (Nd.iItem == MathLexeme::Divide)
+            return Check(dOp1 / dOp2, Nd.iPosition, Failed);
+        else
+            return Check(MathLexeme::mypow(dOp1, dOp2), Nd.iPosition, Failed);
+    }
+}
+
+template<const auto& Formula>
+inline MathParser::ErrorCodes StaticMathParser::Execute(
+    size_t& iErrorPosition, const double* rgdArgs, double& dValue)
+{
+    Failure Failed;
+    dValue = EvaluateNode<Formula, Formula.iRoot>(rgdArgs, Failed);
+
+#ifdef MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+    if (Failed.fFailed)
+    {
+        iErrorPosition = Failed.iPosition;
+
+        if (isnan(Failed.dValue))
+            return MathParser::FloatingPointErrorNaN;
+        else
+            if (Failed.dValue > 0)
+                return MathParser::FloatingPointErrorPosInf;
+            else
+                return MathParser::FloatingPointErrorNegInf;
+    }
+
+#else //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+    (void)iErrorPosition;
+
+#endif //MATH_PARSER_CHECK_FOR_FLOATING_POINT_ERRORS
+
+    return MathParser::OK;
+}